@@ -49,3 +49,7 @@ else()
     )
   endif()
 endif()
+
+if(RAPIDJSON_SIMD AND "${CMAKE_SYSTEM_PROCESSOR}" MATCHES "^(x86_64|AMD64|i.86)$")
+  target_compile_definitions(RapidJSON INTERFACE RAPIDJSON_SSE2)
+endif()
@@ -46,4 +46,26 @@ auto get_x_string_fts_multi_ex = [](int feature_size, size_t actions, bool share
     ss << std::endl;
   }
   return ss.str();
-};
\ No newline at end of file
+};
+// One decision service event of a contextual bandit with shared features, actions and ignored metadata.
+auto get_dsjson_cb_event = [](int feature_size, size_t actions) {
+  std::stringstream ss;
+  ss << R"({"_label_cost":-1,"_label_probability":0.25,"_label_Action":1,"_labelIndex":0,"o":[{"v":1,"EventId":"x"}],)";
+  ss << R"("Timestamp":"2021-04-01T12:00:00.0000000Z","Version":"1","EventId":"0074434d3a3a46529f65de8a59631939",)";
+  ss << R"("a":[)";
+  for (size_t i = 0; i < actions; i++) { ss << (i == 0 ? "" : ",") << i + 1; }
+  ss << R"(],"c":{"shared":{)";
+  for (size_t j = 0; j < feature_size; j++) { ss << (j == 0 ? "" : ",") << "\"s" << j << "\":" << j; }
+  ss << R"(},"_multi":[)";
+  for (size_t i = 0; i < actions; i++)
+  {
+    ss << (i == 0 ? "" : ",") << R"({"action":{)";
+    for (size_t j = 0; j < feature_size; j++)
+    { ss << (j == 0 ? "" : ",") << "\"a" << j << "\":\"" << i << "_" << j << "\""; }
+    ss << "}}";
+  }
+  ss << R"(]},"p":[)";
+  for (size_t i = 0; i < actions; i++) { ss << (i == 0 ? "" : ",") << 1.f / actions; }
+  ss << R"(],"VWState":{"m":"3a56bc7d1bde4ae89b0fdaa4d3c8c8ea/c4cc5c4b"},"_original_label_cost":-1})";
+  return ss.str();
+};
@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "example.h"
+#include "v_array.h"
+#include "object_pool.h"
+#include "queue.h"
+
+// Measures how many examples per second can travel from a parse thread to a learner thread and back to the pool,
+// without any parsing or learning, for a given ring size.
+static void bench_example_handoff(benchmark::State& state)
+{
+  const auto ring_size = static_cast<size_t>(state.range(0));
+  constexpr size_t examples_per_iteration = 100000;
+
+  VW::object_pool<example> pool{ring_size};
+  for (auto _ : state)
+  {
+    VW::ptr_queue<example> queue{ring_size};
+    std::thread parse_thread([&pool, &queue]() {
+      for (size_t i = 0; i < examples_per_iteration; i++) { queue.push(pool.get_object()); }
+      queue.set_done();
+    });
+
+    example* ex;
+    while ((ex = queue.pop()) != nullptr)
+    {
+      benchmark::DoNotOptimize(ex);
+      pool.return_object(ex);
+    }
+    parse_thread.join();
+  }
+  state.SetItemsProcessed(state.iterations() * examples_per_iteration);
+}
+
+BENCHMARK(bench_example_handoff)->Arg(16)->Arg(256)->Arg(4096)->UseRealTime();
+
+// Same as above, with examples handed over in batches as the parse thread does.
+static void bench_example_batch_handoff(benchmark::State& state)
+{
+  const auto batch_size = static_cast<size_t>(state.range(0));
+  constexpr size_t ring_size = 4096;
+  constexpr size_t examples_per_iteration = 100000;
+
+  VW::object_pool<example> pool{ring_size};
+  VW::object_pool<v_array<example*>> batch_pool{8};
+  for (auto _ : state)
+  {
+    VW::ptr_queue<v_array<example*>> queue{std::max(static_cast<size_t>(2), ring_size / batch_size)};
+    std::thread parse_thread([&pool, &batch_pool, &queue, batch_size]() {
+      v_array<example*>* batch = nullptr;
+      for (size_t i = 0; i < examples_per_iteration; i++)
+      {
+        if (batch == nullptr) { batch = batch_pool.get_object(); }
+        batch->push_back(pool.get_object());
+        if (batch->size() == batch_size)
+        {
+          queue.push(batch);
+          batch = nullptr;
+        }
+      }
+      if (batch != nullptr) { queue.push(batch); }
+      queue.set_done();
+    });
+
+    v_array<example*>* batch;
+    while ((batch = queue.pop()) != nullptr)
+    {
+      for (auto* ex : *batch)
+      {
+        benchmark::DoNotOptimize(ex);
+        pool.return_object(ex);
+      }
+      batch->clear();
+      batch_pool.return_object(batch);
+    }
+    parse_thread.join();
+  }
+  state.SetItemsProcessed(state.iterations() * examples_per_iteration);
+}
+
+BENCHMARK(bench_example_batch_handoff)->Arg(1)->Arg(64)->Arg(256)->Arg(1024)->UseRealTime();
@@ -11,6 +11,7 @@
 #include <unordered_map>
 
 #include "cache.h"
+#include "parse_example_json.h"
 #include "parser.h"
 #include "io/io_adapter.h"
 #include "vw.h"
@@ -128,6 +129,31 @@ static void benchmark_example_reuse(benchmark::State& state)
   }
 }
 
+template <class... ExtraArgs>
+static void bench_dsjson_parse(benchmark::State& state, ExtraArgs&&... extra_args)
+{
+  std::string res[sizeof...(extra_args)] = {extra_args...};
+  auto event = res[0];
+
+  auto vw = VW::initialize("--cb_explore_adf --dsjson --quiet --no_stdin");
+  v_array<example*> examples;
+  // Parsing is destructive, every iteration parses a fresh copy.
+  std::vector<char> line;
+
+  for (auto _ : state)
+  {
+    line.assign(event.begin(), event.end());
+    line.push_back('\0');
+    examples.push_back(&VW::get_unused_example(vw));
+    DecisionServiceInteraction interaction;
+    VW::read_line_decision_service_json<false>(*vw, examples, line.data(), event.size(), false,
+        reinterpret_cast<VW::example_factory_t>(&VW::get_unused_example), vw, &interaction);
+    VW::return_multiple_example(*vw, examples);
+    benchmark::ClobberMemory();
+  }
+  VW::finish(*vw);
+}
+
 BENCHMARK_CAPTURE(bench_cache_io_buf, 120_string_fts, get_x_string_fts(120));
 BENCHMARK_CAPTURE(bench_text_io_buf, 120_string_fts, get_x_string_fts(120));
 
@@ -135,3 +161,6 @@ BENCHMARK_CAPTURE(bench_cache_io_buf, 120_num_fts, get_x_numerical_fts(120));
 BENCHMARK_CAPTURE(bench_text_io_buf, 120_num_fts, get_x_numerical_fts(120));
 
 BENCHMARK(benchmark_example_reuse);
+
+BENCHMARK_CAPTURE(bench_dsjson_parse, 2_actions_10_fts, get_dsjson_cb_event(10, 2));
+BENCHMARK_CAPTURE(bench_dsjson_parse, 8_actions_20_fts, get_dsjson_cb_event(20, 8));
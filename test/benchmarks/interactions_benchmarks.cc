@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include "array_parameters_dense.h"
+#include "example_predict.h"
+#include "gd_predict.h"
+#include "interactions_simd.h"
+
+namespace
+{
+constexpr uint32_t stride_shift = 2;
+
+void fill_namespace(example_predict& ex, namespace_index ns, size_t num_features, std::mt19937_64& rng)
+{
+  std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+  ex.indices.push_back(ns);
+  for (size_t i = 0; i < num_features; i++) { ex.feature_space[ns].push_back(uniform(rng), rng() << stride_shift); }
+}
+}  // namespace
+
+// Predicts with a single quadratic interaction of two namespaces of state.range(0) features each, with the
+// interactions running the kernels of the given instruction set. The weights have 2^state.range(1) entries, so that
+// the small tables stay in cache and the large ones measure the memory instead, and are prefetched state.range(2)
+// features ahead.
+static void bench_quadratic_predict(benchmark::State& state, INTERACTIONS::simd_level level)
+{
+  if (INTERACTIONS::detect_simd_level() < level)
+  {
+    state.SkipWithError("Not supported by this CPU");
+    return;
+  }
+  const auto num_features = static_cast<size_t>(state.range(0));
+  const auto num_bits = static_cast<size_t>(state.range(1));
+
+  std::mt19937_64 rng(7);
+  std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+  dense_parameters weights(static_cast<size_t>(1) << num_bits, stride_shift);
+  for (auto iter = weights.begin(); iter != weights.end(); ++iter) { *iter = uniform(rng); }
+  weights.prefetch_distance(static_cast<size_t>(state.range(2)));
+
+  example_predict ex;
+  fill_namespace(ex, 'a', num_features, rng);
+  fill_namespace(ex, 'b', num_features, rng);
+  const std::vector<std::vector<namespace_index>> interactions = {{'a', 'b'}};
+  std::array<bool, NUM_NAMESPACES> ignore_linear;
+  ignore_linear.fill(false);
+
+  INTERACTIONS::set_simd_level(level);
+  for (auto _ : state)
+  { benchmark::DoNotOptimize(GD::inline_predict(weights, false, ignore_linear, interactions, false, ex)); }
+  INTERACTIONS::set_simd_level(INTERACTIONS::detect_simd_level());
+  state.SetItemsProcessed(state.iterations() * num_features * num_features);
+}
+
+// The plain sgd update of the same interaction, one kernel call per feature of the first namespace as
+// generate_interactions does it.
+static void bench_quadratic_sgd_update(benchmark::State& state, INTERACTIONS::simd_level level)
+{
+  if (INTERACTIONS::detect_simd_level() < level)
+  {
+    state.SkipWithError("Not supported by this CPU");
+    return;
+  }
+  const auto num_features = static_cast<size_t>(state.range(0));
+  const auto num_bits = static_cast<size_t>(state.range(1));
+
+  std::mt19937_64 rng(7);
+  dense_parameters weights(static_cast<size_t>(1) << num_bits, stride_shift);
+  example_predict ex;
+  fill_namespace(ex, 'a', num_features, rng);
+  fill_namespace(ex, 'b', num_features, rng);
+  const features& first = ex.feature_space['a'];
+  const features& second = ex.feature_space['b'];
+
+  const auto& kernels = INTERACTIONS::kernels_for(level);
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < first.size(); i++)
+    {
+      kernels.add(weights.first(), weights.mask(), second.indicies.begin(), second.values.begin(), second.size(),
+          FNV_prime * first.indicies[i], 0, first.values[i], 1e-6f, 0);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * num_features * num_features);
+}
+
+BENCHMARK_CAPTURE(bench_quadratic_predict, scalar, INTERACTIONS::simd_level::scalar)
+    ->Args({16, 12, 0})
+    ->Args({200, 12, 0})
+    ->Args({200, 18, 0})
+    ->Args({200, 24, 0})
+    ->Args({200, 24, 8})
+    ->Args({200, 24, 32});
+BENCHMARK_CAPTURE(bench_quadratic_predict, avx2, INTERACTIONS::simd_level::avx2)
+    ->Args({16, 12, 0})
+    ->Args({200, 12, 0})
+    ->Args({200, 18, 0})
+    ->Args({200, 24, 0})
+    ->Args({200, 24, 8})
+    ->Args({200, 24, 32});
+BENCHMARK_CAPTURE(bench_quadratic_predict, avx512, INTERACTIONS::simd_level::avx512)
+    ->Args({16, 12, 0})
+    ->Args({200, 12, 0})
+    ->Args({200, 18, 0})
+    ->Args({200, 24, 0})
+    ->Args({200, 24, 8})
+    ->Args({200, 24, 32});
+
+BENCHMARK_CAPTURE(bench_quadratic_sgd_update, scalar, INTERACTIONS::simd_level::scalar)
+    ->Args({200, 12})
+    ->Args({200, 24});
+BENCHMARK_CAPTURE(bench_quadratic_sgd_update, avx2, INTERACTIONS::simd_level::avx2)
+    ->Args({200, 12})
+    ->Args({200, 24});
+BENCHMARK_CAPTURE(bench_quadratic_sgd_update, avx512, INTERACTIONS::simd_level::avx512)
+    ->Args({200, 12})
+    ->Args({200, 24});
@@ -0,0 +1,105 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "array_parameters.h"
+
+namespace
+{
+constexpr uint32_t stride_shift = 2;
+constexpr size_t num_bits = 32;
+
+// sparse_parameters as it was before the open addressing table, one allocation of stride weights per index.
+class map_weights
+{
+public:
+  map_weights(size_t length, uint32_t shift) : _weight_mask((length << shift) - 1), _stride(1 << shift) {}
+  map_weights(const map_weights&) = delete;
+  map_weights& operator=(const map_weights&) = delete;
+  ~map_weights()
+  {
+    for (auto& entry : _map) { free(entry.second); }
+  }
+
+  weight& operator[](size_t i)
+  {
+    const uint64_t index = i & _weight_mask;
+    auto iter = _map.find(index);
+    if (iter == _map.end()) { iter = _map.insert(std::make_pair(index, calloc_or_throw<weight>(_stride))).first; }
+    return *iter->second;
+  }
+
+private:
+  std::unordered_map<uint64_t, weight*> _map;
+  uint64_t _weight_mask;
+  uint32_t _stride;
+};
+
+// The table shared by threads, which keeps its full tables when it grows.
+class concurrent_sparse_parameters : public sparse_parameters
+{
+public:
+  concurrent_sparse_parameters(size_t length, uint32_t shift) : sparse_parameters(length, shift) { make_concurrent(); }
+};
+
+std::vector<uint64_t> make_indices(size_t count)
+{
+  std::mt19937_64 rng(11);
+  std::vector<uint64_t> indices(count);
+  for (auto& index : indices) { index = (rng() & ((static_cast<uint64_t>(1) << num_bits) - 1)) << stride_shift; }
+  return indices;
+}
+}  // namespace
+
+// Looks up the weights of state.range(0) distinct indices of a 32 bit model over and over, as training does once
+// every feature has been seen.
+template <typename WeightsT>
+static void bench_sparse_lookup(benchmark::State& state)
+{
+  const auto indices = make_indices(static_cast<size_t>(state.range(0)));
+  WeightsT weights(static_cast<size_t>(1) << num_bits, stride_shift);
+  for (auto index : indices) { (&weights[index])[1] = 1.f; }
+
+  for (auto _ : state)
+  {
+    float sum = 0.f;
+    for (auto index : indices) { sum += (&weights[index])[1]; }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * indices.size());
+}
+
+// Fills an empty model with state.range(0) new indices, as the first pass does.
+template <typename WeightsT>
+static void bench_sparse_insert(benchmark::State& state)
+{
+  const auto indices = make_indices(static_cast<size_t>(state.range(0)));
+  for (auto _ : state)
+  {
+    WeightsT weights(static_cast<size_t>(1) << num_bits, stride_shift);
+    for (auto index : indices) { weights[index] = 1.f; }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * indices.size());
+}
+
+// The memory the table takes per index, next to the 16 bytes of the weights themselves.
+static void bench_sparse_table_memory(benchmark::State& state)
+{
+  const auto indices = make_indices(static_cast<size_t>(state.range(0)));
+  sparse_parameters weights(static_cast<size_t>(1) << num_bits, stride_shift);
+  for (auto index : indices) { weights[index] = 1.f; }
+  for (auto _ : state) { benchmark::DoNotOptimize(weights.memory_bytes()); }
+  state.counters["bytes_per_index"] = static_cast<double>(weights.memory_bytes()) / weights.size();
+}
+
+BENCHMARK_TEMPLATE(bench_sparse_lookup, map_weights)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 21);
+BENCHMARK_TEMPLATE(bench_sparse_lookup, sparse_parameters)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 21);
+BENCHMARK_TEMPLATE(bench_sparse_lookup, concurrent_sparse_parameters)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 21);
+BENCHMARK_TEMPLATE(bench_sparse_insert, map_weights)->Arg(1 << 16)->Arg(1 << 21);
+BENCHMARK_TEMPLATE(bench_sparse_insert, sparse_parameters)->Arg(1 << 16)->Arg(1 << 21);
+BENCHMARK_TEMPLATE(bench_sparse_insert, concurrent_sparse_parameters)->Arg(1 << 16)->Arg(1 << 21);
+BENCHMARK(bench_sparse_table_memory)->Arg(1 << 16)->Arg(1 << 21);
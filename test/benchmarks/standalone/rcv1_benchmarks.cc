@@ -5334,3 +5334,9 @@ static void benchmark_rcv1_dataset(benchmark::State& state, std::string command_
 
 BENCHMARK_CAPTURE(benchmark_rcv1_dataset, simple, "--quiet");
 BENCHMARK_CAPTURE(benchmark_rcv1_dataset, quadratic, "--quiet -q ::");
+// With 2^24 weights of 4 floats each the table is far larger than the cache and most weights miss it.
+BENCHMARK_CAPTURE(benchmark_rcv1_dataset, quadratic_large_table, "--quiet -q :: -b 24");
+BENCHMARK_CAPTURE(
+    benchmark_rcv1_dataset, quadratic_large_table_prefetch_8, "--quiet -q :: -b 24 --prefetch_distance 8");
+BENCHMARK_CAPTURE(
+    benchmark_rcv1_dataset, quadratic_large_table_prefetch_32, "--quiet -q :: -b 24 --prefetch_distance 32");
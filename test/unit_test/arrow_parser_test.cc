@@ -0,0 +1,116 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include "test_common.h"
+
+#include <memory>
+#include <vector>
+#include "parser/arrow/parse_example_arrow.h"
+
+namespace
+{
+// Two rows: label, age, an all-zero column, city and id, with a null age in the second row.
+std::shared_ptr<::arrow::Buffer> sample_stream()
+{
+  ::arrow::DoubleBuilder labels;
+  ::arrow::FloatBuilder ages;
+  ::arrow::Int32Builder zeros;
+  ::arrow::StringBuilder cities;
+  ::arrow::StringBuilder ids;
+  BOOST_REQUIRE(labels.AppendValues({1.0, -1.0}).ok());
+  BOOST_REQUIRE(ages.Append(31.f).ok());
+  BOOST_REQUIRE(ages.AppendNull().ok());
+  BOOST_REQUIRE(zeros.AppendValues({0, 0}).ok());
+  BOOST_REQUIRE(cities.AppendValues({"paris", "rome"}).ok());
+  BOOST_REQUIRE(ids.AppendValues({"first", "second"}).ok());
+
+  std::vector<std::shared_ptr<::arrow::Array>> columns(5);
+  BOOST_REQUIRE(labels.Finish(&columns[0]).ok());
+  BOOST_REQUIRE(ages.Finish(&columns[1]).ok());
+  BOOST_REQUIRE(zeros.Finish(&columns[2]).ok());
+  BOOST_REQUIRE(cities.Finish(&columns[3]).ok());
+  BOOST_REQUIRE(ids.Finish(&columns[4]).ok());
+
+  auto schema = ::arrow::schema({::arrow::field("y", ::arrow::float64()), ::arrow::field("age", ::arrow::float32()),
+      ::arrow::field("zero", ::arrow::int32()), ::arrow::field("city", ::arrow::utf8()),
+      ::arrow::field("id", ::arrow::utf8())});
+  auto batch = ::arrow::RecordBatch::Make(schema, 2, columns);
+
+  auto sink = ::arrow::io::BufferOutputStream::Create().ValueOrDie();
+  auto writer = ::arrow::ipc::MakeStreamWriter(sink, schema).ValueOrDie();
+  BOOST_REQUIRE(writer->WriteRecordBatch(*batch).ok());
+  BOOST_REQUIRE(writer->Close().ok());
+  return sink->Finish().ValueOrDie();
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(arrow_parser_maps_columns_to_namespaces)
+{
+  auto all = VW::initialize("--no_stdin --quiet --arrow --arrow_label y --arrow_tag id --arrow_namespace a:age,zero "
+                            "--arrow_namespace c:city",
+      nullptr, false, nullptr, nullptr);
+  auto buffer = sample_stream();
+  all->arrow_converter->open_buffer(buffer->data(), static_cast<size_t>(buffer->size()));
+
+  v_array<example*> examples;
+  examples.push_back(&VW::get_unused_example(all));
+  BOOST_REQUIRE(all->arrow_converter->parse_examples(all, examples));
+  auto* ex = examples[0];
+
+  // The numeric column hashes like "|a age:31" in the text format would.
+  auto* text_ex = VW::read_example(*all, "1 |a age:31");
+  BOOST_CHECK_CLOSE(ex->l.simple.label, 1.f, FLOAT_TOL);
+  BOOST_CHECK_EQUAL(std::string(ex->tag.begin(), ex->tag.end()), "first");
+  BOOST_CHECK_EQUAL(ex->indices.size(), 2);
+  BOOST_REQUIRE_EQUAL(ex->feature_space['a'].size(), 1);
+  BOOST_CHECK_EQUAL(ex->feature_space['a'].indicies[0], text_ex->feature_space['a'].indicies[0]);
+  BOOST_CHECK_CLOSE(ex->feature_space['a'].values[0], 31.f, FLOAT_TOL);
+  BOOST_REQUIRE_EQUAL(ex->feature_space['c'].size(), 1);
+  BOOST_CHECK_EQUAL(
+      ex->feature_space['c'].indicies[0], VW::chain_hash(*all, "city", "paris", VW::hash_space(*all, "c")));
+  VW::finish_example(*all, *text_ex);
+  VW::empty_example(*all, *ex);
+
+  // The null age adds no feature and no namespace.
+  BOOST_REQUIRE(all->arrow_converter->parse_examples(all, examples));
+  BOOST_CHECK_CLOSE(ex->l.simple.label, -1.f, FLOAT_TOL);
+  BOOST_CHECK_EQUAL(ex->indices.size(), 1);
+  BOOST_CHECK_EQUAL(ex->feature_space['a'].size(), 0);
+  BOOST_CHECK_EQUAL(ex->feature_space['c'].size(), 1);
+  VW::empty_example(*all, *ex);
+
+  BOOST_CHECK(!all->arrow_converter->parse_examples(all, examples));
+  VW::finish_example(*all, *ex);
+  VW::finish(*all);
+}
+
+BOOST_AUTO_TEST_CASE(arrow_parser_defaults_to_one_namespace)
+{
+  auto all = VW::initialize("--no_stdin --quiet --arrow --arrow_label y", nullptr, false, nullptr, nullptr);
+  auto buffer = sample_stream();
+  all->arrow_converter->open_buffer(buffer->data(), static_cast<size_t>(buffer->size()));
+
+  v_array<example*> examples;
+  examples.push_back(&VW::get_unused_example(all));
+  BOOST_REQUIRE(all->arrow_converter->parse_examples(all, examples));
+  // age, city and id, the zero adds nothing.
+  BOOST_CHECK_EQUAL(examples[0]->indices.size(), 1);
+  BOOST_CHECK_EQUAL(examples[0]->feature_space[' '].size(), 3);
+  VW::finish_example(*all, *examples[0]);
+  VW::finish(*all);
+}
+
+BOOST_AUTO_TEST_CASE(arrow_parser_rejects_bad_specs)
+{
+  BOOST_CHECK_THROW(VW::parsers::arrow::schema_spec::parse("", "", {"a"}), VW::vw_exception);
+  BOOST_CHECK_THROW(VW::parsers::arrow::schema_spec::parse("", "", {":age"}), VW::vw_exception);
+  const auto spec = VW::parsers::arrow::schema_spec::parse("y", "", {"a:age,,zero", "city:city"});
+  BOOST_REQUIRE_EQUAL(spec.namespaces.size(), 2);
+  BOOST_CHECK_EQUAL(spec.namespaces[0].second.size(), 2);
+  BOOST_CHECK_EQUAL(spec.namespaces[1].first, "city");
+}
@@ -43,3 +43,98 @@ BOOST_AUTO_TEST_CASE(write_and_read_features_from_cache)
 
   VW::finish(vw);
 }
+
+BOOST_AUTO_TEST_CASE(write_and_read_feature_blocks_from_cache)
+{
+  auto& vw = *VW::initialize("--quiet");
+  // Enough examples for a full block and a partial one.
+  const size_t num_examples = VW::cache_block_size + 10;
+  std::vector<example> src(num_examples);
+  for (size_t i = 0; i < num_examples; i++)
+  {
+    const auto line = "1 'tag" + std::to_string(i) + " |ns1 a b:-1 c:" + std::to_string(i) + " |ss2 ex:0.5";
+    VW::read_line(vw, &src[i], line.c_str());
+  }
+
+  auto backing_vector = std::make_shared<std::vector<char>>();
+  io_buf io_writer;
+  io_writer.add_file(VW::io::create_vector_writer(backing_vector));
+  VW::cache_block_writer writer;
+  for (auto& ex : src) { writer.add_example(io_writer, &ex, vw.example_parser->lbl_parser, vw.parse_mask); }
+  writer.finish(io_writer);
+  io_writer.flush();
+
+  const auto index = VW::read_cache_block_index(backing_vector->data(), backing_vector->size());
+  BOOST_REQUIRE_EQUAL(index.size(), 2);
+  BOOST_CHECK_EQUAL(index[0].offset, 0);
+  BOOST_CHECK_EQUAL(index[0].num_examples, VW::cache_block_size);
+  BOOST_CHECK_EQUAL(index[1].num_examples, 10);
+
+  io_buf io_reader;
+  io_reader.add_file(VW::io::create_buffer_view(backing_vector->data(), backing_vector->size()));
+  VW::cache_block_reader reader;
+  for (auto& src_ex : src)
+  {
+    if (reader.remaining() == 0) { BOOST_REQUIRE(reader.read_block(io_reader)); }
+    example dest_ex;
+    BOOST_REQUIRE(reader.read_example_header(&dest_ex, vw.example_parser->lbl_parser, vw.example_parser->sorted_cache,
+                      vw.example_parser->_shared_data) > 0);
+    reader.columns().decode_example(dest_ex);
+
+    check_collections_exact(src_ex.tag, dest_ex.tag);
+    BOOST_CHECK_EQUAL(dest_ex.l.simple.label, src_ex.l.simple.label);
+    check_collections_exact(src_ex.indices, dest_ex.indices);
+    for (auto ns : {'n', 's'})
+    {
+      check_collections_with_float_tolerance(
+          src_ex.feature_space[ns].values, dest_ex.feature_space[ns].values, FLOAT_TOL);
+      check_collections_exact(src_ex.feature_space[ns].indicies, dest_ex.feature_space[ns].indicies);
+    }
+  }
+  BOOST_CHECK_EQUAL(reader.remaining(), 0);
+  BOOST_CHECK(!reader.read_block(io_reader));
+  VW::finish(vw);
+}
+
+BOOST_AUTO_TEST_CASE(read_shards_of_cache_blocks)
+{
+  auto& vw = *VW::initialize("--quiet");
+  const size_t num_examples = 2 * VW::cache_block_size + 10;
+  auto backing_vector = std::make_shared<std::vector<char>>();
+  io_buf io_writer;
+  io_writer.add_file(VW::io::create_vector_writer(backing_vector));
+  VW::cache_block_writer writer;
+  for (size_t i = 0; i < num_examples; i++)
+  {
+    example ex;
+    VW::read_line(vw, &ex, ("1 'tag" + std::to_string(i) + " |ns1 a").c_str());
+    writer.add_example(io_writer, &ex, vw.example_parser->lbl_parser, vw.parse_mask);
+  }
+  writer.finish(io_writer);
+  io_writer.flush();
+
+  // Every example turns up in exactly one shard, blocks being handed out in turn.
+  std::vector<size_t> shard_of(num_examples, 2);
+  for (size_t shard = 0; shard < 2; shard++)
+  {
+    io_buf io_reader;
+    io_reader.add_file(VW::io::create_buffer_view(backing_vector->data(), backing_vector->size()));
+    VW::cache_block_reader reader;
+    reader.set_shard(shard, 2);
+    while (reader.read_block(io_reader))
+    {
+      while (reader.remaining() > 0)
+      {
+        example dest_ex;
+        BOOST_REQUIRE(reader.read_example_header(&dest_ex, vw.example_parser->lbl_parser,
+                          vw.example_parser->sorted_cache, vw.example_parser->_shared_data) > 0);
+        const size_t i = std::stoul(std::string(dest_ex.tag.begin() + 3, dest_ex.tag.end()));
+        BOOST_REQUIRE_LT(i, num_examples);
+        BOOST_CHECK_EQUAL(shard_of[i], 2);
+        shard_of[i] = shard;
+      }
+    }
+  }
+  for (size_t i = 0; i < num_examples; i++) { BOOST_CHECK_EQUAL(shard_of[i], (i / VW::cache_block_size) % 2); }
+  VW::finish(vw);
+}
@@ -0,0 +1,105 @@
+#ifndef STATIC_LINK_VW
+#  define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "array_parameters.h"
+
+// Meant to be run under ThreadSanitizer as well, configure with -DTSAN=ON.
+namespace
+{
+constexpr uint32_t stride_shift = 2;
+constexpr size_t num_readers = 6;
+constexpr size_t num_indices = 1 << 16;
+
+uint64_t index_of(size_t i) { return static_cast<uint64_t>(i * 2654435761ULL) << stride_shift; }
+}  // namespace
+
+// One trainer and several predicting threads look up the same indices at once, most of them not in the table yet, so
+// that the table grows many times over while they run. The trainer only writes weights[1] and the readers only read
+// weights[0], which the default function sets before the index is visible.
+BOOST_AUTO_TEST_CASE(concurrent_sparse_weights_are_added_once_and_initialized)
+{
+  sparse_parameters w(static_cast<size_t>(1) << 50, stride_shift);
+  std::atomic<size_t> defaults(0);
+  w.set_default([&defaults](weight* weights, uint64_t index) {
+    weights[0] = static_cast<float>(index);
+    defaults++;
+  });
+  w.make_concurrent();
+  BOOST_CHECK(w.concurrent());
+
+  std::atomic<size_t> wrong(0);
+  std::vector<std::thread> threads;
+  threads.emplace_back([&w] {
+    for (size_t i = 0; i < num_indices; i++) { (&w[index_of(i)])[1] += 1.f; }
+  });
+  for (size_t r = 0; r < num_readers; r++)
+  {
+    threads.emplace_back([&w, &wrong, r] {
+      const sparse_parameters& weights = w;
+      std::mt19937_64 rng(r);
+      for (size_t n = 0; n < 2 * num_indices; n++)
+      {
+        const auto index = index_of(rng() % num_indices);
+        if ((&weights[index])[0] != static_cast<float>(index & weights.mask())) { wrong++; }
+      }
+    });
+  }
+  for (auto& thread : threads) { thread.join(); }
+
+  BOOST_CHECK_EQUAL(wrong.load(), 0);
+  BOOST_CHECK_EQUAL(defaults.load(), w.size());
+  BOOST_CHECK_LE(w.size(), num_indices);
+  for (size_t i = 0; i < num_indices; i++)
+  {
+    const weight* weights = &w[index_of(i)];
+    BOOST_CHECK_EQUAL(weights[0], static_cast<float>(index_of(i) & w.mask()));
+    BOOST_CHECK_EQUAL(weights[1], 1.f);
+  }
+
+  size_t visited = 0;
+  for (auto iter = w.begin(); iter != w.end(); ++iter) { visited++; }
+  BOOST_CHECK_EQUAL(visited, w.size());
+  BOOST_CHECK_EQUAL(visited, num_indices);
+}
+
+// Weights of a concurrent table stay where they are while it grows.
+BOOST_AUTO_TEST_CASE(concurrent_sparse_weights_do_not_move)
+{
+  sparse_parameters w(static_cast<size_t>(1) << 50, stride_shift);
+  w.make_concurrent();
+  weight* first = &w[index_of(0)];
+  *first = 3.f;
+  for (size_t i = 1; i < num_indices; i++) { w[index_of(i)] = 1.f; }
+  BOOST_CHECK_EQUAL(&w[index_of(0)], first);
+  BOOST_CHECK_EQUAL(*first, 3.f);
+}
+
+// A seeded instance shares the table, so its thread can predict while the first one trains.
+BOOST_AUTO_TEST_CASE(seeded_sparse_weights_are_concurrent)
+{
+  sparse_parameters w(static_cast<size_t>(1) << 20, stride_shift);
+  sparse_parameters seeded;
+  seeded.shallow_copy(w);
+  BOOST_CHECK(w.concurrent());
+  BOOST_CHECK(seeded.concurrent());
+
+  std::thread trainer([&w] {
+    for (size_t i = 0; i < num_indices; i++) { (&w[index_of(i)])[1] = 1.f; }
+  });
+  std::thread predictor([&seeded] {
+    for (size_t i = num_indices; i > 0; i--) { seeded[index_of(i - 1)]; }
+  });
+  trainer.join();
+  predictor.join();
+  BOOST_CHECK_EQUAL(w.size(), seeded.size());
+  BOOST_CHECK_EQUAL((&seeded[index_of(7)])[1], 1.f);
+}
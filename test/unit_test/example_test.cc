@@ -5,7 +5,10 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/test_tools.hpp>
 
+#include <sstream>
+
 #include "example.h"
+#include "vw.h"
 
 BOOST_AUTO_TEST_CASE(example_move_ctor_moves_pred)
 {
@@ -32,3 +35,66 @@ BOOST_AUTO_TEST_CASE(example_move_assign_op_moves_pred)
   BOOST_CHECK_EQUAL(ex.pred.a_s.size(), 0);
   BOOST_CHECK_EQUAL(ex2.pred.a_s.size(), 1);
 }
+
+BOOST_AUTO_TEST_CASE(example_feature_space_allocates_used_namespaces)
+{
+  example ex;
+  BOOST_CHECK_LT(sizeof(example), 4096);
+
+  const example& const_ex = ex;
+  BOOST_CHECK(const_ex.feature_space['a'].empty());
+  BOOST_CHECK_EQUAL(ex.feature_space.allocated(), 0);
+
+  ex.feature_space['a'].push_back(1.f, 1);
+  features* a = &ex.feature_space['a'];
+  ex.feature_space['b'].push_back(2.f, 2);
+  ex.feature_space['a'].push_back(3.f, 3);
+  BOOST_CHECK_EQUAL(ex.feature_space.allocated(), 2);
+  BOOST_CHECK(&ex.feature_space['a'] == a);
+  BOOST_CHECK(ex.feature_space.find('c') == nullptr);
+
+  example moved(std::move(ex));
+  BOOST_CHECK(&moved.feature_space['a'] == a);
+  BOOST_CHECK(ex.feature_space.find('a') == nullptr);
+  size_t total = 0;
+  for (const auto& fs : moved.feature_space) { total += fs.size(); }
+  BOOST_CHECK_EQUAL(total, 3);
+}
+
+BOOST_AUTO_TEST_CASE(example_features_grow_into_arena)
+{
+  auto& plain = *VW::initialize("--quiet --no_stdin");
+  auto& arena = *VW::initialize("--quiet --no_stdin --feature_arena");
+
+  for (size_t i = 0; i < 100; i++)
+  {
+    std::stringstream line;
+    line << (i % 2 == 0 ? 1 : -1) << " |a";
+    for (size_t f = 0; f < 10 + (i % 7) * 50; f++) { line << " a" << f * i % 101; }
+    line << " |b b" << i % 13 << " |c c:" << i;
+
+    auto* plain_ex = VW::read_example(plain, line.str());
+    auto* arena_ex = VW::read_example(arena, line.str());
+    BOOST_REQUIRE(plain_ex->arena == nullptr);
+    BOOST_REQUIRE(arena_ex->arena != nullptr);
+    plain.learn(*plain_ex);
+    arena.learn(*arena_ex);
+    BOOST_CHECK_EQUAL(plain_ex->pred.scalar, arena_ex->pred.scalar);
+    BOOST_CHECK_EQUAL(plain_ex->get_num_features(), arena_ex->get_num_features());
+
+    // Once the arena has seen the largest examples every group is in its block.
+    if (i >= 50)
+    {
+      for (auto ns : arena_ex->indices)
+      {
+        BOOST_CHECK(arena_ex->feature_space[ns].values.borrows_storage());
+        BOOST_CHECK(arena_ex->arena->in_block(arena_ex->feature_space[ns].values.begin()));
+        BOOST_CHECK(arena_ex->arena->in_block(arena_ex->feature_space[ns].indicies.begin()));
+      }
+    }
+    VW::finish_example(plain, *plain_ex);
+    VW::finish_example(arena, *arena_ex);
+  }
+  VW::finish(plain);
+  VW::finish(arena);
+}
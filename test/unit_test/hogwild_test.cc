@@ -0,0 +1,114 @@
+#ifndef STATIC_LINK_VW
+#  define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "io/io_adapter.h"
+#include "learner.h"
+#include "parser.h"
+#include "shared_data.h"
+#include "vw.h"
+#include "vw_exception.h"
+
+namespace
+{
+std::string make_sparse_data(size_t num_examples)
+{
+  std::stringstream data;
+  for (size_t i = 0; i < num_examples; i++)
+  {
+    data << (i % 2 == 0 ? "1 |a pos" : "-1 |a neg") << " |b n" << (i % 101) << " m" << (i % 37) << "\n";
+  }
+  return data.str();
+}
+
+void train(vw& all, const std::string& data)
+{
+  all.example_parser->input->add_file(VW::io::create_buffer_view(data.data(), data.size()));
+  VW::start_parser(all);
+  VW::LEARNER::generic_driver(all);
+  VW::end_parser(all);
+}
+
+float predict(vw& all, const char* line)
+{
+  auto* ex = VW::read_example(all, line);
+  all.predict(*ex);
+  const float prediction = ex->pred.scalar;
+  VW::finish_example(all, *ex);
+  return prediction;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(hogwild_learns_from_every_example)
+{
+  const size_t num_examples = 4000;
+  const auto data = make_sparse_data(num_examples);
+  for (const std::string update : {"", " --sgd", " --adaptive", " --normalized", " --sparse_weights"})
+  {
+    auto& all = *VW::initialize("-b 16 --hogwild 4 --ring_size 64 --quiet --no_stdin" + update);
+    train(all, data);
+
+    // Examples are finished one at a time, so none of the counters lose an update.
+    BOOST_CHECK_EQUAL(all.sd->example_number, num_examples);
+    BOOST_CHECK_CLOSE(all.sd->weighted_labeled_examples, static_cast<double>(num_examples), 0.001);
+    BOOST_CHECK_GT(predict(all, "|a pos"), 0.5f);
+    BOOST_CHECK_LT(predict(all, "|a neg"), -0.5f);
+    VW::finish(all);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(hogwild_runs_every_pass)
+{
+  const size_t num_examples = 1000;
+  const auto data = make_sparse_data(num_examples);
+  auto& all = *VW::initialize(
+      "-b 16 --hogwild 3 --passes 3 --holdout_off -k --cache_file hogwild.cache --quiet --no_stdin --ring_size 32");
+  train(all, data);
+  BOOST_CHECK_EQUAL(all.current_pass, 3);
+  BOOST_CHECK_EQUAL(all.sd->example_number, 3 * num_examples);
+  BOOST_CHECK_GT(predict(all, "|a pos"), 0.5f);
+  VW::finish(all);
+  std::remove("hogwild.cache");
+}
+
+BOOST_AUTO_TEST_CASE(hogwild_rejects_stateful_reductions)
+{
+  BOOST_CHECK_THROW(VW::initialize("--hogwild 2 --oaa 3 --quiet"), VW::vw_exception);
+  BOOST_CHECK_THROW(VW::initialize("--hogwild 2 --l2 0.001 --quiet"), VW::vw_exception);
+}
+
+// Meant to be run under ThreadSanitizer as well, configure with -DTSAN=ON.
+BOOST_AUTO_TEST_CASE(hogwild_shares_the_label_range_and_example_counts)
+{
+  // Labels keep widening the range while the threads learn, and without --adaptive the updates are scaled by the
+  // examples learned from so far, which the other threads count as they finish examples.
+  const size_t num_examples = 2000;
+  std::stringstream data;
+  for (size_t i = 0; i < num_examples; i++)
+  {
+    if (i % 10 == 0) { data << "|a f" << (i % 13) << "\n"; }
+    else
+    {
+      data << (i % 2 == 0 ? 1.f : -1.f) * (1.f + i * 0.001f) << " |a f" << (i % 13) << "\n";
+    }
+  }
+
+  for (const std::string update : {" --sgd", " --normalized", ""})
+  {
+    auto& all = *VW::initialize("-b 16 --hogwild 4 --ring_size 64 --quiet --no_stdin" + update);
+    train(all, data.str());
+    BOOST_CHECK_CLOSE(all.sd->min_label, -2.999f, 0.001);
+    BOOST_CHECK_CLOSE(all.sd->max_label, 2.998f, 0.001);
+    BOOST_CHECK_EQUAL(all.sd->example_number, num_examples);
+    BOOST_CHECK_CLOSE(all.sd->weighted_unlabeled_examples, num_examples / 10., 0.001);
+    BOOST_CHECK_CLOSE(all.sd->weighted_labeled_examples, num_examples * 0.9, 0.001);
+    VW::finish(all);
+  }
+}
@@ -9,6 +9,8 @@
 #include <cstdint>
 #include <memory>
 #include <array>
+#include <limits>
+#include <random>
 #include <vector>
 
 #include "test_common.h"
@@ -16,6 +18,7 @@
 #include "gd_predict.h"
 #include "gd.h"
 #include "interactions.h"
+#include "interactions_simd.h"
 
 struct eval_gen_data
 {
@@ -275,3 +278,147 @@ BOOST_AUTO_TEST_CASE(compile_interactions_cubic_permutations)
   sort_all(result);
   check_vector_of_vectors_exact(result, compare_set);
 }
+
+BOOST_AUTO_TEST_CASE(simd_kernels_match_scalar_kernels)
+{
+  std::mt19937_64 rng(17);
+  std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+  const uint64_t mask = (1 << 12) - 1;
+  std::vector<float> weights(mask + 1);
+  for (auto& w : weights) { w = uniform(rng); }
+
+  const auto& scalar = INTERACTIONS::kernels_for(INTERACTIONS::simd_level::scalar);
+  for (size_t count : {1, 7, 8, 15, 16, 17, 100, 1001})
+  {
+    std::vector<uint64_t> indices(count);
+    std::vector<float> values(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      // Every fifth feature hits the same weight so that the updates collide within a vector.
+      indices[i] = i % 5 == 0 ? 42 : rng();
+      values[i] = uniform(rng);
+    }
+    const float expected = scalar.dot(weights.data(), mask, indices.data(), values.data(), count, 977, 8, 0.5f, 0);
+    // Prefetching must not change anything but the speed.
+    for (size_t prefetch : {0, 5, 16})
+    {
+      for (auto level : {INTERACTIONS::simd_level::scalar, INTERACTIONS::simd_level::avx2,
+               INTERACTIONS::simd_level::avx512})
+      {
+        const float dot = INTERACTIONS::kernels_for(level).dot(
+            weights.data(), mask, indices.data(), values.data(), count, 977, 8, 0.5f, prefetch);
+        BOOST_CHECK_CLOSE(dot, expected, 0.001f);
+      }
+    }
+
+    // Features with an infinite value are left out of the update.
+    if (count > 50) { values[33] = std::numeric_limits<float>::infinity(); }
+    auto expected_weights = weights;
+    scalar.add(expected_weights.data(), mask, indices.data(), values.data(), count, 977, 8, 0.5f, 0.1f, 0);
+    for (size_t prefetch : {0, 5, 16})
+    {
+      for (auto level : {INTERACTIONS::simd_level::scalar, INTERACTIONS::simd_level::avx2,
+               INTERACTIONS::simd_level::avx512})
+      {
+        auto updated = weights;
+        INTERACTIONS::kernels_for(level).add(
+            updated.data(), mask, indices.data(), values.data(), count, 977, 8, 0.5f, 0.1f, prefetch);
+        // The update is applied in the same order and rounding as the scalar loop.
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            updated.begin(), updated.end(), expected_weights.begin(), expected_weights.end());
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(vectorized_interactions_predict_like_scalar)
+{
+  std::mt19937_64 rng(5);
+  std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+  dense_parameters weights(1 << 14, 2);
+  for (auto iter = weights.begin(); iter != weights.end(); ++iter) { *iter = uniform(rng); }
+
+  example_predict ex;
+  for (namespace_index ns : {'a', 'b', 'c'})
+  {
+    ex.indices.push_back(ns);
+    for (size_t i = 0; i < 37; i++) { ex.feature_space[ns].push_back(uniform(rng), rng() << 2); }
+  }
+  std::vector<std::vector<namespace_index>> interactions = {{'a', 'b'}, {'a', 'a'}, {'a', 'b', 'c'}};
+  std::array<bool, NUM_NAMESPACES> ignore_linear;
+  ignore_linear.fill(false);
+
+  const auto detected = INTERACTIONS::detect_simd_level();
+  INTERACTIONS::set_simd_level(INTERACTIONS::simd_level::scalar);
+  BOOST_CHECK(INTERACTIONS::active_simd_kernels() == nullptr);
+  size_t scalar_features = 0;
+  const float scalar = GD::inline_predict(weights, false, ignore_linear, interactions, false, ex, scalar_features);
+
+  INTERACTIONS::set_simd_level(detected);
+  BOOST_CHECK(INTERACTIONS::active_simd_level() == detected);
+  size_t vectorized_features = 0;
+  const float vectorized =
+      GD::inline_predict(weights, false, ignore_linear, interactions, false, ex, vectorized_features);
+
+  BOOST_CHECK_EQUAL(scalar_features, vectorized_features);
+  // Only the order in which the products are summed up differs.
+  BOOST_CHECK_CLOSE(scalar, vectorized, 0.01f);
+}
+
+BOOST_AUTO_TEST_CASE(vectorized_sgd_update_learns_like_scalar)
+{
+  std::vector<std::string> lines;
+  for (size_t i = 0; i < 200; i++)
+  {
+    std::string line = i % 2 == 0 ? "1 |a" : "-1 |a";
+    for (size_t j = 0; j < 20; j++) { line += " a" + std::to_string((i * 7 + j) % 53); }
+    line += " |b";
+    for (size_t j = 0; j < 20; j++) { line += " b" + std::to_string((i * 3 + j) % 41) + ":0.5"; }
+    lines.push_back(line);
+  }
+
+  const auto detected = INTERACTIONS::detect_simd_level();
+  std::vector<float> predictions;
+  for (auto level : {INTERACTIONS::simd_level::scalar, detected})
+  {
+    INTERACTIONS::set_simd_level(level);
+    auto& vw = *VW::initialize("--quiet --sgd -q ab -b 18 --noconstant", nullptr, false, nullptr, nullptr);
+    for (const auto& line : lines)
+    {
+      auto* ex = VW::read_example(vw, line);
+      vw.learn(*ex);
+      VW::finish_example(vw, *ex);
+    }
+    auto* ex = VW::read_example(vw, lines[0]);
+    vw.predict(*ex);
+    predictions.push_back(ex->pred.scalar);
+    VW::finish_example(vw, *ex);
+    VW::finish(vw);
+  }
+  INTERACTIONS::set_simd_level(detected);
+  BOOST_CHECK_CLOSE(predictions[0], predictions[1], 0.01f);
+}
+
+BOOST_AUTO_TEST_CASE(prefetching_does_not_change_predictions)
+{
+  std::vector<float> predictions;
+  for (const std::string prefetch : {"", " --prefetch_distance 1", " --prefetch_distance 16"})
+  {
+    auto& vw = *VW::initialize("--quiet -q ab -b 16" + prefetch, nullptr, false, nullptr, nullptr);
+    BOOST_CHECK_EQUAL(vw.weights.dense_weights.prefetch_distance(), vw.prefetch_distance);
+    for (size_t i = 0; i < 100; i++)
+    {
+      auto* ex = VW::read_example(vw, std::string(i % 2 == 0 ? "1" : "-1") + " |a x" + std::to_string(i % 7) +
+              " y z w" + std::to_string(i % 3) + " |b p q r s t u v w" + std::to_string(i % 11));
+      vw.learn(*ex);
+      VW::finish_example(vw, *ex);
+    }
+    auto* ex = VW::read_example(vw, "|a x1 y z |b p q r");
+    vw.predict(*ex);
+    predictions.push_back(ex->pred.scalar);
+    VW::finish_example(vw, *ex);
+    VW::finish(vw);
+  }
+  BOOST_CHECK_EQUAL(predictions[0], predictions[1]);
+  BOOST_CHECK_EQUAL(predictions[0], predictions[2]);
+}
@@ -7,8 +7,16 @@
 
 #include <memory>
 #include <array>
+#include <cstdio>
+#include <fstream>
+#include <string>
 
 #include "io/io_adapter.h"
+#include "io_buf.h"
+
+#ifndef _WIN32
+#  include <sys/socket.h>
+#endif
 
 BOOST_AUTO_TEST_CASE(io_adapter_vector_writer)
 {
@@ -58,3 +66,91 @@ BOOST_AUTO_TEST_CASE(io_adapter_buffer_view)
     BOOST_CHECK_EQUAL(std::strncmp(read_buffer3, "test another", 13), 0);
   }
 }
+
+BOOST_AUTO_TEST_CASE(io_adapter_mapped_file_reader)
+{
+  const std::string file_name = "io_adapter_mapped_file_reader.txt";
+  {
+    std::ofstream file(file_name, std::ios::binary);
+    file << "test another";
+  }
+
+  {
+    auto mapped_reader = VW::io::open_mapped_file_reader(file_name);
+    char read_buffer[5];
+    BOOST_CHECK_EQUAL(mapped_reader->read(read_buffer, 5), 5);
+    BOOST_CHECK_EQUAL(std::strncmp(read_buffer, "test ", 5), 0);
+
+    char* data = nullptr;
+    size_t len = 0;
+#ifndef _WIN32
+    BOOST_REQUIRE(mapped_reader->map_remaining(data, len));
+    BOOST_CHECK_EQUAL(std::string(data, len), "another");
+    BOOST_CHECK_EQUAL(mapped_reader->read(read_buffer, 5), 0);
+#endif
+
+    BOOST_CHECK_EQUAL(mapped_reader->is_resettable(), true);
+    BOOST_CHECK_NO_THROW(mapped_reader->reset());
+    BOOST_CHECK_EQUAL(mapped_reader->read(read_buffer, 5), 5);
+    BOOST_CHECK_EQUAL(std::strncmp(read_buffer, "test ", 5), 0);
+  }
+  std::remove(file_name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(io_buf_reads_across_mapped_file)
+{
+  const std::string file_name = "io_buf_reads_across_mapped_file.txt";
+  {
+    std::ofstream file(file_name, std::ios::binary);
+    file << "first line\nsecond li";
+  }
+
+  {
+    const std::string rest = "ne\nthird";
+    io_buf buf;
+    buf.add_file(VW::io::open_mapped_file_reader(file_name));
+    buf.add_file(VW::io::create_buffer_view(rest.data(), rest.size()));
+
+    char* line;
+    size_t len = buf.readto(line, '\n');
+    BOOST_CHECK_EQUAL(std::string(line, len), "first line\n");
+    // This line starts in the mapped file and ends in the buffer view.
+    len = buf.readto(line, '\n');
+    BOOST_CHECK_EQUAL(std::string(line, len), "second line\n");
+    len = buf.buf_read(line, 5);
+    BOOST_CHECK_EQUAL(std::string(line, len), "third");
+    BOOST_CHECK_EQUAL(buf.buf_read(line, 1), 0);
+
+    // Reading again from the start maps the file afresh.
+    for (auto& file : buf.get_input_files()) { buf.reset_file(file.get()); }
+    buf.current = 0;
+    len = buf.readto(line, '\n');
+    BOOST_CHECK_EQUAL(std::string(line, len), "first line\n");
+    buf.close_files();
+  }
+  std::remove(file_name.c_str());
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(io_adapter_batched_socket_writer)
+{
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  auto socket = VW::io::wrap_socket_descriptor(fds[0]);
+  auto writer = socket->get_batched_writer();
+  BOOST_CHECK_EQUAL(writer->write("0.5", 3), 3);
+  BOOST_CHECK_EQUAL(writer->write("\n", 1), 1);
+  BOOST_CHECK_EQUAL(writer->write("-1 tag\n", 7), 7);
+
+  char buffer[64];
+  BOOST_CHECK_LT(recv(fds[1], buffer, sizeof(buffer), MSG_DONTWAIT), 0);
+  writer->flush();
+  const auto received = recv(fds[1], buffer, sizeof(buffer), MSG_DONTWAIT);
+  BOOST_REQUIRE_EQUAL(received, 11);
+  BOOST_CHECK_EQUAL(std::string(buffer, 11), "0.5\n-1 tag\n");
+
+  writer->flush();
+  BOOST_CHECK_LT(recv(fds[1], buffer, sizeof(buffer), MSG_DONTWAIT), 0);
+  close(fds[1]);
+}
+#endif
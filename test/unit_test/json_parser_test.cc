@@ -824,3 +824,62 @@ BOOST_AUTO_TEST_CASE(parse_json_dedup_slates_dedup_id_missing)
   for (auto& dedup : dedup_examples) { VW::finish_example(*vw, *dedup.second); }
   VW::finish(*vw);
 }
+
+BOOST_AUTO_TEST_CASE(parse_json_skips_ignored_values)
+{
+  std::string json_text = R"(
+    {
+      "_label": 1,
+      "_ignored": {
+        "text": "a \"quoted\" value with } ] , { [ inside that spans more than sixteen bytes",
+        "nested": [1, [2, 3], {"x": "y"}, "\\"]
+      },
+      "features": {"a": 1, "b": 2},
+      "_also_ignored": "0123456789abcdefghijklmnopqrstuvwxyz"
+    })";
+
+  auto vw = VW::initialize("--json --chain_hash --no_stdin --quiet", nullptr, false, nullptr, nullptr);
+  auto examples = parse_json(*vw, json_text);
+
+  BOOST_CHECK_EQUAL(examples.size(), 1);
+  BOOST_CHECK_CLOSE(examples[0]->l.simple.label, 1.f, FLOAT_TOL);
+  BOOST_CHECK_EQUAL(examples[0]->indices.size(), 1);
+  BOOST_CHECK_EQUAL(examples[0]->feature_space['f'].size(), 2);
+  VW::finish_example(*vw, examples);
+  VW::finish(*vw);
+}
+
+BOOST_AUTO_TEST_CASE(parse_json_starts_clean_after_error)
+{
+  // Fails inside an action, with a namespace pushed and a label index set.
+  std::string bad_json_text = R"({"_labelIndex": 1, "_multi": [{"a_": "1"}, {"b_": "2", "_label": {"Unknown": 1}}]})";
+  std::string json_text = R"(
+    {
+      "s_": "1",
+      "_labelIndex": 0,
+      "_label_Action": 1,
+      "_label_Cost": 1,
+      "_label_Probability": 0.5,
+      "_multi": [{"a_": "1"}, {"a_": "2"}]
+    })";
+
+  auto vw = VW::initialize("--cb_adf --json --chain_hash --no_stdin --quiet", nullptr, false, nullptr, nullptr);
+
+  v_array<example*> examples;
+  examples.push_back(&VW::get_unused_example(vw));
+  BOOST_REQUIRE_THROW(VW::read_line_json_s<true>(*vw, examples, (char*)bad_json_text.c_str(), bad_json_text.length(),
+                          (VW::example_factory_t)&VW::get_unused_example, (void*)vw),
+      VW::vw_exception);
+  for (auto* example : examples) { VW::finish_example(*vw, *example); }
+
+  auto parsed = parse_json(*vw, json_text);
+  BOOST_CHECK_EQUAL(parsed.size(), 3);
+  BOOST_CHECK_EQUAL(parsed[0]->l.cb.costs.size(), 1);
+  BOOST_CHECK_EQUAL(parsed[1]->l.cb.costs.size(), 1);
+  BOOST_CHECK_EQUAL(parsed[2]->l.cb.costs.size(), 0);
+  BOOST_CHECK_CLOSE(parsed[1]->l.cb.costs[0].probability, 0.5, FLOAT_TOL);
+  BOOST_CHECK_EQUAL(parsed[1]->indices.size(), 1);
+  BOOST_CHECK_EQUAL(parsed[2]->indices.size(), 1);
+  VW::finish_example(*vw, parsed);
+  VW::finish(*vw);
+}
@@ -0,0 +1,266 @@
+#ifndef STATIC_LINK_VW
+#  define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "io/io_adapter.h"
+#include "io_buf.h"
+#include "parse_regressor.h"
+#include "vw.h"
+
+#include "test_common.h"
+
+namespace
+{
+void learn(vw& all, size_t num_examples)
+{
+  for (size_t i = 0; i < num_examples; i++)
+  {
+    const std::string line = std::string(i % 2 == 0 ? "1 |a pos" : "-1 |a neg") + " |b n" + std::to_string(i % 101);
+    auto* ex = VW::read_example(all, line);
+    all.learn(*ex);
+    VW::finish_example(all, *ex);
+  }
+}
+
+float predict(vw& all, const char* line)
+{
+  auto* ex = VW::read_example(all, line);
+  all.predict(*ex);
+  const float prediction = ex->pred.scalar;
+  VW::finish_example(all, *ex);
+  return prediction;
+}
+
+size_t file_size(const std::string& file_name)
+{
+  std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+  return static_cast<size_t>(file.tellg());
+}
+
+std::shared_ptr<std::vector<char>> save_to_memory(vw& all)
+{
+  auto backing_vector = std::make_shared<std::vector<char>>();
+  io_buf model;
+  model.add_file(VW::io::create_vector_writer(backing_vector));
+  VW::save_predictor(all, model);
+  return backing_vector;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(flat_model_maps_the_weights_from_the_model_file)
+{
+  const std::string file_name = "flat_model_test.model";
+  auto& trained = *VW::initialize("-b 12 --flat_model --quiet --no_stdin");
+  learn(trained, 500);
+  VW::save_predictor(trained, file_name);
+
+  auto& loaded = *VW::initialize("-t -i " + file_name + " --quiet --no_stdin");
+  BOOST_CHECK(loaded.flat_model);
+  BOOST_CHECK_CLOSE(predict(loaded, "|a pos |b n3"), predict(trained, "|a pos |b n3"), FLOAT_TOL);
+  BOOST_CHECK_CLOSE(predict(loaded, "|a neg |b n4"), predict(trained, "|a neg |b n4"), FLOAT_TOL);
+
+  // Only the weights themselves are saved without --save_resume, like in the sparse layout.
+  const auto& weights = loaded.weights.dense_weights;
+  const auto stride = weights.stride();
+  for (size_t i = 0; i <= weights.mask(); i++)
+  {
+    if (i % stride == 0) { BOOST_CHECK_EQUAL(weights[i], trained.weights.dense_weights[i]); }
+    else
+    {
+      BOOST_CHECK_EQUAL(weights[i], 0.f);
+    }
+  }
+
+  VW::finish(loaded);
+  VW::finish(trained);
+  std::remove(file_name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(flat_model_reads_the_weights_from_memory_with_save_resume)
+{
+  auto& trained = *VW::initialize("-b 12 --flat_model --save_resume --quiet --no_stdin");
+  learn(trained, 500);
+  auto backing_vector = save_to_memory(trained);
+  BOOST_CHECK_GT(backing_vector->size(), (static_cast<size_t>(1) << 12) * trained.weights.stride() * sizeof(float));
+
+  io_buf model;
+  model.add_file(VW::io::create_buffer_view(backing_vector->data(), backing_vector->size()));
+  auto& loaded = *VW::initialize("--quiet --no_stdin", &model);
+  const auto& weights = loaded.weights.dense_weights;
+  BOOST_REQUIRE_EQUAL(weights.mask(), trained.weights.dense_weights.mask());
+  for (size_t i = 0; i <= weights.mask(); i++) { BOOST_CHECK_EQUAL(weights[i], trained.weights.dense_weights[i]); }
+
+  // Learning goes on from the same state.
+  learn(trained, 100);
+  learn(loaded, 100);
+  BOOST_CHECK_CLOSE(predict(loaded, "|a pos |b n3"), predict(trained, "|a pos |b n3"), FLOAT_TOL);
+
+  VW::finish(loaded);
+  VW::finish(trained);
+}
+
+BOOST_AUTO_TEST_CASE(flat_model_needs_dense_weights)
+{
+  auto& all = *VW::initialize("-b 12 --flat_model --sparse_weights --quiet --no_stdin");
+  learn(all, 10);
+  BOOST_CHECK_THROW(save_to_memory(all), VW::vw_exception);
+  VW::finish(all);
+}
+
+BOOST_AUTO_TEST_CASE(model_io_threads_save_and_load_the_same_model)
+{
+  // 2^20 indices make four ranges of indices to save and to load.
+  for (const std::string resume : {"", " --save_resume"})
+  {
+    auto& trained = *VW::initialize("-b 20 --model_io_threads 1 --quiet --no_stdin" + resume);
+    learn(trained, 2000);
+    auto sequential = save_to_memory(trained);
+    trained.model_io_threads = 4;
+    auto threaded = save_to_memory(trained);
+    BOOST_CHECK(*sequential == *threaded);
+
+    io_buf model;
+    model.add_file(VW::io::create_buffer_view(threaded->data(), threaded->size()));
+    auto& loaded = *VW::initialize("--model_io_threads 4 --quiet --no_stdin", &model);
+    const auto& weights = loaded.weights.dense_weights;
+    const auto stride = weights.stride();
+    for (size_t i = 0; i <= weights.mask(); i++)
+    {
+      if (resume.empty() && i % stride != 0) { continue; }
+      BOOST_CHECK_EQUAL(weights[i], trained.weights.dense_weights[i]);
+    }
+    BOOST_CHECK_CLOSE(predict(loaded, "|a pos |b n3"), predict(trained, "|a pos |b n3"), FLOAT_TOL);
+
+    VW::finish(loaded);
+    VW::finish(trained);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(delta_checkpoints_only_save_the_blocks_changed)
+{
+  const std::vector<std::string> file_names = {"delta_test_0.model", "delta_test_1.model", "delta_test_2.model"};
+  auto& trained = *VW::initialize("-b 18 --delta_checkpoints 10 --save_resume --quiet --no_stdin");
+  learn(trained, 500);
+  VW::save_predictor(trained, file_names[0]);
+  const uint64_t full_id = trained.checkpoints.last_id;
+  // New features touch a few blocks.
+  for (const char* line : {"1 |c new", "-1 |c newer"})
+  {
+    auto* ex = VW::read_example(trained, line);
+    trained.learn(*ex);
+    VW::finish_example(trained, *ex);
+  }
+  VW::save_predictor(trained, file_names[1]);
+  learn(trained, 10);
+  VW::save_predictor(trained, file_names[2]);
+  BOOST_CHECK_EQUAL(trained.checkpoints.chain_length, 2);
+  BOOST_CHECK_LT(file_size(file_names[1]) * 4, file_size(file_names[0]));
+
+  auto& loaded = *VW::initialize(
+      "-i " + file_names[0] + " -i " + file_names[1] + " -i " + file_names[2] + " --quiet --no_stdin");
+  BOOST_CHECK(loaded.checkpoints.enabled());
+  BOOST_CHECK_EQUAL(loaded.checkpoints.last_id, trained.checkpoints.last_id);
+  BOOST_CHECK_NE(loaded.checkpoints.last_id, full_id);
+  const auto& weights = loaded.weights.dense_weights;
+  for (size_t i = 0; i <= weights.mask(); i++) { BOOST_CHECK_EQUAL(weights[i], trained.weights.dense_weights[i]); }
+  BOOST_CHECK_CLOSE(predict(loaded, "|a pos |b n3 |c new"), predict(trained, "|a pos |b n3 |c new"), FLOAT_TOL);
+
+  // The weights loaded are hashed, the next model saved is a delta of the last one loaded.
+  learn(loaded, 1);
+  const auto delta = save_to_memory(loaded);
+  BOOST_CHECK_EQUAL(loaded.checkpoints.chain_length, 3);
+  BOOST_CHECK_LT(delta->size() * 4, file_size(file_names[0]));
+  VW::finish(loaded);
+
+  // Deltas only go on top of the model they were saved after.
+  BOOST_CHECK_THROW(VW::initialize("-i " + file_names[0] + " -i " + file_names[2] + " --quiet --no_stdin"),
+      VW::vw_exception);
+  BOOST_CHECK_THROW(VW::initialize("-i " + file_names[1] + " --quiet --no_stdin"), VW::vw_exception);
+
+  VW::finish(trained);
+  for (const auto& file_name : file_names) { std::remove(file_name.c_str()); }
+}
+
+BOOST_AUTO_TEST_CASE(delta_checkpoints_chain_the_state_of_reductions)
+{
+  const std::vector<std::string> file_names = {"delta_boosting_0.model", "delta_boosting_1.model",
+      "delta_boosting_2.model"};
+  // Logistic boosting learns the weight of every weak learner, which each model saved in the chain holds in full.
+  auto& trained =
+      *VW::initialize("-b 18 --boosting 4 --alg logistic --delta_checkpoints 10 --save_resume --quiet --no_stdin");
+  for (const auto& file_name : file_names)
+  {
+    learn(trained, 100);
+    VW::save_predictor(trained, file_name);
+  }
+  BOOST_CHECK_EQUAL(trained.checkpoints.chain_length, 2);
+
+  auto& loaded = *VW::initialize(
+      "-i " + file_names[0] + " -i " + file_names[1] + " -i " + file_names[2] + " --quiet --no_stdin");
+  BOOST_CHECK_EQUAL(loaded.checkpoints.last_id, trained.checkpoints.last_id);
+  for (const char* line : {"|a pos |b n3", "|a neg |b n4", "|b n50"})
+  {
+    auto* trained_ex = VW::read_example(trained, line);
+    auto* loaded_ex = VW::read_example(loaded, line);
+    trained.predict(*trained_ex);
+    loaded.predict(*loaded_ex);
+    BOOST_CHECK_CLOSE(loaded_ex->partial_prediction, trained_ex->partial_prediction, FLOAT_TOL);
+    VW::finish_example(trained, *trained_ex);
+    VW::finish_example(loaded, *loaded_ex);
+  }
+  VW::finish(loaded);
+  VW::finish(trained);
+  for (const auto& file_name : file_names) { std::remove(file_name.c_str()); }
+}
+
+BOOST_AUTO_TEST_CASE(delta_checkpoints_conflicts_are_found_when_parsing_options)
+{
+  BOOST_CHECK_THROW(
+      VW::initialize("-b 12 --delta_checkpoints 10 --flat_model --quiet --no_stdin"), VW::vw_exception);
+  BOOST_CHECK_THROW(
+      VW::initialize("-b 12 --delta_checkpoints 10 --save_in_background --quiet --no_stdin"), VW::vw_exception);
+  BOOST_CHECK_THROW(
+      VW::initialize("-b 12 --delta_checkpoints 10 --sparse_weights --quiet --no_stdin"), VW::vw_exception);
+  // Reductions which add to their state on every read would be loaded once per model of the chain.
+  BOOST_CHECK_THROW(
+      VW::initialize("-b 12 --delta_checkpoints 10 --log_multi 3 --quiet --no_stdin"), VW::vw_exception);
+  BOOST_CHECK_THROW(
+      VW::initialize("-b 12 --delta_checkpoints 10 --marginal a --quiet --no_stdin"), VW::vw_exception);
+  BOOST_CHECK_THROW(VW::initialize("-b 12 --delta_checkpoints 10 --bfgs --quiet --no_stdin"), VW::vw_exception);
+}
+
+#ifdef __linux__
+BOOST_AUTO_TEST_CASE(save_in_background_saves_the_weights_as_of_the_fork)
+{
+  const std::string file_name = "background_snapshot.model";
+  auto& trained = *VW::initialize("-b 18 --weight_snapshots --save_in_background --save_resume --quiet --no_stdin");
+  learn(trained, 500);
+  auto& weights = trained.weights.dense_weights;
+  const std::vector<float> at_fork(weights.first(), weights.first() + weights.mask() + 1);
+  save_predictor(trained, file_name, 0);
+  // Learning goes on while the forked process writes the model.
+  learn(trained, 500);
+  BOOST_CHECK(!std::equal(at_fork.begin(), at_fork.end(), weights.first()));
+  // Waits for the forked process.
+  VW::finish(trained);
+
+  auto& loaded = *VW::initialize("-i " + file_name + " --quiet --no_stdin");
+  const auto& loaded_weights = loaded.weights.dense_weights;
+  BOOST_REQUIRE_EQUAL(loaded_weights.mask() + 1, at_fork.size());
+  size_t num_changed = 0;
+  for (size_t i = 0; i < at_fork.size(); i++) { num_changed += loaded_weights[i] != at_fork[i] ? 1 : 0; }
+  BOOST_CHECK_EQUAL(num_changed, 0);
+  VW::finish(loaded);
+  std::remove(file_name.c_str());
+}
+#endif
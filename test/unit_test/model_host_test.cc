@@ -0,0 +1,77 @@
+#ifndef STATIC_LINK_VW
+#  define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model_host.h"
+#include "shared_data.h"
+#include "vw.h"
+#include "vw_exception.h"
+
+namespace
+{
+float predict(vw& all, const std::string& line)
+{
+  auto* ex = VW::read_example(all, line);
+  all.predict(*ex);
+  const float prediction = ex->pred.scalar;
+  VW::finish_example(all, *ex);
+  return prediction;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(model_host_routes_examples_by_tenant)
+{
+  const size_t num_tenants = 6;
+  const size_t num_examples = 500;
+  std::vector<vw*> models;
+  for (size_t t = 0; t < num_tenants; t++) { models.push_back(VW::initialize("-b 12 --quiet --no_stdin")); }
+
+  std::atomic<size_t> results(0);
+  {
+    VW::model_host host(3, [&results](const std::string&, vw&, example&) { results++; });
+    for (size_t t = 0; t < num_tenants; t++) { host.add_model("tenant" + std::to_string(t), *models[t]); }
+    BOOST_CHECK_THROW(host.add_model("tenant0", *models[0]), VW::vw_exception);
+
+    // Two threads submit at once, each for half of the tenants. Tenant t only ever sees the label t.
+    std::vector<std::thread> routers;
+    for (size_t r = 0; r < 2; r++)
+    {
+      routers.emplace_back([&host, r] {
+        for (size_t i = 0; i < num_examples; i++)
+        {
+          for (size_t t = r; t < num_tenants; t += 2)
+          { host.submit(std::to_string(t) + " 'tenant" + std::to_string(t) + " |f a b c"); }
+        }
+      });
+    }
+    for (auto& router : routers) { router.join(); }
+    host.wait();
+    BOOST_CHECK_EQUAL(results.load(), num_tenants * num_examples);
+
+    BOOST_CHECK_THROW(host.submit("1 'nobody |f a"), VW::vw_exception);
+  }
+
+  for (size_t t = 0; t < num_tenants; t++)
+  {
+    BOOST_CHECK_EQUAL(models[t]->sd->example_number, num_examples);
+    BOOST_CHECK_SMALL(predict(*models[t], "|f a b c") - static_cast<float>(t), 0.5f);
+    VW::finish(*models[t]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(model_host_finds_the_tenant_in_the_tag)
+{
+  BOOST_CHECK_EQUAL(VW::model_host::tenant_of("1 'abc |f a"), "abc");
+  BOOST_CHECK_EQUAL(VW::model_host::tenant_of("1 2 'abc|f a"), "abc");
+  BOOST_CHECK_EQUAL(VW::model_host::tenant_of("'abc |f a"), "abc");
+  BOOST_CHECK_EQUAL(VW::model_host::tenant_of("1 |f 'a"), "");
+  BOOST_CHECK_EQUAL(VW::model_host::tenant_of("1 |f a"), "");
+}
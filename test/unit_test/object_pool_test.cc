@@ -6,9 +6,11 @@
 #include <boost/test/test_tools.hpp>
 
 #include "object_pool.h"
+#include "queue.h"
 
 #include <vector>
 #include <string>
+#include <thread>
 
 struct obj
 {
@@ -67,3 +69,34 @@ BOOST_AUTO_TEST_CASE(object_pool_test)
 
   pool.return_object(o2);
 }
+
+BOOST_AUTO_TEST_CASE(object_pool_handoff_between_threads_test)
+{
+  // Objects taken on one thread and returned on another, as examples are by the parser and learner.
+  VW::object_pool<obj> pool{4};
+  VW::ptr_queue<obj> queue{4};
+  constexpr int num_objects = 10000;
+
+  std::thread producer([&pool, &queue]() {
+    for (int i = 0; i < num_objects; i++)
+    {
+      auto* o = pool.get_object();
+      o->i = i;
+      queue.push(o);
+    }
+    queue.set_done();
+  });
+
+  int expected = 0;
+  obj* o;
+  while ((o = queue.pop()) != nullptr)
+  {
+    BOOST_CHECK_EQUAL(o->i, expected++);
+    BOOST_CHECK_EQUAL(pool.is_from_pool(o), true);
+    pool.return_object(o);
+  }
+  producer.join();
+
+  BOOST_CHECK_EQUAL(expected, num_objects);
+  BOOST_CHECK_EQUAL(pool.empty(), false);
+}
@@ -0,0 +1,215 @@
+#ifndef STATIC_LINK_VW
+#  define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cache.h"
+#include "io/io_adapter.h"
+#include "learner.h"
+#include "parser.h"
+#include "parse_example.h"
+#include "version.h"
+#include "vw.h"
+
+namespace
+{
+std::string make_text_data(size_t num_examples)
+{
+  std::stringstream data;
+  for (size_t i = 0; i < num_examples; i++)
+  {
+    data << (i % 3 == 0 ? "1" : "-1") << " 0.5 'tag" << i << " |a f" << (i % 17) << " g:" << (i % 5) * 0.25f << " |b h"
+         << (i % 11) << "\n";
+    // Sprinkle in empty lines so newline examples are exercised too.
+    if (i % 50 == 49) { data << "\n"; }
+  }
+  return data.str();
+}
+
+std::string make_json_data(size_t num_examples)
+{
+  std::stringstream data;
+  for (size_t i = 0; i < num_examples; i++)
+  {
+    data << R"({"_label":)" << (i % 3 == 0 ? 1 : -1) << R"(,"a":{"f)" << (i % 17) << R"(":1,"g":)" << (i % 5) * 0.25f
+         << R"(},"b":{"h)" << (i % 11) << R"(":1}})"
+         << "\n";
+  }
+  return data.str();
+}
+
+std::string make_adf_data(size_t num_sequences)
+{
+  std::stringstream data;
+  for (size_t i = 0; i < num_sequences; i++)
+  {
+    data << "shared |s u" << (i % 13) << "\n";
+    data << "0:" << (i % 2 == 0 ? 0.f : 1.f) << ":0.5 |a x" << (i % 7) << "\n";
+    data << "|a y" << (i % 5) << "\n";
+    data << "|a z" << (i % 3) << "\n\n";
+  }
+  return data.str();
+}
+
+std::vector<float> train_and_get_weights(const std::string& args, const std::string& data)
+{
+  auto& all = *VW::initialize(args + " --quiet --no_stdin");
+  if (!data.empty()) { all.example_parser->input->add_file(VW::io::create_buffer_view(data.data(), data.size())); }
+
+  VW::start_parser(all);
+  VW::LEARNER::generic_driver(all);
+  VW::end_parser(all);
+
+  std::vector<float> weights(all.weights.dense_weights.first(),
+      all.weights.dense_weights.first() + (all.length() << all.weights.stride_shift()));
+  VW::finish(all);
+  return weights;
+}
+// Writes the examples in the original cache format, a stream of records without a format version.
+void write_record_cache(const std::string& file_name, const std::string& args, const std::string& data)
+{
+  auto& all = *VW::initialize(args + " --quiet --no_stdin");
+  io_buf output;
+  output.add_file(VW::io::open_file_writer(file_name));
+
+  const size_t v_length = VW::version.to_string().length() + 1;
+  output.bin_write_fixed(reinterpret_cast<const char*>(&v_length), sizeof(v_length));
+  output.bin_write_fixed(VW::version.to_string().c_str(), v_length);
+  output.bin_write_fixed("c", 1);
+  output.bin_write_fixed(reinterpret_cast<const char*>(&all.num_bits), sizeof(all.num_bits));
+
+  std::stringstream lines(data);
+  std::string line;
+  while (std::getline(lines, line))
+  {
+    example ex;
+    VW::read_line(all, &ex, line.c_str());
+    VW::write_example_to_cache(output, &ex, all.example_parser->lbl_parser, all.parse_mask);
+  }
+  output.flush();
+  output.close_files();
+  VW::finish(all);
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(parallel_parse_text_matches_serial)
+{
+  const auto data = make_text_data(2000);
+  const auto serial = train_and_get_weights("-b 12", data);
+  const auto parallel = train_and_get_weights("-b 12 --parse_threads 3 --ring_size 64", data);
+  BOOST_CHECK_EQUAL_COLLECTIONS(serial.begin(), serial.end(), parallel.begin(), parallel.end());
+}
+
+BOOST_AUTO_TEST_CASE(parallel_parse_json_matches_serial)
+{
+  const auto data = make_json_data(2000);
+  const auto serial = train_and_get_weights("-b 12 --json --chain_hash", data);
+  const auto parallel = train_and_get_weights("-b 12 --json --chain_hash --parse_threads 4", data);
+  BOOST_CHECK_EQUAL_COLLECTIONS(serial.begin(), serial.end(), parallel.begin(), parallel.end());
+}
+
+BOOST_AUTO_TEST_CASE(parallel_parse_respects_max_examples)
+{
+  const auto data = make_text_data(2000);
+  const auto serial = train_and_get_weights("-b 12 --examples 123", data);
+  const auto parallel = train_and_get_weights("-b 12 --examples 123 --parse_threads 2", data);
+  BOOST_CHECK_EQUAL_COLLECTIONS(serial.begin(), serial.end(), parallel.begin(), parallel.end());
+}
+
+BOOST_AUTO_TEST_CASE(batched_handoff_keeps_input_order)
+{
+  const auto data = make_text_data(1000);
+  auto& all = *VW::initialize("--quiet --no_stdin --ring_size 128");
+  all.example_parser->input->add_file(VW::io::create_buffer_view(data.data(), data.size()));
+  VW::start_parser(all);
+
+  size_t num_tagged = 0;
+  example* ex;
+  while ((ex = VW::get_example(all.example_parser)) != nullptr)
+  {
+    if (!ex->tag.empty())
+    {
+      BOOST_CHECK_EQUAL(std::string(ex->tag.begin(), ex->tag.size()), "tag" + std::to_string(num_tagged));
+      num_tagged++;
+    }
+    VW::finish_example(all, *ex);
+  }
+
+  VW::end_parser(all);
+  BOOST_CHECK_EQUAL(num_tagged, 1000);
+  VW::finish(all);
+}
+
+BOOST_AUTO_TEST_CASE(batched_handoff_keeps_examples_in_flight_near_ring_size)
+{
+  const auto data = make_text_data(2000);
+  auto& all = *VW::initialize("--quiet --no_stdin --ring_size 128");
+  all.example_parser->input->add_file(VW::io::create_buffer_view(data.data(), data.size()));
+  VW::start_parser(all);
+
+  // While the learner holds on to its batch, parsing stops after the one batch that goes past ring_size and the one
+  // being filled.
+  example* ex = VW::get_example(all.example_parser);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  BOOST_CHECK_LE(all.example_parser->end_parsed_examples.load(), 3 * 128);
+
+  size_t num_examples = 0;
+  for (; ex != nullptr; ex = VW::get_example(all.example_parser))
+  {
+    if (!ex->end_pass) { num_examples++; }
+    VW::finish_example(all, *ex);
+  }
+  VW::end_parser(all);
+  BOOST_CHECK_EQUAL(num_examples, 2000);
+  BOOST_CHECK_EQUAL(all.example_parser->ready_examples.load(), 0);
+  VW::finish(all);
+}
+
+BOOST_AUTO_TEST_CASE(batch_size_does_not_change_learning)
+{
+  const auto text = make_text_data(2000);
+  const auto unbatched = train_and_get_weights("-b 12 --ring_size 1", text);
+  const auto batched = train_and_get_weights("-b 12 --ring_size 4096", text);
+  BOOST_CHECK_EQUAL_COLLECTIONS(unbatched.begin(), unbatched.end(), batched.begin(), batched.end());
+
+  const auto adf = make_adf_data(500);
+  const auto unbatched_adf = train_and_get_weights("-b 12 --cb_explore_adf --ring_size 2", adf);
+  const auto batched_adf = train_and_get_weights("-b 12 --cb_explore_adf --ring_size 4096", adf);
+  BOOST_CHECK_EQUAL_COLLECTIONS(unbatched_adf.begin(), unbatched_adf.end(), batched_adf.begin(), batched_adf.end());
+}
+
+BOOST_AUTO_TEST_CASE(cache_formats_train_identically)
+{
+  // Without empty lines, which only the text reader turns into newline examples.
+  std::stringstream data;
+  for (size_t i = 0; i < 1000; i++)
+  {
+    data << (i % 3 == 0 ? "1" : "-1") << " |a f" << (i % 17) << " g:" << (i % 5) * 0.25f << " |b h" << (i % 11)
+         << "\n";
+  }
+
+  const std::string args = "-b 12 --holdout_off --passes 2";
+  // The first run writes a blocked cache which all following ones read.
+  train_and_get_weights(args + " -k --cache_file parallel_parse_blocks.cache", data.str());
+  write_record_cache("parallel_parse_records.cache", "-b 12", data.str());
+
+  const auto blocks = train_and_get_weights(args + " --cache_file parallel_parse_blocks.cache", "");
+  const auto records = train_and_get_weights(args + " --cache_file parallel_parse_records.cache", "");
+  const auto parallel_blocks =
+      train_and_get_weights(args + " --cache_file parallel_parse_blocks.cache --parse_threads 3", "");
+  BOOST_CHECK_EQUAL_COLLECTIONS(blocks.begin(), blocks.end(), records.begin(), records.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(blocks.begin(), blocks.end(), parallel_blocks.begin(), parallel_blocks.end());
+
+  std::remove("parallel_parse_blocks.cache");
+  std::remove("parallel_parse_records.cache");
+}
@@ -0,0 +1,69 @@
+#ifndef STATIC_LINK_VW
+#  define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "io/io_adapter.h"
+#include "parallel_train.h"
+#include "parser.h"
+#include "shared_data.h"
+#include "vw.h"
+#include "vw_exception.h"
+
+namespace
+{
+std::string make_separable_data(size_t num_examples)
+{
+  std::stringstream data;
+  for (size_t i = 0; i < num_examples; i++)
+  {
+    data << (i % 2 == 0 ? "1 |a pos" : "-1 |a neg") << " |b n" << (i % 13) << "\n";
+  }
+  return data.str();
+}
+
+float predict(vw& all, const char* line)
+{
+  auto* ex = VW::read_example(all, line);
+  all.predict(*ex);
+  const float prediction = ex->pred.scalar;
+  VW::finish_example(all, *ex);
+  return prediction;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(train_threads_see_every_example_once_per_pass)
+{
+  const size_t num_examples = 1500;
+  const auto data = make_separable_data(num_examples);
+  auto& all = *VW::initialize(
+      "-b 12 --holdout_off --passes 3 --train_threads 3 -k --cache_file parallel_train.cache --quiet --no_stdin");
+  all.example_parser->input->add_file(VW::io::create_buffer_view(data.data(), data.size()));
+
+  VW::train_in_threads(all);
+  BOOST_CHECK_EQUAL(all.train_threads, 1);
+  BOOST_CHECK(all.all_reduce == nullptr);
+  // The counters of all learners were summed up by the first one.
+  BOOST_CHECK_EQUAL(all.sd->example_number, 3 * num_examples);
+  BOOST_CHECK_CLOSE(all.sd->weighted_labeled_examples, 3. * num_examples, 0.001);
+
+  BOOST_CHECK_GT(predict(all, "|a pos"), 0.5f);
+  BOOST_CHECK_LT(predict(all, "|a neg"), -0.5f);
+  VW::finish(all);
+  std::remove("parallel_train.cache");
+}
+
+BOOST_AUTO_TEST_CASE(train_threads_need_a_cache)
+{
+  const auto data = make_separable_data(10);
+  auto& all = *VW::initialize("--train_threads 2 --quiet --no_stdin");
+  all.example_parser->input->add_file(VW::io::create_buffer_view(data.data(), data.size()));
+  BOOST_CHECK_THROW(VW::train_in_threads(all), VW::vw_exception);
+  VW::finish(all);
+}
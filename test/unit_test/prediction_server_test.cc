@@ -0,0 +1,132 @@
+#ifndef STATIC_LINK_VW
+#  define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#ifdef __linux__
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+
+#  include <algorithm>
+#  include <sstream>
+#  include <string>
+#  include <thread>
+#  include <vector>
+
+#  include "io/io_adapter.h"
+#  include "learner.h"
+#  include "parser.h"
+#  include "prediction_server.h"
+#  include "vw.h"
+
+namespace
+{
+std::string make_line(size_t i)
+{
+  std::stringstream line;
+  line << (i % 2 == 0 ? "1 |a pos" : "-1 |a neg") << " |b n" << (i % 101) << " m" << (i % 37);
+  return line.str();
+}
+
+float predict(vw& all, const std::string& line)
+{
+  auto* ex = VW::read_example(all, line);
+  all.predict(*ex);
+  const float prediction = ex->pred.scalar;
+  VW::finish_example(all, *ex);
+  return prediction;
+}
+
+int listen_on_loopback(uint16_t& port)
+{
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;
+  BOOST_REQUIRE_EQUAL(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+  BOOST_REQUIRE_EQUAL(listen(fd, SOMAXCONN), 0);
+  socklen_t size = sizeof(address);
+  getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size);
+  port = ntohs(address.sin_port);
+  return fd;
+}
+
+// Sends all lines in pieces cut across line ends, then reads back everything until the server closes.
+std::string query(uint16_t port, const std::string& lines)
+{
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+  {
+    close(fd);
+    return "";
+  }
+  for (size_t sent = 0; sent < lines.size();)
+  {
+    const auto n = send(fd, lines.data() + sent, std::min<size_t>(lines.size() - sent, 37), MSG_NOSIGNAL);
+    if (n <= 0) break;
+    sent += static_cast<size_t>(n);
+  }
+  shutdown(fd, SHUT_WR);
+  std::string reply;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) { reply.append(buffer, static_cast<size_t>(n)); }
+  close(fd);
+  return reply;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(prediction_server_answers_every_line_in_order)
+{
+  const size_t num_clients = 8;
+  const size_t num_lines = 200;
+  auto& all = *VW::initialize("-b 16 --quiet --no_stdin");
+  std::string data;
+  for (size_t i = 0; i < 1000; i++) { data += make_line(i) + "\n"; }
+  all.example_parser->input->add_file(VW::io::create_buffer_view(data.data(), data.size()));
+  VW::start_parser(all);
+  VW::LEARNER::generic_driver(all);
+  VW::end_parser(all);
+
+  uint16_t port = 0;
+  const int listen_socket = listen_on_loopback(port);
+  {
+    VW::prediction_server server(all, listen_socket, 4);
+    std::thread loop([&server] { server.run(); });
+
+    std::vector<std::string> replies(num_clients);
+    std::vector<std::thread> clients;
+    for (size_t c = 0; c < num_clients; c++)
+    {
+      clients.emplace_back([&replies, port, c] {
+        std::string lines;
+        for (size_t i = 0; i < num_lines; i++) { lines += make_line(c + i) + "\n"; }
+        replies[c] = query(port, lines);
+      });
+    }
+    for (auto& client : clients) { client.join(); }
+    server.stop();
+    loop.join();
+
+    for (size_t c = 0; c < num_clients; c++)
+    {
+      std::istringstream reply(replies[c]);
+      float prediction;
+      size_t i = 0;
+      for (; reply >> prediction; i++) { BOOST_CHECK_CLOSE(prediction, predict(all, make_line(c + i)), 0.01); }
+      BOOST_CHECK_EQUAL(i, num_lines);
+    }
+  }
+  close(listen_socket);
+  VW::finish(all);
+}
+#endif
@@ -0,0 +1,71 @@
+#ifndef STATIC_LINK_VW
+#  define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include "queue.h"
+
+#include <numeric>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(ptr_queue_fifo_and_done_test)
+{
+  std::vector<int> values{1, 2, 3};
+  VW::ptr_queue<int> queue{3};
+  for (auto& value : values) { queue.push(&value); }
+  BOOST_CHECK_EQUAL(queue.size(), 3);
+
+  BOOST_CHECK_EQUAL(queue.pop(), &values[0]);
+  queue.set_done();
+  // Items pushed before set_done are still handed out.
+  BOOST_CHECK_EQUAL(queue.pop(), &values[1]);
+  BOOST_CHECK_EQUAL(queue.pop(), &values[2]);
+  BOOST_CHECK_EQUAL(queue.size(), 0);
+  BOOST_CHECK(queue.pop() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(ptr_queue_many_producers_many_consumers_test)
+{
+  constexpr size_t num_producers = 3;
+  constexpr size_t num_consumers = 3;
+  constexpr size_t items_per_producer = 20000;
+
+  std::vector<size_t> items(num_producers * items_per_producer);
+  std::iota(items.begin(), items.end(), 0);
+  // A small ring so both sides regularly have to wait for each other.
+  VW::ptr_queue<size_t> queue{8};
+
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < num_producers; p++)
+  {
+    producers.emplace_back([&queue, &items, p]() {
+      for (size_t i = 0; i < items_per_producer; i++) { queue.push(&items[p * items_per_producer + i]); }
+    });
+  }
+
+  std::vector<size_t> sums(num_consumers, 0);
+  std::vector<size_t> counts(num_consumers, 0);
+  std::vector<std::thread> consumers;
+  for (size_t c = 0; c < num_consumers; c++)
+  {
+    consumers.emplace_back([&queue, &sums, &counts, c]() {
+      size_t* item;
+      while ((item = queue.pop()) != nullptr)
+      {
+        sums[c] += *item;
+        counts[c]++;
+      }
+    });
+  }
+
+  for (auto& producer : producers) { producer.join(); }
+  queue.set_done();
+  for (auto& consumer : consumers) { consumer.join(); }
+
+  BOOST_CHECK_EQUAL(std::accumulate(counts.begin(), counts.end(), static_cast<size_t>(0)), items.size());
+  BOOST_CHECK_EQUAL(std::accumulate(sums.begin(), sums.end(), static_cast<size_t>(0)),
+      std::accumulate(items.begin(), items.end(), static_cast<size_t>(0)));
+}
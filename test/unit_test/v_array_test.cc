@@ -297,3 +297,32 @@ BOOST_AUTO_TEST_CASE(v_array_insert_range_empty_end)
   BOOST_CHECK_EQUAL(1, list[0]);
   BOOST_CHECK_EQUAL(2, list[1]);
 }
+
+BOOST_AUTO_TEST_CASE(v_array_borrowed_storage)
+{
+  int buffer[4];
+  v_array<int> list;
+  list.push_back(1);
+  list.use_storage(buffer, 4);
+  BOOST_CHECK(list.borrows_storage());
+  BOOST_CHECK_EQUAL(list.begin(), &buffer[0]);
+  list.push_back(2);
+  list.clear();
+  list.push_back(3);
+  BOOST_CHECK_EQUAL(buffer[0], 3);
+
+  // Growing past the buffer leaves it alone.
+  for (int i = 0; i < 4; i++) { list.push_back(i + 4); }
+  BOOST_CHECK(!list.borrows_storage());
+  BOOST_CHECK_EQUAL(std::size_t(5), list.size());
+  BOOST_CHECK_EQUAL(3, list[0]);
+  BOOST_CHECK_EQUAL(7, list[4]);
+
+  list.clear();
+  list.push_back(8);
+  list.use_storage(buffer, 4);
+  BOOST_CHECK_EQUAL(8, buffer[0]);
+  list.release_borrowed_storage();
+  BOOST_CHECK(list.empty());
+  BOOST_CHECK_EQUAL(std::size_t(0), list.capacity());
+}
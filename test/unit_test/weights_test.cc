@@ -26,3 +26,132 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_default_function_weight_initialization_stride
   }
 }
 
+
+BOOST_AUTO_TEST_CASE(test_dense_weights_allocated_for_every_page_and_numa_policy)
+{
+  for (auto pages : {VW::page_policy::small, VW::page_policy::transparent_huge, VW::page_policy::explicit_huge})
+  {
+    for (auto numa : {VW::numa_policy::none, VW::numa_policy::interleave, VW::numa_policy::first_touch})
+    {
+      VW::weight_allocation allocation;
+      allocation.pages = pages;
+      allocation.numa = numa;
+      dense_parameters w(1 << 16, STRIDE_SHIFT, allocation);
+      BOOST_REQUIRE(w.not_null());
+      for (auto iter = w.begin(); iter != w.end(); ++iter) { BOOST_CHECK_EQUAL(*iter, 0.f); }
+      for (size_t i = 0; i <= w.mask(); i++) { w[i] = 1.f * i; }
+      BOOST_CHECK_EQUAL(w[w.mask()], 1.f * w.mask());
+
+      dense_parameters copy;
+      copy.shallow_copy(w);
+      BOOST_CHECK_EQUAL(copy[7], 7.f);
+#ifdef __linux__
+      const auto report = w.pages();
+      BOOST_CHECK_GT(report.page_size, 0);
+      BOOST_CHECK_GT(report.resident_bytes, 0);
+      BOOST_CHECK_LE(report.huge_bytes, report.resident_bytes);
+#endif
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_unknown_page_and_numa_policies_throw)
+{
+  BOOST_CHECK(VW::parse_page_policy("transparent") == VW::page_policy::transparent_huge);
+  BOOST_CHECK(VW::parse_numa_policy("first_touch") == VW::numa_policy::first_touch);
+  BOOST_CHECK_THROW(VW::parse_page_policy("gigantic"), VW::vw_exception);
+  BOOST_CHECK_THROW(VW::parse_numa_policy("local"), VW::vw_exception);
+}
+
+#ifdef __linux__
+// Snapshots keep the weights as they were, across the three ways of taking one: the first, one after the last was
+// released, and one while the last is still alive.
+BOOST_AUTO_TEST_CASE(test_dense_weight_snapshots_stay_frozen)
+{
+  VW::weight_allocation allocation;
+  allocation.snapshots = true;
+  dense_parameters w(1 << 16, STRIDE_SHIFT, allocation);
+  for (size_t i = 0; i <= w.mask(); i++) { w[i] = 1.f; }
+
+  auto first = w.snapshot();
+  for (size_t i = 0; i <= w.mask(); i += 2) { w[i] = 2.f; }
+  BOOST_CHECK_EQUAL(first->weights()[0], 1.f);
+  BOOST_CHECK_EQUAL(first->weights()[w.mask()], 1.f);
+  BOOST_CHECK_EQUAL(first->weights().mask(), w.mask());
+  BOOST_CHECK_EQUAL(w[0], 2.f);
+  BOOST_CHECK_EQUAL(w[1], 1.f);
+
+  first.reset();
+  auto second = w.snapshot();
+  w[1] = 3.f;
+  BOOST_CHECK_EQUAL(second->weights()[0], 2.f);
+  BOOST_CHECK_EQUAL(second->weights()[1], 1.f);
+
+  auto third = w.snapshot();
+  w[0] = 4.f;
+  BOOST_CHECK_EQUAL(second->weights()[0], 2.f);
+  BOOST_CHECK_EQUAL(second->weights()[1], 1.f);
+  BOOST_CHECK_EQUAL(third->weights()[0], 2.f);
+  BOOST_CHECK_EQUAL(third->weights()[1], 3.f);
+  BOOST_CHECK_EQUAL(w[0], 4.f);
+  BOOST_CHECK_EQUAL(w[1], 3.f);
+  for (size_t i = 2; i <= w.mask(); i++) { BOOST_CHECK_EQUAL(third->weights()[i], w[i]); }
+}
+
+BOOST_AUTO_TEST_CASE(test_dense_weight_snapshots_need_a_memory_file)
+{
+  dense_parameters w(1 << 10, STRIDE_SHIFT);
+  BOOST_CHECK_THROW(w.snapshot(), VW::vw_exception);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(test_sparse_weights_keep_their_values_while_the_table_grows)
+{
+  const size_t num_indices = 20000;
+  sparse_parameters w(static_cast<size_t>(1) << 30, STRIDE_SHIFT);
+  size_t defaults = 0;
+  w.set_default([&defaults](weight* weights, uint64_t index) {
+    weights[3] = 1.f * index;
+    defaults++;
+  });
+  for (size_t i = 0; i < num_indices; i++) { (&w.strided_index(i * 7919))[1] = 1.f * i; }
+  BOOST_CHECK_EQUAL(w.size(), num_indices);
+  BOOST_CHECK_EQUAL(defaults, num_indices);
+
+  for (size_t i = 0; i < num_indices; i++)
+  {
+    weight* weights = &w.strided_index(i * 7919);
+    BOOST_CHECK_EQUAL(weights[0], 0.f);
+    BOOST_CHECK_EQUAL(weights[1], 1.f * i);
+    BOOST_CHECK_EQUAL(weights[3], 1.f * ((i * 7919) << STRIDE_SHIFT));
+  }
+  BOOST_CHECK_EQUAL(defaults, num_indices);
+
+  // The iterators visit every index once.
+  size_t visited = 0;
+  for (auto iter = w.begin(); iter != w.end(); ++iter)
+  {
+    BOOST_CHECK_EQUAL((&(*iter))[3], 1.f * iter.index());
+    visited++;
+  }
+  BOOST_CHECK_EQUAL(visited, num_indices);
+  visited = 0;
+  for (auto iter = w.cbegin(); iter != w.cend(); ++iter) { visited++; }
+  BOOST_CHECK_EQUAL(visited, num_indices);
+}
+
+BOOST_AUTO_TEST_CASE(test_sparse_weights_shallow_copy_shares_the_weights)
+{
+  sparse_parameters w(LENGTH, STRIDE_SHIFT);
+  w.strided_index(1) = 1.f;
+  {
+    sparse_parameters copy;
+    copy.shallow_copy(w);
+    BOOST_CHECK(copy.seeded());
+    BOOST_CHECK_EQUAL(copy.strided_index(1), 1.f);
+    copy.strided_index(2) = 2.f;
+  }
+  // Weights added through the copy outlive it.
+  BOOST_CHECK_EQUAL(w.strided_index(2), 2.f);
+  BOOST_CHECK_EQUAL(w.size(), 2);
+}
@@ -300,7 +300,7 @@ void to_flat::convert_txt_to_flat(vw& all)
   MultiExampleBuilder multi_ex_builder;
   ExampleBuilder ex_builder;
 
-  example* ae = all.example_parser->ready_parsed_examples.pop();
+  example* ae = VW::get_example(all.example_parser);
 
   while (ae != nullptr && !ae->end_pass)
   {
@@ -419,7 +419,7 @@ void to_flat::convert_txt_to_flat(vw& all)
         ex_builder.clear();
         _multi_ex_index++;
         _examples++;
-        ae = all.example_parser->ready_parsed_examples.pop();
+        ae = VW::get_example(all.example_parser);
         continue;
       }
       else
@@ -437,7 +437,7 @@ void to_flat::convert_txt_to_flat(vw& all)
 
     write_to_file(collection, all.l->is_multiline, multi_ex_builder, ex_builder, outfile);
 
-    ae = all.example_parser->ready_parsed_examples.pop();
+    ae = VW::get_example(all.example_parser);
   }
 
   if (collection && _collection_count > 0)
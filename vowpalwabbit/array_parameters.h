@@ -4,9 +4,13 @@
 
 #pragma once
 
-#include <unordered_map>
+#include <atomic>
 #include <cstddef>
+#include <cstring>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #ifndef _WIN32
 #  define NOMINMAX
@@ -22,15 +26,268 @@
 #include "array_parameters_dense.h"
 #include "vw_exception.h"
 
-class sparse_parameters;
-typedef std::unordered_map<uint64_t, weight*> weight_map;
+// Open addressing hash table holding the weights of sparse_parameters. A slot is the index + 1 of its weights, 0
+// for an empty slot, followed by the stride weights themselves, so that a lookup reads a single cache line for
+// strides up to 8 instead of chasing a bucket, a node and a separate allocation. Collisions are resolved by linear
+// probing.
+//
+// Lookups never lock and new indices are inserted with a compare and swap of their slot, so any number of threads
+// may look up and add weights at once. A table holds up to 70% of its slots and then grows:
+// - By default it doubles and moves the weights there. As with std::vector, a reference to a weight is then only
+//   valid until the next index not in the table yet is looked up, and no other thread may use the table meanwhile.
+// - Once concurrent, a table twice as large is added instead and the full ones stay where they are, so references
+//   stay valid and the threads never wait for each other. Lookups go through the tables from the newest, which
+//   holds about half of the indices, to the oldest.
+class sparse_weight_table
+{
+private:
+  static constexpr size_t initial_capacity = 1024;
+  // The doubling tables of a concurrent table, enough for 2^57 slots.
+  static constexpr size_t max_generations = 48;
+  // Set in the reserved count of a table which must not get any more indices.
+  static constexpr uint64_t sealed = static_cast<uint64_t>(1) << 63;
+
+  struct generation
+  {
+    unsigned char* slots;
+    size_t capacity;  // number of slots, a power of two
+    uint32_t hash_shift;  // 64 - log2(capacity)
+    std::atomic<uint64_t> reserved;  // inserts into the table started, used to keep it below 70%
+    std::atomic<uint64_t> published;  // inserts into the table finished
+  };
+
+  std::atomic<generation*> _generations[max_generations];
+  std::atomic<size_t> _num_generations;
+  std::atomic<size_t> _size;  // number of used slots
+  size_t _slot_bytes;
+  uint32_t _stride;
+  bool _concurrent;
+  std::mutex _grow_lock;
+
+  // Fibonacci hashing, the indices are already hashes but their low bits are mostly the offset within the stride.
+  static inline size_t home_slot(const generation& g, uint64_t index)
+  {
+    return static_cast<size_t>((index * 0x9E3779B97F4A7C15ULL) >> g.hash_shift);
+  }
+
+  inline std::atomic<uint64_t>& tag(const generation& g, size_t slot) const
+  {
+    return *reinterpret_cast<std::atomic<uint64_t>*>(g.slots + slot * _slot_bytes);
+  }
+
+  inline weight* weights(const generation& g, size_t slot) const
+  {
+    return reinterpret_cast<weight*>(g.slots + slot * _slot_bytes + sizeof(uint64_t));
+  }
+
+  generation* new_generation(size_t capacity) const
+  {
+    auto* g = new generation;
+    g->capacity = capacity;
+    g->hash_shift = 64;
+    for (size_t c = capacity; c > 1; c >>= 1) { g->hash_shift--; }
+    g->reserved.store(0);
+    g->published.store(0);
+    g->slots = calloc_or_throw<unsigned char>(capacity * _slot_bytes);
+    return g;
+  }
+
+  static void delete_generation(generation* g)
+  {
+    free(g->slots);
+    delete g;
+  }
 
+  // The weights of the index tagged tag in g, nullptr if g does not have them.
+  inline weight* find(const generation& g, uint64_t tag_to_find) const
+  {
+    for (size_t slot = home_slot(g, tag_to_find - 1);; slot = (slot + 1) & (g.capacity - 1))
+    {
+      const auto& slot_tag = tag(g, slot);
+      uint64_t current = slot_tag.load(std::memory_order_acquire);
+      if (current == 0) { return nullptr; }
+      if ((current & ~busy) == tag_to_find)
+      {
+        while ((current & busy) != 0) { current = slot_tag.load(std::memory_order_acquire); }
+        return weights(g, slot);
+      }
+    }
+  }
+
+  static bool reserve(generation& g)
+  {
+    const uint64_t limit = g.capacity / 10 * 7;
+    uint64_t reserved = g.reserved.load(std::memory_order_relaxed);
+    do
+    {
+      if (reserved >= limit) { return false; }  // also true once sealed
+    } while (!g.reserved.compare_exchange_weak(reserved, reserved + 1, std::memory_order_relaxed));
+    return true;
+  }
+
+  // Takes the first free slot of g on the way from the home slot of the index, unless another thread takes one for
+  // the same index first.
+  template <typename InitT>
+  weight* claim(generation& g, uint64_t new_tag, InitT& init)
+  {
+    for (size_t slot = home_slot(g, new_tag - 1);; slot = (slot + 1) & (g.capacity - 1))
+    {
+      auto& slot_tag = tag(g, slot);
+      uint64_t current = 0;
+      if (slot_tag.compare_exchange_strong(current, new_tag | busy, std::memory_order_acq_rel))
+      {
+        weight* w = weights(g, slot);
+        init(w, new_tag - 1);
+        slot_tag.store(new_tag, std::memory_order_release);
+        _size.fetch_add(1, std::memory_order_relaxed);
+        return w;
+      }
+      if ((current & ~busy) == new_tag)
+      {
+        while ((current & busy) != 0) { current = slot_tag.load(std::memory_order_acquire); }
+        return weights(g, slot);
+      }
+    }
+  }
+
+  void grow(size_t seen_generations)
+  {
+    std::lock_guard<std::mutex> lock(_grow_lock);
+    if (_num_generations.load(std::memory_order_acquire) != seen_generations) { return; }
+    generation* full = _generations[seen_generations - 1].load(std::memory_order_relaxed);
+    // Wait for the inserts still going into the full table, so that an index inserted there is seen by every thread
+    // that could insert it into the next one.
+    const uint64_t reserved = full->reserved.fetch_or(sealed, std::memory_order_acq_rel) & ~sealed;
+    while (full->published.load(std::memory_order_acquire) < reserved) { std::this_thread::yield(); }
+
+    generation* next = new_generation(full->capacity * 2);
+    if (_concurrent)
+    {
+      _generations[seen_generations].store(next, std::memory_order_release);
+      _num_generations.store(seen_generations + 1, std::memory_order_release);
+      return;
+    }
+
+    for (size_t i = 0; i < full->capacity; i++)
+    {
+      const uint64_t full_tag = tag(*full, i).load(std::memory_order_relaxed);
+      if (full_tag == 0) { continue; }
+      size_t slot = home_slot(*next, full_tag - 1);
+      while (tag(*next, slot).load(std::memory_order_relaxed) != 0) { slot = (slot + 1) & (next->capacity - 1); }
+      memcpy(next->slots + slot * _slot_bytes, full->slots + i * _slot_bytes, _slot_bytes);
+    }
+    next->reserved.store(_size.load(std::memory_order_relaxed));
+    next->published.store(_size.load(std::memory_order_relaxed));
+    _generations[0].store(next, std::memory_order_release);
+    delete_generation(full);
+  }
+
+public:
+  // Set in the tag of a slot while its weights are being initialized.
+  static constexpr uint64_t busy = static_cast<uint64_t>(1) << 63;
+
+  explicit sparse_weight_table(uint32_t stride)
+      : _num_generations(1)
+      , _size(0)
+      , _slot_bytes((sizeof(uint64_t) + stride * sizeof(weight) + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1))
+      , _stride(stride)
+      , _concurrent(false)
+  {
+    for (auto& g : _generations) { g.store(nullptr); }
+    _generations[0].store(new_generation(initial_capacity));
+  }
+
+  sparse_weight_table(const sparse_weight_table&) = delete;
+  sparse_weight_table& operator=(const sparse_weight_table&) = delete;
+
+  ~sparse_weight_table()
+  {
+    for (size_t i = 0; i < _num_generations.load(); i++) { delete_generation(_generations[i].load()); }
+  }
+
+  // Returns the weights of index, adding weights initialized by init(weight*, index) for it if it has none yet.
+  template <typename InitT>
+  inline weight* find_or_insert(uint64_t index, InitT&& init)
+  {
+    const uint64_t index_tag = index + 1;
+    for (;;)
+    {
+      const size_t num_generations = _num_generations.load(std::memory_order_acquire);
+      for (size_t i = num_generations; i > 0; i--)
+      {
+        weight* w = find(*_generations[i - 1].load(std::memory_order_acquire), index_tag);
+        if (w != nullptr) { return w; }
+      }
+
+      generation& newest = *_generations[num_generations - 1].load(std::memory_order_acquire);
+      if (reserve(newest))
+      {
+        weight* w = claim(newest, index_tag, init);
+        newest.published.fetch_add(1, std::memory_order_release);
+        return w;
+      }
+      grow(num_generations);
+    }
+  }
+
+  // Makes the table grow without moving weights from now on, see above. To be called before the threads start.
+  void make_concurrent() { _concurrent = true; }
+  bool concurrent() const { return _concurrent; }
+
+  size_t size() const { return _size.load(std::memory_order_relaxed); }
+  uint32_t stride() const { return _stride; }
+  size_t slot_bytes() const { return _slot_bytes; }
+
+  size_t capacity() const
+  {
+    size_t capacity = 0;
+    for (size_t i = 0; i < num_generations(); i++) { capacity += _generations[i].load()->capacity; }
+    return capacity;
+  }
+
+  size_t num_generations() const { return _num_generations.load(std::memory_order_acquire); }
+  unsigned char* slots_begin(size_t generation) const { return _generations[generation].load()->slots; }
+  unsigned char* slots_end(size_t generation) const
+  {
+    const auto* g = _generations[generation].load();
+    return g->slots + g->capacity * _slot_bytes;
+  }
+};
+
+// Goes through the used slots of a sparse_weight_table, in no particular order. Not meant to run while other threads
+// add weights.
 template <typename T>
 class sparse_iterator
 {
 private:
-  weight_map::iterator _iter;
-  uint32_t _stride;
+  const sparse_weight_table* _table;
+  size_t _generation;
+  unsigned char* _current;  // nullptr at the end
+  unsigned char* _end;
+  size_t _slot_bytes;
+
+  uint64_t tag() const { return reinterpret_cast<const std::atomic<uint64_t>*>(_current)->load(); }
+
+  void skip_empty()
+  {
+    while (_current != nullptr && (_current == _end || tag() == 0))
+    {
+      if (_current != _end)
+      {
+        _current += _slot_bytes;
+        continue;
+      }
+      if (++_generation < _table->num_generations())
+      {
+        _current = _table->slots_begin(_generation);
+        _end = _table->slots_end(_generation);
+      }
+      else
+      {
+        _current = nullptr;
+      }
+    }
+  }
 
 public:
   typedef std::forward_iterator_tag iterator_category;
@@ -39,51 +296,55 @@ public:
   typedef T* pointer;
   typedef T& reference;
 
-  sparse_iterator(weight_map::iterator& iter, uint32_t stride) : _iter(iter), _stride(stride) {}
+  // Starts at the first used slot, or at the end with at_end.
+  sparse_iterator(const sparse_weight_table& table, bool at_end)
+      : _table(&table), _generation(0), _current(nullptr), _end(nullptr), _slot_bytes(table.slot_bytes())
+  {
+    if (at_end) { return; }
+    _current = table.slots_begin(0);
+    _end = table.slots_end(0);
+    skip_empty();
+  }
 
   sparse_iterator& operator=(const sparse_iterator& other) = default;
   sparse_iterator(const sparse_iterator& other) = default;
   sparse_iterator& operator=(sparse_iterator&& other) = default;
   sparse_iterator(sparse_iterator&& other) = default;
 
-  uint64_t index() { return _iter->first; }
+  uint64_t index() { return (tag() & ~sparse_weight_table::busy) - 1; }
 
-  T& operator*() { return *(_iter->second); }
+  T& operator*() { return *reinterpret_cast<T*>(_current + sizeof(uint64_t)); }
 
   sparse_iterator& operator++()
   {
-    _iter++;
+    _current += _slot_bytes;
+    skip_empty();
     return *this;
   }
 
-  bool operator==(const sparse_iterator& rhs) const { return _iter == rhs._iter; }
-  bool operator!=(const sparse_iterator& rhs) const { return _iter != rhs._iter; }
+  bool operator==(const sparse_iterator& rhs) const { return _current == rhs._current; }
+  bool operator!=(const sparse_iterator& rhs) const { return _current != rhs._current; }
 };
 
 class sparse_parameters
 {
 private:
-  // This must be mutable because the const operator[] must be able to intialize default weights to return.
-  mutable weight_map _map;
+  // The table is shared with the instances seeded from this one. It must be mutable because the const operator[]
+  // must be able to intialize default weights to return.
+  mutable std::shared_ptr<sparse_weight_table> _table;
   uint64_t _weight_mask;  // (stride*(1 << num_bits) -1)
   uint32_t _stride_shift;
   bool _seeded;  // whether the instance is sharing model state with others
-  bool _delete;
   std::function<void(weight*, uint64_t)> _default_func;
 
   // It is marked const so it can be used from both const and non const operator[]
-  // The map itself is mutable to facilitate this
+  // The table itself is mutable to facilitate this
   inline weight* get_or_default_and_get(size_t i) const
   {
     uint64_t index = i & _weight_mask;
-    weight_map::iterator iter = _map.find(index);
-    if (iter == _map.end())
-    {
-      _map.insert(std::make_pair(index, calloc_mergable_or_throw<weight>(stride())));
-      iter = _map.find(index);
-      if (_default_func != nullptr) { _default_func(iter->second, index); }
-    }
-    return iter->second;
+    return _table->find_or_insert(index, [this](weight* weights, uint64_t new_index) {
+      if (_default_func != nullptr) { _default_func(weights, new_index); }
+    });
   }
 
 public:
@@ -91,21 +352,24 @@ public:
   typedef sparse_iterator<const weight> const_iterator;
 
   sparse_parameters(size_t length, uint32_t stride_shift = 0)
-      : _map()
+      : _table(std::make_shared<sparse_weight_table>(1 << stride_shift))
       , _weight_mask((length << stride_shift) - 1)
       , _stride_shift(stride_shift)
       , _seeded(false)
-      , _delete(false)
       , _default_func(nullptr)
   {
   }
 
   sparse_parameters()
-      : _map(), _weight_mask(0), _stride_shift(0), _seeded(false), _delete(false), _default_func(nullptr)
+      : _table(std::make_shared<sparse_weight_table>(1))
+      , _weight_mask(0)
+      , _stride_shift(0)
+      , _seeded(false)
+      , _default_func(nullptr)
   {
   }
 
-  bool not_null() { return (_weight_mask > 0 && !_map.empty()); }
+  bool not_null() { return (_weight_mask > 0 && _table->size() > 0); }
 
   sparse_parameters(const sparse_parameters& other) = delete;
   sparse_parameters& operator=(const sparse_parameters& other) = delete;
@@ -115,28 +379,12 @@ public:
   weight* first() { THROW_OR_RETURN("Allreduce currently not supported in sparse", nullptr); }
 
   // iterator with stride
-  iterator begin()
-  {
-    weight_map::iterator i = _map.begin();
-    return iterator(i, stride());
-  }
-  iterator end()
-  {
-    weight_map::iterator i = _map.end();
-    return iterator(i, stride());
-  }
+  iterator begin() { return iterator(*_table, false); }
+  iterator end() { return iterator(*_table, true); }
 
   // const iterator
-  const_iterator cbegin()
-  {
-    weight_map::iterator i = _map.begin();
-    return const_iterator(i, stride());
-  }
-  const_iterator cend()
-  {
-    weight_map::iterator i = _map.begin();
-    return const_iterator(i, stride());
-  }
+  const_iterator cbegin() { return const_iterator(*_table, false); }
+  const_iterator cend() { return const_iterator(*_table, true); }
 
   inline weight& operator[](size_t i) { return *(get_or_default_and_get(i)); }
 
@@ -144,18 +392,12 @@ public:
 
   inline weight& strided_index(size_t index) { return operator[](index << _stride_shift); }
 
+  // Shares the table of input, including the weights it gets later on from either instance. The instances may then
+  // run in different threads.
   void shallow_copy(const sparse_parameters& input)
   {
-    // TODO: this is level-1 copy (weight* are stilled shared)
-    if (!_seeded)
-    {
-      for (auto& iter : _map)
-      {
-        auto* weight_ptr = iter.second;
-        free(weight_ptr);
-      }
-    }
-    _map = input._map;
+    input._table->make_concurrent();
+    _table = input._table;
     _weight_mask = input._weight_mask;
     _stride_shift = input._stride_shift;
     _seeded = true;
@@ -169,7 +411,7 @@ public:
 
   void set_zero(size_t offset)
   {
-    for (auto& iter : _map) { (&(*(iter.second)))[offset] = 0; }
+    for (iterator iter = begin(); iter != end(); ++iter) { (&(*iter))[offset] = 0; }
   }
 
   uint64_t mask() const { return _weight_mask; }
@@ -180,25 +422,25 @@ public:
 
   uint32_t stride_shift() const { return _stride_shift; }
 
-  void stride_shift(uint32_t stride_shift) { _stride_shift = stride_shift; }
+  // The slots are laid out for the stride, so an empty table is replaced by one for the new stride.
+  void stride_shift(uint32_t stride_shift)
+  {
+    _stride_shift = stride_shift;
+    if (_table->size() == 0 && _table->stride() != stride())
+    { _table = std::make_shared<sparse_weight_table>(stride()); }
+  }
+
+  // Lets several threads look up and add weights at once, see sparse_weight_table. To be called before they start.
+  void make_concurrent() { _table->make_concurrent(); }
+  bool concurrent() const { return _table->concurrent(); }
+
+  // The number of indices with weights, and the bytes the table takes for them.
+  size_t size() const { return _table->size(); }
+  size_t memory_bytes() const { return _table->capacity() * _table->slot_bytes(); }
 
 #ifndef _WIN32
   void share(size_t /* length */) { THROW_OR_RETURN("Operation not supported on Windows"); }
 #endif
-
-  ~sparse_parameters()
-  {
-    if (!_delete && !_seeded)  // don't free weight vector if it is shared with another instance
-    {
-      for (auto& iter : _map)
-      {
-        auto* weight_ptr = iter.second;
-        free(weight_ptr);
-      }
-      _map.clear();
-      _delete = true;
-    }
-  }
 };
 
 class parameters
@@ -5,14 +5,29 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #ifndef _WIN32
 #  include <sys/mman.h>
+#  include <unistd.h>
 #endif
 
 #include "memory.h"
+#include "weight_allocation.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define VW_PREFETCH(address) __builtin_prefetch(address)
+#elif defined(_M_X64) || defined(_M_IX86)
+#  include <xmmintrin.h>
+#  define VW_PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#else
+#  define VW_PREFETCH(address)
+#endif
 
 typedef float weight;
 
+class dense_snapshot;
+
 template <typename T>
 class dense_iterator
 {
@@ -51,6 +66,31 @@ private:
   uint64_t _weight_mask;  // (stride*(1 << num_bits) -1)
   uint32_t _stride_shift;
   bool _seeded;  // whether the instance is sharing model state with others
+  size_t _prefetch_distance;  // how many features ahead the loops over features prefetch weights, 0 for not at all
+  size_t _mapped_bytes;  // size of the mapping to munmap, 0 when _begin is to be freed
+  int _snapshot_fd = -1;  // the memory file holding the weights with --weight_snapshots
+  bool _copy_on_write = false;  // whether _begin maps the memory file privately since a snapshot
+  std::weak_ptr<const dense_snapshot> _last_snapshot;
+
+  void release()
+  {
+#ifndef _WIN32
+    if (_snapshot_fd >= 0)
+    {
+      close(_snapshot_fd);
+      _snapshot_fd = -1;
+    }
+    if (_mapped_bytes > 0)
+    {
+      munmap(_begin, _mapped_bytes);
+      _mapped_bytes = 0;
+      return;
+    }
+#endif
+    free(_begin);
+  }
+
+  friend class dense_snapshot;
 
 public:
   typedef dense_iterator<weight> iterator;
@@ -60,10 +100,30 @@ public:
       , _weight_mask((length << stride_shift) - 1)
       , _stride_shift(stride_shift)
       , _seeded(false)
+      , _prefetch_distance(0)
+      , _mapped_bytes(0)
+  {
+  }
+
+  // Allocates the weights as asked by allocation, see weight_allocation.h.
+  dense_parameters(size_t length, uint32_t stride_shift, const VW::weight_allocation& allocation)
+      : _begin(nullptr)
+      , _weight_mask((length << stride_shift) - 1)
+      , _stride_shift(stride_shift)
+      , _seeded(false)
+      , _prefetch_distance(0)
+      , _mapped_bytes(0)
   {
+    const auto memory = VW::allocate_weight_memory((length << stride_shift) * sizeof(weight), allocation);
+    _begin = static_cast<weight*>(memory.begin);
+    _mapped_bytes = memory.mapped_bytes;
+    _snapshot_fd = memory.snapshot_fd;
   }
 
-  dense_parameters() : _begin(nullptr), _weight_mask(0), _stride_shift(0), _seeded(false) {}
+  dense_parameters()
+      : _begin(nullptr), _weight_mask(0), _stride_shift(0), _seeded(false), _prefetch_distance(0), _mapped_bytes(0)
+  {
+  }
 
   bool not_null() { return (_weight_mask > 0 && _begin != nullptr); }
 
@@ -87,12 +147,16 @@ public:
   inline const weight& operator[](size_t i) const { return _begin[i & _weight_mask]; }
   inline weight& operator[](size_t i) { return _begin[i & _weight_mask]; }
 
+  // Asks for the cache line of weight i ahead of its use.
+  inline void prefetch(size_t i) const { VW_PREFETCH(&_begin[i & _weight_mask]); }
+
   void shallow_copy(const dense_parameters& input)
   {
-    if (!_seeded) free(_begin);
+    if (!_seeded) release();
     _begin = input._begin;
     _weight_mask = input._weight_mask;
     _stride_shift = input._stride_shift;
+    _prefetch_distance = input._prefetch_distance;
     _seeded = true;
   }
 
@@ -124,6 +188,39 @@ public:
 
   void stride_shift(uint32_t stride_shift) { _stride_shift = stride_shift; }
 
+  size_t prefetch_distance() const { return _prefetch_distance; }
+
+  void prefetch_distance(size_t distance) { _prefetch_distance = distance; }
+
+  // The pages the weights actually got, which may differ from those asked for with huge pages.
+  VW::page_report pages() const { return VW::report_pages(_begin, (_weight_mask + 1) * sizeof(weight)); }
+
+  // Freezes the weights as they are now, without copying them up front: from here on the pages the learner writes
+  // are copied on write, so the snapshot costs page faults on the first write to each page instead of a pause.
+  // Needs the weights allocated with --weight_snapshots, see VW::weight_allocation. Take snapshots on the thread
+  // updating the weights, in between examples; the snapshot itself may then be read from any thread, e.g. to save
+  // the model in the background or to predict while learning goes on. Taking one while the last one is still alive
+  // copies all weights once, as that one still needs the memory file.
+  std::shared_ptr<const dense_snapshot> snapshot();
+
+  // Whether the weights are in the memory file of --weight_snapshots, so that snapshot() can be taken.
+  bool snapshots_enabled() const { return _snapshot_fd >= 0 && !_seeded; }
+
+  // Replaces the weights by those stored raw at offset in the file fd, see VW::map_weight_file. Returns false and
+  // keeps the weights as they are where the file cannot be mapped, so that the caller reads it instead.
+  bool map_file(int fd, uint64_t offset)
+  {
+    if (_seeded) return false;
+    const size_t bytes = (_weight_mask + 1) * sizeof(weight);
+    void* memory = VW::map_weight_file(fd, offset, bytes);
+    if (memory == nullptr) return false;
+    release();
+    _begin = static_cast<weight*>(memory);
+    _mapped_bytes = bytes;
+    _copy_on_write = false;
+    return true;
+  }
+
 #ifndef _WIN32
 #  ifndef DISABLE_SHARED_WEIGHTS
   void share(size_t length)
@@ -133,8 +230,9 @@ public:
     size_t float_count = length << _stride_shift;
     weight* dest = shared_weights;
     memcpy(dest, _begin, float_count * sizeof(float));
-    free(_begin);
+    release();
     _begin = dest;
+    _mapped_bytes = float_count * sizeof(float);
   }
 #  endif
 #endif
@@ -143,8 +241,52 @@ public:
   {
     if (_begin != nullptr && !_seeded)  // don't free weight vector if it is shared with another instance
     {
-      free(_begin);
+      release();
       _begin = nullptr;
     }
   }
 };
+
+// Read-only weights frozen by dense_parameters::snapshot(), unmapped when the last reference goes.
+class dense_snapshot
+{
+public:
+  dense_snapshot(weight* frozen, size_t mapped_bytes, const dense_parameters& source) : _mapped_bytes(mapped_bytes)
+  {
+    _weights._begin = frozen;
+    _weights._weight_mask = source._weight_mask;
+    _weights._stride_shift = source._stride_shift;
+    _weights._prefetch_distance = source._prefetch_distance;
+    _weights._seeded = true;
+  }
+
+  dense_snapshot(const dense_snapshot&) = delete;
+  dense_snapshot& operator=(const dense_snapshot&) = delete;
+
+  ~dense_snapshot()
+  {
+#ifndef _WIN32
+    munmap(_weights._begin, _mapped_bytes);
+#endif
+  }
+
+  const dense_parameters& weights() const { return _weights; }
+
+private:
+  dense_parameters _weights;
+  size_t _mapped_bytes;
+};
+
+inline std::shared_ptr<const dense_snapshot> dense_parameters::snapshot()
+{
+  VW::weight_memory memory;
+  memory.begin = _begin;
+  memory.mapped_bytes = _mapped_bytes;
+  memory.snapshot_fd = _seeded ? -1 : _snapshot_fd;
+  void* frozen = VW::snapshot_weight_memory(memory, _copy_on_write, !_last_snapshot.expired());
+  _snapshot_fd = memory.snapshot_fd;
+  _copy_on_write = true;
+  auto snapshot = std::make_shared<const dense_snapshot>(static_cast<weight*>(frozen), _mapped_bytes, *this);
+  _last_snapshot = snapshot;
+  return snapshot;
+}
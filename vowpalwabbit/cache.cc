@@ -8,6 +8,8 @@
 #include "vw.h"
 #include "io/logger.h"
 
+#include <algorithm>
+
 constexpr size_t int_size = 11;
 constexpr size_t char_size = 2;
 constexpr size_t neg_1 = 1;
@@ -68,8 +70,36 @@ void VW::write_example_to_cache(io_buf& output, example* ae, label_parser& lbl_p
   cache_features(output, ae, parse_mask);
 }
 
-int VW::read_example_from_cache(
-    io_buf& input, example* ae, label_parser& lbl_parser, bool sorted_cache, shared_data* shared_dat)
+void VW::decode_cached_features(char* c, char* end, features& ours, bool& sorted)
+{
+  uint64_t last = 0;
+
+  for (; c != end;)
+  {
+    feature_index i = 0;
+    c = run_len_decode(c, i);
+    feature_value v = 1.f;
+    if (i & neg_1)
+      v = -1.;
+    else if (i & general)
+    {
+      v = (reinterpret_cast<one_float*>(c))->f;
+      c += sizeof(float);
+    }
+    uint64_t diff = i >> 2;
+    int64_t s_diff = ZigZagDecode(diff);
+    if (s_diff < 0) sorted = false;
+    i = last + s_diff;
+    last = i;
+    ours.push_back(v, i);
+  }
+}
+
+// Reads a single cached example. The run length encoded payload of each namespace is handed to on_payload(index,
+// begin, end) which either decodes it in place or stashes it to be decoded later.
+template <typename PayloadFn>
+int read_cached_example(io_buf& input, example* ae, label_parser& lbl_parser, bool sorted_cache,
+    shared_data* shared_dat, PayloadFn&& on_payload)
 {
   ae->sorted = sorted_cache;
   size_t total = lbl_parser.read_cached_label(shared_dat, &ae->l, ae->_reduction_features, input);
@@ -100,7 +130,6 @@ int VW::read_example_from_cache(
     c += sizeof(index);
 
     ae->indices.push_back(static_cast<size_t>(index));
-    features& ours = ae->feature_space[index];
     size_t storage = *reinterpret_cast<size_t*>(c);
     c += sizeof(size_t);
     input.set(c);
@@ -111,35 +140,31 @@ int VW::read_example_from_cache(
       return 0;
     }
 
-    char* end = c + storage;
-
-    uint64_t last = 0;
-
-    for (; c != end;)
-    {
-      feature_index i = 0;
-      c = run_len_decode(c, i);
-      feature_value v = 1.f;
-      if (i & neg_1)
-        v = -1.;
-      else if (i & general)
-      {
-        v = (reinterpret_cast<one_float*>(c))->f;
-        c += sizeof(float);
-      }
-      uint64_t diff = i >> 2;
-      int64_t s_diff = ZigZagDecode(diff);
-      if (s_diff < 0) ae->sorted = false;
-      i = last + s_diff;
-      last = i;
-      ours.push_back(v, i);
-    }
-    input.set(c);
+    on_payload(index, c, c + storage);
   }
 
   return static_cast<int>(total);
 }
 
+int VW::read_example_from_cache(
+    io_buf& input, example* ae, label_parser& lbl_parser, bool sorted_cache, shared_data* shared_dat)
+{
+  return read_cached_example(
+      input, ae, lbl_parser, sorted_cache, shared_dat, [ae](unsigned char index, char* begin, char* end) {
+        VW::decode_cached_features(begin, end, ae->feature_space[index], ae->sorted);
+      });
+}
+
+int VW::read_example_from_cache_deferred(io_buf& input, example* ae, label_parser& lbl_parser, bool sorted_cache,
+    shared_data* shared_dat, std::vector<char>& payload_buffer, std::vector<cached_payload>& payloads)
+{
+  return read_cached_example(input, ae, lbl_parser, sorted_cache, shared_dat,
+      [ae, &payload_buffer, &payloads](unsigned char index, char* begin, char* end) {
+        payloads.push_back({ae, index, payload_buffer.size(), static_cast<size_t>(end - begin)});
+        payload_buffer.insert(payload_buffer.end(), begin, end);
+      });
+}
+
 int read_cached_features(vw* all, v_array<example*>& examples)
 {
   return VW::read_example_from_cache(*all->example_parser->input, examples[0], all->example_parser->lbl_parser,
@@ -224,3 +249,423 @@ uint32_t VW::convert(size_t number)
   if (number > UINT32_MAX) { THROW("size_t value is out of bounds of uint32_t.") }
   return static_cast<uint32_t>(number);
 }
+
+namespace
+{
+// The length of each value of a varint stream is given by a two bit code. The codes of four values share a control
+// byte and all control bytes precede the values, in the style of stream vbyte, so decoding a value is a single load and
+// mask rather than a loop over its bytes. Streams of values below 2^32 use the narrow lengths, which fit hashed indices
+// of the usual sizes best. Values are little endian.
+constexpr unsigned char varint_narrow_lengths[4] = {1, 2, 3, 4};
+constexpr unsigned char varint_wide_lengths[4] = {1, 2, 4, 8};
+// Indexed by length.
+constexpr uint64_t varint_masks[9] = {0, 0xFFULL, 0xFFFFULL, 0xFFFFFFULL, 0xFFFFFFFFULL, 0, 0, 0, ~0ULL};
+// The decoder always loads 8 bytes, so streams are padded to keep the last load inside them.
+constexpr size_t varint_padding = 7;
+
+// How the value of each feature is stored, two bits per feature.
+constexpr unsigned char value_one = 0;
+constexpr unsigned char value_minus_one = 1;
+constexpr unsigned char value_general = 2;
+
+// Takes the place of the number of examples of a block to mark the start of the block index.
+constexpr uint32_t block_index_marker = 0;
+constexpr size_t block_index_entry_size = sizeof(uint64_t) + sizeof(uint32_t);
+
+// Appends the values as a varint stream and returns whether it uses the wide lengths.
+bool append_varints(std::vector<char>& out, const std::vector<uint64_t>& values)
+{
+  const bool wide = std::any_of(values.begin(), values.end(), [](uint64_t v) { return (v >> 32) != 0; });
+  const unsigned char* lengths = wide ? varint_wide_lengths : varint_narrow_lengths;
+
+  const size_t control_begin = out.size();
+  out.resize(control_begin + (values.size() + 3) / 4, 0);
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    unsigned char code = 0;
+    while (code < 3 && (values[i] & ~varint_masks[lengths[code]]) != 0) { code++; }
+    out[control_begin + i / 4] |= static_cast<char>(code << ((i % 4) * 2));
+    for (size_t b = 0; b < lengths[code]; b++) { out.push_back(static_cast<char>(values[i] >> (8 * b))); }
+  }
+  out.insert(out.end(), varint_padding, 0);
+  return wide;
+}
+
+template <typename T>
+void append_value(std::vector<char>& out, T value)
+{
+  const char* p = reinterpret_cast<const char*>(&value);
+  out.insert(out.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+void write_value_at(std::vector<char>& out, size_t offset, T value)
+{
+  memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+T read_block_value(const char*& c, const char* end)
+{
+  if (static_cast<size_t>(end - c) < sizeof(T)) { THROW("Cache block is truncated."); }
+  T value;
+  memcpy(&value, c, sizeof(T));
+  c += sizeof(T);
+  return value;
+}
+}  // namespace
+
+std::vector<VW::cache_block_info> VW::read_cache_block_index(const char* data, size_t length)
+{
+  if (length < sizeof(uint64_t)) { THROW("Cache block index is missing."); }
+  const char* end = data + length - sizeof(uint64_t);
+  const char* c = end;
+  const auto index_offset = read_block_value<uint64_t>(c, data + length);
+  if (index_offset > static_cast<uint64_t>(end - data)) { THROW("Cache block index is missing."); }
+
+  c = data + index_offset;
+  if (read_block_value<uint32_t>(c, end) != block_index_marker) { THROW("Cache block index is missing."); }
+  const auto num_blocks = read_block_value<uint64_t>(c, end);
+  if (num_blocks != static_cast<uint64_t>(end - c) / block_index_entry_size)
+  { THROW("Cache block index is truncated."); }
+
+  std::vector<VW::cache_block_info> index;
+  index.reserve(num_blocks);
+  for (uint64_t i = 0; i < num_blocks; i++)
+  {
+    VW::cache_block_info block;
+    block.offset = read_block_value<uint64_t>(c, end);
+    block.num_examples = read_block_value<uint32_t>(c, end);
+    index.push_back(block);
+  }
+  return index;
+}
+
+VW::cache_block_writer::cache_block_writer() : _rows_buffer(std::make_shared<std::vector<char>>())
+{
+  _rows.add_file(VW::io::create_vector_writer(_rows_buffer));
+}
+
+void VW::cache_block_writer::add_example(io_buf& output, example* ae, label_parser& lbl_parser, uint64_t parse_mask)
+{
+  lbl_parser.cache_label(&ae->l, ae->_reduction_features, _rows);
+  cache_tag(_rows, ae->tag);
+  _rows.write_value<unsigned char>(ae->is_newline ? newline_example : non_newline_example);
+  _rows.write_value<unsigned char>(static_cast<unsigned char>(ae->indices.size()));
+
+  for (namespace_index ns : ae->indices)
+  {
+    _rows.write_value<unsigned char>(ns);
+    auto& col = _columns[ns];
+    if (col.counts.empty()) { _used_columns.push_back(ns); }
+
+    features& fs = ae->feature_space[ns];
+    col.counts.push_back(fs.size());
+    uint64_t last = 0;
+    for (const auto& f : fs)
+    {
+      feature_index fi = f.index() & parse_mask;
+      col.deltas.push_back(ZigZagEncode(static_cast<int64_t>(fi - last)));
+      last = fi;
+
+      if (f.value() == 1.) { col.kinds.push_back(value_one); }
+      else if (f.value() == -1.)
+      {
+        col.kinds.push_back(value_minus_one);
+      }
+      else
+      {
+        col.kinds.push_back(value_general);
+        col.values.push_back(f.value());
+      }
+    }
+  }
+
+  if (++_num_examples == VW::cache_block_size) { write_block(output); }
+}
+
+// A block is laid out as
+//   uint32_t number of examples, uint64_t length of the rest of the block,
+//   uint64_t length of the rows, rows written by the label parser and cache_tag,
+//   uint32_t number of columns, then for each column
+//     namespace index, uint64_t number of counts, features and general values, uint64_t length of both varint streams,
+//     a byte flagging which stream uses the wide lengths, the counts and the index deltas as varint streams, the value
+//     kinds packed four to a byte, the general values.
+void VW::cache_block_writer::write_block(io_buf& output)
+{
+  if (_num_examples == 0) { return; }
+
+  _rows.flush();
+  _block.clear();
+  append_value<uint64_t>(_block, _rows_buffer->size());
+  _block.insert(_block.end(), _rows_buffer->begin(), _rows_buffer->end());
+  _rows_buffer->clear();
+
+  append_value<uint32_t>(_block, static_cast<uint32_t>(_used_columns.size()));
+  for (namespace_index ns : _used_columns)
+  {
+    auto& col = _columns[ns];
+    _block.push_back(static_cast<char>(ns));
+    append_value<uint64_t>(_block, col.counts.size());
+    append_value<uint64_t>(_block, col.kinds.size());
+    append_value<uint64_t>(_block, col.values.size());
+    const size_t lengths_offset = _block.size();
+    append_value<uint64_t>(_block, 0);
+    append_value<uint64_t>(_block, 0);
+    _block.push_back(0);
+
+    const size_t counts_begin = _block.size();
+    const bool wide_counts = append_varints(_block, col.counts);
+    const size_t deltas_begin = _block.size();
+    const bool wide_deltas = append_varints(_block, col.deltas);
+    write_value_at<uint64_t>(_block, lengths_offset, deltas_begin - counts_begin);
+    write_value_at<uint64_t>(_block, lengths_offset + sizeof(uint64_t), _block.size() - deltas_begin);
+    _block[counts_begin - 1] = static_cast<char>((wide_counts ? 1 : 0) | (wide_deltas ? 2 : 0));
+
+    const size_t kinds_begin = _block.size();
+    _block.resize(kinds_begin + (col.kinds.size() + 3) / 4, 0);
+    for (size_t i = 0; i < col.kinds.size(); i++)
+    { _block[kinds_begin + i / 4] |= static_cast<char>(col.kinds[i] << ((i % 4) * 2)); }
+    const char* values = reinterpret_cast<const char*>(col.values.data());
+    _block.insert(_block.end(), values, values + col.values.size() * sizeof(float));
+
+    col.counts.clear();
+    col.deltas.clear();
+    col.kinds.clear();
+    col.values.clear();
+  }
+  _used_columns.clear();
+
+  const auto num_examples = static_cast<uint32_t>(_num_examples);
+  const uint64_t length = _block.size();
+  output.bin_write_fixed(reinterpret_cast<const char*>(&num_examples), sizeof(num_examples));
+  output.bin_write_fixed(reinterpret_cast<const char*>(&length), sizeof(length));
+  output.bin_write_fixed(_block.data(), _block.size());
+
+  _index.push_back({_offset, num_examples});
+  _offset += sizeof(num_examples) + sizeof(length) + _block.size();
+  _num_examples = 0;
+}
+
+// The index is laid out as the block_index_marker, uint64_t number of blocks, the offset and number of examples of each
+// block, and the offset of the index itself last so it can be found from the end of the file.
+void VW::cache_block_writer::finish(io_buf& output)
+{
+  write_block(output);
+
+  _block.clear();
+  append_value<uint32_t>(_block, block_index_marker);
+  append_value<uint64_t>(_block, _index.size());
+  for (const auto& block : _index)
+  {
+    append_value<uint64_t>(_block, block.offset);
+    append_value<uint32_t>(_block, block.num_examples);
+  }
+  append_value<uint64_t>(_block, _offset);
+  output.bin_write_fixed(_block.data(), _block.size());
+
+  _index.clear();
+  _offset = 0;
+}
+
+inline uint64_t VW::cache_column_decoder::varint_cursor::next()
+{
+  const unsigned char code = (control[position >> 2] >> ((position & 3) << 1)) & 3;
+  position++;
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  const unsigned char length = lengths[code];
+  data += length;
+  return value & varint_masks[length];
+}
+
+void VW::cache_column_decoder::reset(const char* begin, const char* end)
+{
+  for (namespace_index ns : _used_columns) { _columns[ns] = column_cursor{}; }
+  _used_columns.clear();
+
+  const char* c = begin;
+  const auto num_columns = read_block_value<uint32_t>(c, end);
+  for (uint32_t i = 0; i < num_columns; i++)
+  {
+    const auto ns = read_block_value<unsigned char>(c, end);
+    const auto num_counts = read_block_value<uint64_t>(c, end);
+    const auto num_features = read_block_value<uint64_t>(c, end);
+    const auto num_values = read_block_value<uint64_t>(c, end);
+    const auto counts_length = read_block_value<uint64_t>(c, end);
+    const auto deltas_length = read_block_value<uint64_t>(c, end);
+    const auto widths = read_block_value<unsigned char>(c, end);
+    const uint64_t kinds_length = (num_features + 3) / 4;
+    const uint64_t values_length = num_values * sizeof(float);
+    const uint64_t counts_control = (num_counts + 3) / 4;
+    const uint64_t deltas_control = (num_features + 3) / 4;
+    if (counts_length < counts_control + varint_padding || deltas_length < deltas_control + varint_padding ||
+        static_cast<uint64_t>(end - c) < counts_length + deltas_length + kinds_length + values_length)
+    { THROW("Cache block is truncated."); }
+
+    auto& col = _columns[ns];
+    col.counts.control = reinterpret_cast<const unsigned char*>(c);
+    col.counts.data = c + counts_control;
+    col.counts.lengths = (widths & 1) != 0 ? varint_wide_lengths : varint_narrow_lengths;
+    c += counts_length;
+    col.deltas.control = reinterpret_cast<const unsigned char*>(c);
+    col.deltas.data = c + deltas_control;
+    col.deltas.lengths = (widths & 2) != 0 ? varint_wide_lengths : varint_narrow_lengths;
+    c += deltas_length;
+    col.kinds = reinterpret_cast<const unsigned char*>(c);
+    c += kinds_length;
+    col.values = c;
+    c += values_length;
+    col.values_end = c;
+    col.remaining_counts = num_counts;
+    col.remaining_features = num_features;
+    _used_columns.push_back(ns);
+  }
+}
+
+void VW::cache_column_decoder::decode_example(example& ae)
+{
+  for (namespace_index ns : ae.indices)
+  {
+    auto& col = _columns[ns];
+    if (col.remaining_counts == 0) { THROW("Cache block does not hold the features of namespace " << ns); }
+    col.remaining_counts--;
+    const uint64_t count = col.counts.next();
+    if (count > col.remaining_features) { THROW("Cache block does not hold the features of namespace " << ns); }
+    col.remaining_features -= count;
+
+    // The features are written in place rather than pushed one by one.
+    features& fs = ae.feature_space[ns];
+    const size_t first = fs.size();
+    fs.reserve(first + count);
+    fs.values.resize_but_with_stl_behavior(first + count);
+    fs.indicies.resize_but_with_stl_behavior(first + count);
+    feature_value* values = fs.values.begin() + first;
+    feature_index* indices = fs.indicies.begin() + first;
+
+    // The cursor is copied so it can live in registers, the stores below could alias it otherwise.
+    varint_cursor deltas = col.deltas;
+    const char* general_values = col.values;
+    uint64_t last = 0;
+    bool sorted = true;
+    float sum_feat_sq = fs.sum_feat_sq;
+    for (uint64_t i = 0; i < count; i++)
+    {
+      const size_t position = deltas.position;
+      const unsigned char kind = (col.kinds[position >> 2] >> ((position & 3) << 1)) & 3;
+      const int64_t s_diff = ZigZagDecode(deltas.next());
+      sorted &= s_diff >= 0;
+      last += s_diff;
+
+      feature_value v = 1.f;
+      if (kind == value_minus_one) { v = -1.f; }
+      else if (kind == value_general)
+      {
+        if (general_values == col.values_end) { THROW("Cache block does not hold the features of namespace " << ns); }
+        memcpy(&v, general_values, sizeof(v));
+        general_values += sizeof(v);
+      }
+      values[i] = v;
+      indices[i] = last;
+      sum_feat_sq += v * v;
+    }
+    col.deltas = deltas;
+    col.values = general_values;
+    if (!sorted) { ae.sorted = false; }
+    fs.sum_feat_sq = sum_feat_sq;
+  }
+}
+
+bool VW::cache_block_reader::read_block(io_buf& input)
+{
+  _remaining = 0;
+  char* c;
+  while (input.buf_read(c, sizeof(uint32_t)) == sizeof(uint32_t))
+  {
+    uint32_t num_examples;
+    memcpy(&num_examples, c, sizeof(num_examples));
+    if (num_examples == block_index_marker)
+    {
+      // The index is only used to seek, the blocks of the next file follow it.
+      const auto num_blocks = input.read_value<uint64_t>("num_blocks");
+      const size_t index_length = num_blocks * block_index_entry_size + sizeof(uint64_t);
+      if (input.buf_read(c, index_length) < index_length) { THROW("Cache block index is truncated."); }
+      continue;
+    }
+
+    const auto length = input.read_value<uint64_t>("block_length");
+    if (input.buf_read(c, length) < length)
+    {
+      VW::io::logger::errlog_error("truncated cache block! wanted: {} bytes ", length);
+      return false;
+    }
+    if (_next_block++ % _shard_count != _shard_index) { continue; }
+    const char* end = c + length;
+    const char* rows = c;
+    const auto rows_length = read_block_value<uint64_t>(rows, end);
+    if (rows_length > static_cast<uint64_t>(end - rows)) { THROW("Cache block is truncated."); }
+
+    _rows.close_files();
+    _rows.reset_buffer();
+    _rows.current = 0;
+    _rows.add_file(VW::io::create_buffer_view(rows, rows_length));
+    _columns_begin = rows + rows_length;
+    _columns_end = end;
+    _columns.reset(_columns_begin, _columns_end);
+    _remaining = num_examples;
+    return true;
+  }
+  return false;
+}
+
+size_t VW::cache_block_reader::read_example_header(
+    example* ae, label_parser& lbl_parser, bool sorted_cache, shared_data* shared_dat)
+{
+  if (_remaining == 0) { return 0; }
+  _remaining--;
+
+  ae->sorted = sorted_cache;
+  size_t total = lbl_parser.read_cached_label(shared_dat, &ae->l, ae->_reduction_features, _rows);
+  if (total == 0) { return 0; }
+  const size_t tag_length = read_cached_tag(_rows, ae);
+  if (tag_length == 0) { return 0; }
+  total += tag_length;
+  ae->is_newline = _rows.read_value<unsigned char>("newline_indicator") == newline_example;
+
+  const auto num_indices = _rows.read_value<unsigned char>("num_indices");
+  char* c;
+  if (_rows.buf_read(c, num_indices) < num_indices)
+  {
+    VW::io::logger::errlog_error("truncated example! wanted: {} namespaces ", num_indices);
+    return 0;
+  }
+  for (unsigned char i = 0; i < num_indices; i++) { ae->indices.push_back(static_cast<unsigned char>(c[i])); }
+  return total + 2 * sizeof(unsigned char) + num_indices;
+}
+
+void VW::cache_block_reader::reset()
+{
+  _remaining = 0;
+  _columns_begin = nullptr;
+  _columns_end = nullptr;
+  _next_block = 0;
+}
+
+void VW::cache_block_reader::set_shard(size_t index, size_t count)
+{
+  if (count == 0 || index >= count)
+  { THROW("Cache shard " << index << " is out of range for " << count << " shards."); }
+  _shard_index = index;
+  _shard_count = count;
+  _next_block = 0;
+}
+
+int read_cached_block_features(vw* all, v_array<example*>& examples)
+{
+  parser& p = *all->example_parser;
+  if (p.cache_reader.remaining() == 0 && !p.cache_reader.read_block(*p.input)) { return 0; }
+  const size_t total = p.cache_reader.read_example_header(examples[0], p.lbl_parser, p.sorted_cache, p._shared_data);
+  if (total == 0) { return 0; }
+  p.cache_reader.columns().decode_example(*examples[0]);
+  return static_cast<int>(total);
+}
@@ -7,6 +7,11 @@
 #include "io_buf.h"
 #include "example.h"
 
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 char* run_len_decode(char* p, size_t& i);
 char* run_len_encode(char* p, size_t i);
 
@@ -18,9 +23,151 @@ void output_features(io_buf& cache, unsigned char index, features& fs, uint64_t
 
 namespace VW
 {
+// Location of a still encoded namespace payload which was copied out of the cache by read_example_from_cache_deferred.
+struct cached_payload
+{
+  example* ex;
+  namespace_index index;
+  size_t offset;
+  size_t length;
+};
+
 uint32_t convert(size_t number);
 // What is written by write_example_to_cache can be read by read_example_from_cache
 void write_example_to_cache(io_buf& output, example* ae, label_parser& lbl_parser, uint64_t parse_mask);
 int read_example_from_cache(
     io_buf& input, example* ae, label_parser& lbl_parser, bool sorted_cache, shared_data* shared_dat);
+// Same as read_example_from_cache but the feature payloads are appended to payload_buffer instead of being decoded.
+// Each one must later be passed to decode_cached_features, which is safe to do from another thread.
+int read_example_from_cache_deferred(io_buf& input, example* ae, label_parser& lbl_parser, bool sorted_cache,
+    shared_data* shared_dat, std::vector<char>& payload_buffer, std::vector<cached_payload>& payloads);
+void decode_cached_features(char* begin, char* end, features& ours, bool& sorted);
+
+// Cache files start with a header naming the format of what follows, see make_write_cache.
+// cache_format_records is a stream of the records written by write_example_to_cache.
+// cache_format_blocks is a sequence of blocks of cache_block_size examples, each storing the features of a namespace
+// contiguously, followed by an index of the blocks. The length of every block is known upfront so blocks can be
+// skipped or handed to other threads to decode without parsing them.
+constexpr uint32_t cache_format_records = 1;
+constexpr uint32_t cache_format_blocks = 2;
+constexpr size_t cache_block_size = 256;
+
+// Entry of the index at the end of a cache_format_blocks file. Offsets are relative to the end of the cache header.
+struct cache_block_info
+{
+  uint64_t offset;
+  uint32_t num_examples;
+};
+
+// Reads the block index out of the contents of a cache_format_blocks file following its header.
+std::vector<cache_block_info> read_cache_block_index(const char* data, size_t length);
+
+// Collects examples into blocks and writes them to the cache in the cache_format_blocks layout.
+class cache_block_writer
+{
+public:
+  cache_block_writer();
+  cache_block_writer(const cache_block_writer&) = delete;
+  cache_block_writer& operator=(const cache_block_writer&) = delete;
+
+  // The example is written as part of a block once cache_block_size examples have been added.
+  void add_example(io_buf& output, example* ae, label_parser& lbl_parser, uint64_t parse_mask);
+  // Writes out the examples added since the last block, followed by the block index. Must be called once all examples
+  // have been added.
+  void finish(io_buf& output);
+
+private:
+  struct column
+  {
+    std::vector<uint64_t> counts;  // Number of features of each occurrence of the namespace.
+    std::vector<uint64_t> deltas;  // Zig zag encoded differences between consecutive feature indices.
+    std::vector<unsigned char> kinds;
+    std::vector<float> values;  // Only values other than 1 and -1.
+  };
+
+  void write_block(io_buf& output);
+
+  // Labels, tags and namespace lists, which are written row by row with the label parsers.
+  std::shared_ptr<std::vector<char>> _rows_buffer;
+  io_buf _rows;
+  std::array<column, 256> _columns;
+  std::vector<namespace_index> _used_columns;
+  size_t _num_examples = 0;
+
+  std::vector<char> _block;
+  uint64_t _offset = 0;
+  std::vector<cache_block_info> _index;
+};
+
+// Decodes the features of the examples of a block in order. Safe to use from any thread.
+class cache_column_decoder
+{
+public:
+  void reset(const char* begin, const char* end);
+  // Decodes the features of the namespaces listed in ae.indices, which cache_block_reader reads.
+  void decode_example(example& ae);
+
+private:
+  struct varint_cursor
+  {
+    const unsigned char* control = nullptr;
+    const char* data = nullptr;
+    const unsigned char* lengths = nullptr;
+    size_t position = 0;
+    uint64_t next();
+  };
+
+  struct column_cursor
+  {
+    varint_cursor counts;
+    varint_cursor deltas;
+    const unsigned char* kinds = nullptr;
+    const char* values = nullptr;
+    const char* values_end = nullptr;
+    size_t remaining_counts = 0;
+    size_t remaining_features = 0;
+  };
+
+  std::array<column_cursor, 256> _columns;
+  std::vector<namespace_index> _used_columns;
+};
+
+// Reads cache_format_blocks blocks out of the input one example at a time.
+class cache_block_reader
+{
+public:
+  cache_block_reader() = default;
+  cache_block_reader(const cache_block_reader&) = delete;
+  cache_block_reader& operator=(const cache_block_reader&) = delete;
+
+  // Moves on to the next block, skipping over block indexes between files. Returns false at the end of the input. The
+  // block is read in place, so the input must not be read by anything else until the block has been consumed.
+  bool read_block(io_buf& input);
+  // Number of examples of the current block whose header has not been read yet.
+  size_t remaining() const { return _remaining; }
+  // Reads the label, tag and namespaces of the next example of the current block. Not thread safe as reading labels
+  // updates shared_dat. Returns 0 if the block is truncated.
+  size_t read_example_header(example* ae, label_parser& lbl_parser, bool sorted_cache, shared_data* shared_dat);
+  // Encoded features of the current block, to be decoded with a cache_column_decoder.
+  const char* columns_begin() const { return _columns_begin; }
+  const char* columns_end() const { return _columns_end; }
+  cache_column_decoder& columns() { return _columns; }
+  // Drops the current block, as the input has been reset.
+  void reset();
+  // Only hands out every count-th block starting at block index, counted across all input files, so that several
+  // readers of the same cache each see a disjoint shard of it. Skipped blocks are not decoded.
+  void set_shard(size_t index, size_t count);
+
+private:
+  io_buf _rows;
+  cache_column_decoder _columns;
+  const char* _columns_begin = nullptr;
+  const char* _columns_end = nullptr;
+  size_t _remaining = 0;
+  size_t _shard_index = 0;
+  size_t _shard_count = 1;
+  size_t _next_block = 0;
+};
 }  // namespace VW
+
+int read_cached_block_features(vw* all, v_array<example*>& examples);
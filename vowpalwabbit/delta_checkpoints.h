@@ -0,0 +1,67 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace VW
+{
+// What --delta_checkpoints needs to save a model as a delta of the one before: which model the weights were last
+// saved as or loaded from, and a hash of every block of the weights as they were then. A block whose hash changed
+// since goes into the next delta, together with all of the state of the reductions. A delta names the model it
+// applies to, so that a chain of them is only loaded on top of the model it was saved after.
+struct delta_checkpoints
+{
+  // Weights per block, a page of 4 kB.
+  static constexpr size_t block_weights = 1024;
+
+  // Every full_every-th model saved is full, the others are deltas. 0 without --delta_checkpoints.
+  uint64_t full_every = 0;
+  // Id of the model saved or loaded last, 0 for none.
+  uint64_t last_id = 0;
+  // Deltas saved or loaded since the last full model.
+  uint64_t chain_length = 0;
+  // Hash of every block as of last_id, empty when they are not known. They are not kept when loading without
+  // training, the next model saved is then full.
+  std::vector<uint64_t> block_hashes;
+
+  bool enabled() const { return full_every > 0; }
+
+  static uint64_t new_id()
+  {
+    std::random_device device;
+    uint64_t id = 0;
+    while (id == 0) { id = (static_cast<uint64_t>(device()) << 32) ^ device(); }
+    return id;
+  }
+
+  static uint64_t hash_block(const float* weights, size_t count)
+  {
+    uint64_t hash = 0x9e3779b97f4a7c15ULL ^ count;
+    const auto* bytes = reinterpret_cast<const unsigned char*>(weights);
+    const size_t num_bytes = count * sizeof(float);
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= num_bytes; i += sizeof(uint64_t))
+    {
+      uint64_t word;
+      memcpy(&word, bytes + i, sizeof(word));
+      hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+      hash ^= hash >> 29;
+    }
+    if (i < num_bytes)
+    {
+      uint32_t word;
+      memcpy(&word, bytes + i, sizeof(word));
+      hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+      hash ^= hash >> 29;
+    }
+    return hash;
+  }
+};
+}  // namespace VW
@@ -331,6 +331,20 @@ void return_multiple_example(vw& all, v_array<example*>& examples)
   examples.clear();
 }
 
+void use_feature_arena(example& ec)
+{
+  if (ec.arena != nullptr) return;
+  ec.arena.reset(new feature_arena());
+  ec.feature_space.use_arena(ec.arena.get());
+}
+
+void reset_feature_arena(example& ec)
+{
+  // Reductions may fill groups that are not in indices, so all of them are released.
+  for (features& fs : ec.feature_space) { fs.release_arena_storage(); }
+  ec.arena->reset();
+}
+
 }  // namespace VW
 
 std::string debug_depth_indent_string(const example& ec)
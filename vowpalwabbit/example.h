@@ -13,6 +13,7 @@
 #include "cb.h"
 #include "constant.h"
 #include "feature_group.h"
+#include "feature_arena.h"
 #include "action_score.h"
 #include "example_predict.h"
 #include "conditional_contextual_bandit.h"
@@ -25,6 +26,7 @@
 #include "active_multiclass_prediction.h"
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 #include <iostream>
 
@@ -112,6 +114,9 @@ struct example : public example_predict  // core example datatype.
   features* passthrough =
       nullptr;  // if a higher-up reduction wants access to internal state of lower-down reductions, they go here
 
+  // Storage of the feature groups with --feature_arena, reset when the example goes back to the pool.
+  std::unique_ptr<VW::feature_arena> arena;
+
   bool test_only = false;
   bool end_pass = false;  // special example indicating end of pass.
   bool sorted = false;    // Are the features sorted or not?
@@ -192,6 +197,11 @@ namespace VW
 {
 void return_multiple_example(vw& all, v_array<example*>& examples);
 
+// Gives ec an arena of its own that all of its feature groups grow into from then on, see VW::feature_arena.
+void use_feature_arena(example& ec);
+// Empties the feature groups living in the arena of ec and makes the arena available to the next example.
+void reset_feature_arena(example& ec);
+
 typedef example& (*example_factory_t)(void*);
 
 }  // namespace VW
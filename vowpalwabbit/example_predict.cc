@@ -6,12 +6,12 @@
 
 #include <sstream>
 
-example_predict::iterator::iterator(features* feature_space, namespace_index* index)
+example_predict::iterator::iterator(VW::feature_space_map* feature_space, namespace_index* index)
     : _feature_space(feature_space), _index(index)
 {
 }
 
-features& example_predict::iterator::operator*() { return _feature_space[*_index]; }
+features& example_predict::iterator::operator*() { return (*_feature_space)[*_index]; }
 
 example_predict::iterator& example_predict::iterator::operator++()
 {
@@ -24,8 +24,8 @@ namespace_index example_predict::iterator::index() { return *_index; }
 bool example_predict::iterator::operator==(const iterator& rhs) { return _index == rhs._index; }
 bool example_predict::iterator::operator!=(const iterator& rhs) { return _index != rhs._index; }
 
-example_predict::iterator example_predict::begin() { return {feature_space.data(), indices.begin()}; }
-example_predict::iterator example_predict::end() { return {feature_space.data(), indices.end()}; }
+example_predict::iterator example_predict::begin() { return {&feature_space, indices.begin()}; }
+example_predict::iterator example_predict::end() { return {&feature_space, indices.end()}; }
 
 VW_WARNING_STATE_PUSH
 VW_WARNING_DISABLE_DEPRECATED_USAGE
@@ -9,6 +9,7 @@ typedef unsigned char namespace_index;
 #include "future_compat.h"
 #include "reduction_features.h"
 #include "feature_group.h"
+#include "feature_space_map.h"
 #include "v_array.h"
 
 #include <vector>
@@ -31,11 +32,11 @@ struct example_predict
 {
   class iterator
   {
-    features* _feature_space;
+    VW::feature_space_map* _feature_space;
     v_array<namespace_index>::iterator _index;
 
   public:
-    iterator(features* feature_space, namespace_index* index);
+    iterator(VW::feature_space_map* feature_space, namespace_index* index);
     features& operator*();
     iterator& operator++();
     namespace_index index();
@@ -56,8 +57,8 @@ struct example_predict
   iterator end();
 
   v_array<namespace_index> indices;
-  std::array<features, NUM_NAMESPACES> feature_space;  // Groups of feature values.
-  uint64_t ft_offset = 0;                              // An offset for all feature values.
+  VW::feature_space_map feature_space;  // Groups of feature values, allocated as namespaces are used.
+  uint64_t ft_offset = 0;               // An offset for all feature values.
 
   // Interactions are specified by this struct's interactions vector of vectors of unsigned characters, where each
   // vector is an interaction and each char is a namespace.
@@ -0,0 +1,96 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+#include "vw_exception.h"
+
+namespace VW
+{
+// Bump allocator backing the feature groups of one example, see --feature_arena. Memory is handed out front to back
+// and only given back all at once by reset, when the example returns to the pool, so parsing an example takes no
+// allocations of its own. Requests that do not fit the block spill into blocks of their own, which reset folds into
+// one block of the combined size. Once the block has grown to the size of the examples, the feature groups of an
+// example sit next to each other in one block, in the order they were filled.
+class feature_arena
+{
+public:
+  static constexpr size_t alignment = alignof(std::max_align_t);
+  static constexpr size_t initial_block_size = 1 << 14;
+
+  static size_t align(size_t bytes) { return (bytes + alignment - 1) & ~(alignment - 1); }
+
+  feature_arena() = default;
+  feature_arena(const feature_arena&) = delete;
+  feature_arena& operator=(const feature_arena&) = delete;
+  ~feature_arena()
+  {
+    free_spills();
+    std::free(_block);
+  }
+
+  // Returns bytes of memory aligned for any feature type, valid until the next reset.
+  void* allocate(size_t bytes)
+  {
+    bytes = align(bytes);
+    _bytes_used += bytes;
+    if (_block == nullptr)
+    {
+      _block = static_cast<unsigned char*>(std::malloc(_block_size));
+      if (_block == nullptr) { THROW_OR_RETURN("malloc of " << _block_size << " failed in feature_arena.", nullptr); }
+    }
+    if (bytes > _block_size - _block_used)
+    {
+      void* spill = std::malloc(bytes);
+      if (spill == nullptr) { THROW_OR_RETURN("malloc of " << bytes << " failed in feature_arena.", nullptr); }
+      _spills.push_back(spill);
+      return spill;
+    }
+    void* memory = _block + _block_used;
+    _block_used += bytes;
+    return memory;
+  }
+
+  // Makes all memory handed out available again. Nothing allocated since the last reset may be used afterwards.
+  void reset()
+  {
+    if (!_spills.empty())
+    {
+      free_spills();
+      std::free(_block);
+      _block = nullptr;
+      while (_block_size < _bytes_used) { _block_size *= 2; }
+    }
+    _block_used = 0;
+    _bytes_used = 0;
+  }
+
+  size_t block_size() const { return _block_size; }
+  // Whether memory was handed out from the block rather than spilled.
+  bool in_block(const void* memory) const
+  {
+    auto* bytes = static_cast<const unsigned char*>(memory);
+    return _block != nullptr && bytes >= _block && bytes < _block + _block_used;
+  }
+  // Bytes handed out since the last reset, including spills.
+  size_t bytes_used() const { return _bytes_used; }
+
+private:
+  void free_spills()
+  {
+    for (void* spill : _spills) { std::free(spill); }
+    _spills.clear();
+  }
+
+  unsigned char* _block = nullptr;
+  size_t _block_size = initial_block_size;
+  size_t _block_used = 0;
+  size_t _bytes_used = 0;
+  std::vector<void*> _spills;
+};
+}  // namespace VW
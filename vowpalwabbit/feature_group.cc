@@ -4,6 +4,7 @@
 
 #include "feature_group.h"
 
+#include "feature_arena.h"
 #include "v_array.h"
 
 #include <vector>
@@ -17,6 +18,22 @@ struct feature_slice  // a helper struct for functions using the set {v,i,space_
   audit_strings space_name;
 };
 
+features::features(const features& other)
+    : values(other.values), indicies(other.indicies), space_names(other.space_names), sum_feat_sq(other.sum_feat_sq)
+{
+}
+
+features& features::operator=(const features& other)
+{
+  if (this == &other) { return *this; }
+  if (arena != nullptr) { reserve(other.size()); }
+  values = other.values;
+  indicies = other.indicies;
+  space_names = other.space_names;
+  sum_feat_sq = other.sum_feat_sq;
+  return *this;
+}
+
 void features::free_space_names(size_t i) { space_names.erase(space_names.begin() + i, space_names.end()); }
 
 void features::clear()
@@ -53,6 +70,7 @@ void features::concat(const features& other)
 
   if (!empty() && (space_names.empty() != other.space_names.empty()))
   { THROW_OR_RETURN_VOID("Cannot merge two feature groups if one has audit info and the other does not."); }
+  reserve(size() + other.size());
   values.insert(values.end(), other.values.begin(), other.values.end());
   indicies.insert(indicies.end(), other.indicies.begin(), other.indicies.end());
 
@@ -62,11 +80,19 @@ void features::concat(const features& other)
 
 void features::push_back(feature_value v, feature_index i)
 {
+  if (arena != nullptr && values.size() == values.capacity()) { grow_in_arena(values.size() + 1); }
   values.push_back(v);
   indicies.push_back(i);
   sum_feat_sq += v * v;
 }
 
+void features::reserve(size_t capacity)
+{
+  if (arena != nullptr && capacity > values.capacity()) { grow_in_arena(capacity); }
+  values.reserve(capacity);
+  indicies.reserve(capacity);
+}
+
 bool features::sort(uint64_t parse_mask)
 {
   if (indicies.empty()) { return false; }
@@ -110,6 +136,24 @@ bool features::sort(uint64_t parse_mask)
   return true;
 }
 
+void features::grow_in_arena(size_t capacity)
+{
+  capacity = std::max({capacity, 2 * values.capacity(), _arena_capacity, static_cast<size_t>(16)});
+  const size_t values_bytes = VW::feature_arena::align(capacity * sizeof(feature_value));
+  auto* block = static_cast<unsigned char*>(arena->allocate(values_bytes + capacity * sizeof(feature_index)));
+  if (block == nullptr) { return; }
+  // Values and indicies of the group share the block, so the features of a group are read from one place.
+  values.use_storage(reinterpret_cast<feature_value*>(block), capacity);
+  indicies.use_storage(reinterpret_cast<feature_index*>(block + values_bytes), capacity);
+  _arena_capacity = capacity;
+}
+
+void features::release_arena_storage()
+{
+  values.release_borrowed_storage();
+  indicies.release_borrowed_storage();
+}
+
 void features::deep_copy_from(const features& src)
 {
   values = src.values;
@@ -23,6 +23,11 @@ using audit_strings = std::pair<std::string, std::string>;
 struct features;
 struct features_value_index_audit_range;
 
+namespace VW
+{
+class feature_arena;
+}
+
 // sparse feature definition for the library interface
 struct feature
 {
@@ -295,10 +300,14 @@ struct features
 
   float sum_feat_sq = 0.f;
 
+  // When set, values and indicies grow into this arena instead of the heap, see VW::feature_arena. Copies do not
+  // inherit it.
+  VW::feature_arena* arena = nullptr;
+
   features() = default;
   ~features() = default;
-  features(const features&) = default;
-  features& operator=(const features&) = default;
+  features(const features& other);
+  features& operator=(const features& other);
 
   // custom move operators required since we need to leave the old value in
   // a null state to prevent freeing of shallow copied v_arrays
@@ -345,8 +354,19 @@ struct features
   void truncate_to(size_t i);
   void concat(const features& other);
   void push_back(feature_value v, feature_index i);
+  // Makes room for capacity features, in arena if there is one.
+  void reserve(size_t capacity);
   bool sort(uint64_t parse_mask);
 
+  // Forgets the storage borrowed from arena, which is about to be reset.
+  void release_arena_storage();
+
   VW_DEPRECATED("deep_copy_from is deprecated. Use the copy constructor directly. This will be removed in VW 9.0.")
   void deep_copy_from(const features& src);
+
+private:
+  // Moves values and indicies into one arena block for at least capacity features.
+  void grow_in_arena(size_t capacity);
+
+  size_t _arena_capacity = 0;  // The capacity last taken from arena, the first guess for the next example.
 };
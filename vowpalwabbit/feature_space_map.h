@@ -0,0 +1,120 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+#include "constant.h"
+#include "feature_group.h"
+
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+typedef unsigned char namespace_index;
+
+namespace VW
+{
+class feature_arena;
+
+// The feature groups of an example by namespace index. Indexing works like the array of NUM_NAMESPACES groups it
+// replaces, but a group is only allocated once its namespace is first used, so an example costs a table of pointers
+// plus the groups it actually has. Groups keep their address for the life of the map and are kept when they empty, so
+// an example coming back from the pool reuses them. Looking up an unused namespace of a const map gives a shared empty
+// group instead of allocating one.
+class feature_space_map
+{
+  using storage = std::vector<std::unique_ptr<features>>;
+
+  template <typename FeaturesT, typename StorageIteratorT>
+  class group_iterator
+  {
+    StorageIteratorT _it;
+
+  public:
+    explicit group_iterator(StorageIteratorT it) : _it(it) {}
+    FeaturesT& operator*() const { return **_it; }
+    FeaturesT* operator->() const { return _it->get(); }
+    group_iterator& operator++()
+    {
+      ++_it;
+      return *this;
+    }
+    bool operator==(const group_iterator& rhs) const { return _it == rhs._it; }
+    bool operator!=(const group_iterator& rhs) const { return _it != rhs._it; }
+  };
+
+public:
+  // Iterate over the groups allocated so far, in the order their namespaces were first used.
+  using iterator = group_iterator<features, storage::iterator>;
+  using const_iterator = group_iterator<const features, storage::const_iterator>;
+
+  feature_space_map() { _groups_by_index.fill(nullptr); }
+  feature_space_map(const feature_space_map&) = delete;
+  feature_space_map& operator=(const feature_space_map&) = delete;
+  feature_space_map(feature_space_map&& other) noexcept
+      : _groups(std::move(other._groups)), _groups_by_index(other._groups_by_index), _arena(other._arena)
+  {
+    other._groups.clear();
+    other._groups_by_index.fill(nullptr);
+  }
+  feature_space_map& operator=(feature_space_map&& other) noexcept
+  {
+    std::swap(_groups, other._groups);
+    std::swap(_groups_by_index, other._groups_by_index);
+    std::swap(_arena, other._arena);
+    return *this;
+  }
+
+  inline features& operator[](namespace_index ns)
+  {
+    features* group = _groups_by_index[ns];
+    return group != nullptr ? *group : allocate(ns);
+  }
+
+  inline const features& operator[](namespace_index ns) const
+  {
+    const features* group = _groups_by_index[ns];
+    return group != nullptr ? *group : empty_group();
+  }
+
+  // The group of ns, nullptr if ns was never used.
+  inline features* find(namespace_index ns) const { return _groups_by_index[ns]; }
+
+  // Number of groups allocated so far.
+  inline size_t allocated() const { return _groups.size(); }
+
+  // Lets all groups, present and future, grow into arena, see VW::feature_arena.
+  void use_arena(feature_arena* arena)
+  {
+    _arena = arena;
+    for (auto& group : _groups) { group->arena = arena; }
+  }
+
+  iterator begin() { return iterator(_groups.begin()); }
+  iterator end() { return iterator(_groups.end()); }
+  const_iterator begin() const { return const_iterator(_groups.cbegin()); }
+  const_iterator end() const { return const_iterator(_groups.cend()); }
+
+private:
+  features& allocate(namespace_index ns)
+  {
+    _groups.emplace_back(new features());
+    features* group = _groups.back().get();
+    group->arena = _arena;
+    _groups_by_index[ns] = group;
+    return *group;
+  }
+
+  static const features& empty_group()
+  {
+    static const features empty;
+    return empty;
+  }
+
+  storage _groups;
+  std::array<features*, NUM_NAMESPACES> _groups_by_index;
+  feature_arena* _arena = nullptr;
+};
+}  // namespace VW
@@ -3,7 +3,12 @@
 // license as described in the file LICENSE.
 #include "crossplat_compat.h"
 
+#include <atomic>
 #include <cfloat>
+#include <exception>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #if !defined(VW_NO_INLINE_SIMD)
 #  if !defined(__SSE2__) && (defined(_M_AMD64) || defined(_M_X64))
@@ -50,7 +55,14 @@ struct gd
   float neg_norm_power;
   float neg_power_t;
   float sparse_l2;
-  float update_multiplier;
+  // With --hogwild several learner threads update the weights at once. The counters of the normalized update are
+  // then kept in these atomics instead, and copied back into total_weight and vw::normalized_sum_norm_x whenever the
+  // learner threads are idle.
+  bool hogwild;
+  std::atomic<double> hogwild_total_weight;
+  std::atomic<double> hogwild_sum_norm_x;
+  // The t of get_scale, counted as examples are learned since shared_data is only updated as they are finished.
+  std::atomic<double> hogwild_t;
   void (*predict)(gd&, base_learner&, example&);
   void (*learn)(gd&, base_learner&, example&);
   void (*update)(gd&, base_learner&, example&);
@@ -116,7 +128,27 @@ inline void update_feature(float& update, float x, float& fw)
     w[0] += update * x;
   }
 }
+}  // namespace GD
+
+// With the feature mask off and neither adaptive nor normalized state, as with --sgd, the update is a plain
+// scatter-add which the interactions run with a vectorized kernel.
+namespace INTERACTIONS
+{
+template <>
+struct simd_func<float, float&, GD::update_feature<false, true, 0, 0, 0>>
+{
+  static constexpr simd_op op = simd_op::add;
+};
 
+template <>
+struct simd_func<float, float&, GD::update_feature<true, true, 0, 0, 0>>
+{
+  static constexpr simd_op op = simd_op::add;
+};
+}  // namespace INTERACTIONS
+
+namespace GD
+{
 // this deals with few nonzero features vs. all nonzero features issues.
 template <bool sqrt_rate, size_t adaptive, size_t normalized>
 float average_update(float total_weight, float normalized_sum_norm_x, float neg_norm_power)
@@ -138,16 +170,48 @@ float average_update(float total_weight, float normalized_sum_norm_x, float neg_
 }
 
 template <bool sqrt_rate, bool feature_mask_off, size_t adaptive, size_t normalized, size_t spare>
-void train(gd& g, example& ec, float update)
+void train(gd& g, example& ec, float update, float update_multiplier)
 {
-  if VW_STD17_CONSTEXPR (normalized != 0) { update *= g.update_multiplier; }
+  if VW_STD17_CONSTEXPR (normalized != 0) { update *= update_multiplier; }
   VW_DBG(ec) << "gd: train() spare=" << spare << std::endl;
   foreach_feature<float, update_feature<sqrt_rate, feature_mask_off, adaptive, normalized, spare> >(*g.all, ec, update);
 }
 
+double hogwild_add(std::atomic<double>& counter, double value)
+{
+  double current = counter.load(std::memory_order_relaxed);
+  while (!counter.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {}
+  return current + value;
+}
+
+// The weight of the examples learned from so far, including initial_t.
+double learned_t(const shared_data& sd)
+{
+  return sd.t - sd.weighted_holdout_examples - sd.weighted_unlabeled_examples;
+}
+
+// Copies the counters of the normalized update between the atomics used by the learner threads and the fields which are
+// saved with the model. Only called while no learner thread is running.
+void load_hogwild_counters(gd& g)
+{
+  g.hogwild_total_weight.store(g.total_weight);
+  g.hogwild_sum_norm_x.store(g.all->normalized_sum_norm_x);
+  g.hogwild_t.store(learned_t(*g.all->sd));
+}
+
+void store_hogwild_counters(gd& g)
+{
+  if (!g.hogwild) { return; }
+  g.total_weight = g.hogwild_total_weight.load();
+  g.all->normalized_sum_norm_x = g.hogwild_sum_norm_x.load();
+  // Every example learned from is finished by now, so shared_data has the exact count again.
+  g.hogwild_t.store(learned_t(*g.all->sd));
+}
+
 void end_pass(gd& g)
 {
   vw& all = *g.all;
+  store_hogwild_counters(g);
   if (all.save_resume)
   {
     // TODO work out a better system to update state that will be saved in the model.
@@ -552,7 +616,7 @@ inline void pred_per_update_feature(norm_data& nd, float x, float& fw)
 bool global_print_features = false;
 template <bool sqrt_rate, bool feature_mask_off, bool adax, size_t adaptive, size_t normalized, size_t spare,
     bool stateless>
-float get_pred_per_update(gd& g, example& ec)
+float get_pred_per_update(gd& g, example& ec, float& update_multiplier)
 {
   // We must traverse the features in _precisely_ the same order as during training.
   label_data& ld = ec.l.simple;
@@ -570,31 +634,47 @@ float get_pred_per_update(gd& g, example& ec)
   {
     if (!stateless)
     {
-      g.all->normalized_sum_norm_x += (static_cast<double>(ec.weight)) * nd.norm_x;
-      g.total_weight += ec.weight;
-      g.update_multiplier = average_update<sqrt_rate, adaptive, normalized>(
-          static_cast<float>(g.total_weight), static_cast<float>(g.all->normalized_sum_norm_x), g.neg_norm_power);
+      if (g.hogwild)
+      {
+        const double nsnx = hogwild_add(g.hogwild_sum_norm_x, (static_cast<double>(ec.weight)) * nd.norm_x);
+        const double tw = hogwild_add(g.hogwild_total_weight, ec.weight);
+        update_multiplier = average_update<sqrt_rate, adaptive, normalized>(
+            static_cast<float>(tw), static_cast<float>(nsnx), g.neg_norm_power);
+      }
+      else
+      {
+        g.all->normalized_sum_norm_x += (static_cast<double>(ec.weight)) * nd.norm_x;
+        g.total_weight += ec.weight;
+        update_multiplier = average_update<sqrt_rate, adaptive, normalized>(
+            static_cast<float>(g.total_weight), static_cast<float>(g.all->normalized_sum_norm_x), g.neg_norm_power);
+      }
     }
     else
     {
-      float nsnx = (static_cast<float>(g.all->normalized_sum_norm_x)) + ec.weight * nd.norm_x;
-      float tw = static_cast<float>(g.total_weight) + ec.weight;
-      g.update_multiplier = average_update<sqrt_rate, adaptive, normalized>(tw, nsnx, g.neg_norm_power);
+      const double sum_norm_x = g.hogwild ? g.hogwild_sum_norm_x.load() : g.all->normalized_sum_norm_x;
+      const double total_weight = g.hogwild ? g.hogwild_total_weight.load() : g.total_weight;
+      float nsnx = (static_cast<float>(sum_norm_x)) + ec.weight * nd.norm_x;
+      float tw = static_cast<float>(total_weight) + ec.weight;
+      update_multiplier = average_update<sqrt_rate, adaptive, normalized>(tw, nsnx, g.neg_norm_power);
     }
-    nd.pred_per_update *= g.update_multiplier;
+    nd.pred_per_update *= update_multiplier;
   }
   return nd.pred_per_update;
 }
 
 template <bool sqrt_rate, bool feature_mask_off, bool adax, size_t adaptive, size_t normalized, size_t spare,
     bool stateless>
-float sensitivity(gd& g, example& ec)
+float sensitivity(gd& g, example& ec, float& update_multiplier)
 {
   if VW_STD17_CONSTEXPR (adaptive || normalized)
-    return get_pred_per_update<sqrt_rate, feature_mask_off, adax, adaptive, normalized, spare, stateless>(g, ec);
+  {
+    return get_pred_per_update<sqrt_rate, feature_mask_off, adax, adaptive, normalized, spare, stateless>(
+        g, ec, update_multiplier);
+  }
   else
   {
     _UNUSED(g);
+    _UNUSED(update_multiplier);
     return ec.get_total_sum_feat_sq();
   }
 }
@@ -606,8 +686,8 @@ float get_scale(gd& g, example& /* ec */, float weight)
   float update_scale = g.all->eta * weight;
   if (!adaptive)
   {
-    float t = static_cast<float>(
-        g.all->sd->t + weight - g.all->sd->weighted_holdout_examples - g.all->sd->weighted_unlabeled_examples);
+    // Under --hogwild shared_data is written by whichever learner thread finishes an example.
+    float t = static_cast<float>((g.hogwild ? g.hogwild_t.load() : learned_t(*g.all->sd)) + weight);
     update_scale *= powf(t, g.neg_power_t);
   }
   return update_scale;
@@ -616,13 +696,14 @@ float get_scale(gd& g, example& /* ec */, float weight)
 template <bool sqrt_rate, bool feature_mask_off, bool adax, size_t adaptive, size_t normalized, size_t spare>
 float sensitivity(gd& g, base_learner& /* base */, example& ec)
 {
+  float update_multiplier;
   return get_scale<adaptive>(g, ec, 1.) *
-      sensitivity<sqrt_rate, feature_mask_off, adax, adaptive, normalized, spare, true>(g, ec);
+      sensitivity<sqrt_rate, feature_mask_off, adax, adaptive, normalized, spare, true>(g, ec, update_multiplier);
 }
 
 template <bool sparse_l2, bool invariant, bool sqrt_rate, bool feature_mask_off, bool adax, size_t adaptive,
     size_t normalized, size_t spare>
-float compute_update(gd& g, example& ec)
+float compute_update(gd& g, example& ec, float& update_multiplier)
 {
   // invariant: not a test label, importance weight > 0
   const label_data& ld = ec.l.simple;
@@ -632,7 +713,8 @@ float compute_update(gd& g, example& ec)
   ec.updated_prediction = ec.pred.scalar;
   if (all.loss->getLoss(all.sd, ec.pred.scalar, ld.label) > 0.)
   {
-    float pred_per_update = sensitivity<sqrt_rate, feature_mask_off, adax, adaptive, normalized, spare, false>(g, ec);
+    float pred_per_update =
+        sensitivity<sqrt_rate, feature_mask_off, adax, adaptive, normalized, spare, false>(g, ec, update_multiplier);
     float update_scale = get_scale<adaptive>(g, ec, ec.weight);
     if (invariant)
       update = all.loss->getUpdate(ec.pred.scalar, ld.label, update_scale, pred_per_update);
@@ -662,15 +744,51 @@ float compute_update(gd& g, example& ec)
   return update;
 }
 
+struct hogwild_update_data
+{
+  float update;
+  power_data pd;
+};
+
+// get_pred_per_update leaves the rate of every feature in its spare slot for train to pick up. Under --hogwild another
+// learner thread may overwrite the slot in between, so the rate is worked out again from the adaptive and normalized
+// slots instead.
+template <bool sqrt_rate, bool feature_mask_off, size_t adaptive, size_t normalized>
+inline void hogwild_update_feature(hogwild_update_data& d, float x, float& fw)
+{
+  bool modify = x < FLT_MAX && x > -FLT_MAX && (feature_mask_off || fw != 0.);
+  if (modify)
+  {
+    x *= compute_rate_decay<sqrt_rate, adaptive, normalized>(d.pd, fw);
+    fw += d.update * x;
+  }
+}
+
+template <bool sqrt_rate, bool feature_mask_off, size_t adaptive, size_t normalized>
+void hogwild_train(gd& g, example& ec, float update, float update_multiplier)
+{
+  if VW_STD17_CONSTEXPR (normalized != 0) { update *= update_multiplier; }
+  hogwild_update_data d = {update, {g.neg_power_t, g.neg_norm_power}};
+  foreach_feature<hogwild_update_data, hogwild_update_feature<sqrt_rate, feature_mask_off, adaptive, normalized> >(
+      *g.all, ec, d);
+}
+
 template <bool sparse_l2, bool invariant, bool sqrt_rate, bool feature_mask_off, bool adax, size_t adaptive,
     size_t normalized, size_t spare>
 void update(gd& g, base_learner&, example& ec)
 {
   // invariant: not a test label, importance weight > 0
   float update;
+  float update_multiplier = 1.f;
   if ((update = compute_update<sparse_l2, invariant, sqrt_rate, feature_mask_off, adax, adaptive, normalized, spare>(
-           g, ec)) != 0.)
-    train<sqrt_rate, feature_mask_off, adaptive, normalized, spare>(g, ec, update);
+           g, ec, update_multiplier)) != 0.)
+  {
+    if ((adaptive || normalized) && g.hogwild)
+      hogwild_train<sqrt_rate, feature_mask_off, adaptive, normalized>(g, ec, update, update_multiplier);
+    else
+      train<sqrt_rate, feature_mask_off, adaptive, normalized, spare>(g, ec, update, update_multiplier);
+  }
+  if (!adaptive && g.hogwild) { hogwild_add(g.hogwild_t, ec.weight); }
 
   if (g.all->sd->contraction < 1e-9 || g.all->sd->gravity > 1e3)  // updating weights now to avoid numerical instability
     sync_weights(*g.all);
@@ -722,11 +840,370 @@ size_t write_index(io_buf& model_file, std::stringstream& msg, bool text, uint32
   return brw;
 }
 
+// The binary layout of the weights without --flat_model: a record for every index with a non-zero value among the
+// first num_values of its stride, holding the index, in 4 bytes below 31 bits and 8 bytes above, then those values.
+// The records run to the end of the model. They have a fixed size, so dense weights are saved by threads encoding
+// ranges of indices into buffers of their own, which are written one after the other, and loaded by threads decoding
+// slices of the records read, see --model_io_threads. The bytes are the same for any number of threads.
+struct weight_records
+{
+  size_t index_bytes;
+  size_t num_values;
+
+  weight_records(const vw& all, size_t values)
+      : index_bytes(all.num_bits < 31 ? sizeof(uint32_t) : sizeof(uint64_t)), num_values(values)
+  {
+  }
+  size_t record_bytes() const { return index_bytes + num_values * sizeof(weight); }
+};
+
+constexpr uint64_t model_io_range = static_cast<uint64_t>(1) << 18;  // indices encoded by a thread at a time
+constexpr size_t model_io_records = static_cast<size_t>(1) << 20;  // records read at a time
+constexpr size_t model_io_min_slice = static_cast<size_t>(1) << 14;  // fewest records decoded by a thread
+
+size_t model_io_threads(const vw& all)
+{
+  if (all.model_io_threads > 0) return all.model_io_threads;
+  return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+// Runs work(0), ..., work(num_threads - 1) on threads of their own but the first, which runs on the calling thread,
+// and rethrows the first exception any of them threw.
+template <typename WorkT>
+void run_on_threads(size_t num_threads, WorkT&& work)
+{
+  std::vector<std::exception_ptr> errors(num_threads);
+  auto run = [&work, &errors](size_t index) {
+    try
+    {
+      work(index);
+    }
+    catch (...)
+    {
+      errors[index] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; i++) threads.emplace_back(run, i);
+  run(0);
+  for (auto& thread : threads) thread.join();
+  for (auto& error : errors)
+  {
+    if (error) std::rethrow_exception(error);
+  }
+}
+
+template <class IteratorT>
+void encode_records(
+    IteratorT it, IteratorT end, uint32_t stride_shift, const weight_records& layout, std::vector<char>& out)
+{
+  for (; it != end; ++it)
+  {
+    const weight* v = &(*it);
+    bool non_zero = false;
+    for (size_t j = 0; j < layout.num_values; j++) non_zero = non_zero || v[j] != 0.f;
+    if (!non_zero) continue;
+
+    const uint64_t i = it.index() >> stride_shift;
+    const size_t at = out.size();
+    out.resize(at + layout.record_bytes());
+    if (layout.index_bytes == sizeof(uint32_t))
+    {
+      const auto old_i = static_cast<uint32_t>(i);
+      memcpy(&out[at], &old_i, sizeof(old_i));
+    }
+    else
+      memcpy(&out[at], &i, sizeof(i));
+    memcpy(&out[at + layout.index_bytes], v, layout.num_values * sizeof(weight));
+  }
+}
+
+void save_records(vw& all, io_buf& model_file, dense_parameters& weights, const weight_records& layout)
+{
+  const uint64_t length = static_cast<uint64_t>(1) << all.num_bits;
+  const uint32_t shift = weights.stride_shift();
+  weight* begin = weights.first();
+  const size_t num_threads = model_io_threads(all);
+  std::vector<std::vector<char>> ranges(num_threads);
+  for (uint64_t round = 0; round < length; round += num_threads * model_io_range)
+  {
+    const auto num_ranges =
+        static_cast<size_t>(std::min<uint64_t>(num_threads, (length - round + model_io_range - 1) / model_io_range));
+    run_on_threads(num_ranges, [&](size_t r) {
+      const uint64_t first = round + r * model_io_range;
+      const uint64_t last = std::min(first + model_io_range, length);
+      ranges[r].clear();
+      encode_records(dense_parameters::iterator(begin + (first << shift), begin, weights.stride()),
+          dense_parameters::iterator(begin + (last << shift), begin, weights.stride()), shift, layout, ranges[r]);
+    });
+    for (size_t r = 0; r < num_ranges; r++) model_file.bin_write_fixed(ranges[r].data(), ranges[r].size());
+  }
+}
+
+void save_records(vw& /* all */, io_buf& model_file, sparse_parameters& weights, const weight_records& layout)
+{
+  std::vector<char> records;
+  for (auto it = weights.begin(); it != weights.end();)
+  {
+    auto next = it;
+    for (size_t n = 0; n < model_io_range && next != weights.end(); n++) ++next;
+    records.clear();
+    encode_records(it, next, weights.stride_shift(), layout, records);
+    model_file.bin_write_fixed(records.data(), records.size());
+    it = next;
+  }
+}
+
+// Without clear_rest only the first value of each stride is loaded, otherwise all of the stride is overwritten, with
+// zeros past the values saved.
 template <class T>
-void save_load_regressor(vw& all, io_buf& model_file, bool read, bool text, T& weights)
+void load_records(vw& all, io_buf& model_file, T& weights, const weight_records& layout, bool clear_rest)
 {
-  size_t brw = 1;
+  const uint64_t length = static_cast<uint64_t>(1) << all.num_bits;
+  const size_t stride = weights.stride();
+  const size_t num_values = std::min(layout.num_values, stride);
+  const size_t record_bytes = layout.record_bytes();
+  // Sparse weights insert indices as they are loaded, which only one thread may do at a time.
+  const size_t num_threads = std::is_same<T, dense_parameters>::value ? model_io_threads(all) : 1;
+
+  size_t bytes = 0;
+  do
+  {
+    char* records;
+    bytes = model_file.buf_read(records, model_io_records * record_bytes);
+    if (bytes % record_bytes != 0) THROW("Model content is corrupted, it ends within the weights of an index");
+    const size_t count = bytes / record_bytes;
+    const size_t num_slices = std::max<size_t>(std::min(num_threads, count / model_io_min_slice), 1);
+    const size_t slice = (count + num_slices - 1) / num_slices;
+    run_on_threads(num_slices, [&](size_t s) {
+      const size_t end = std::min(count, (s + 1) * slice);
+      for (size_t k = s * slice; k < end; k++)
+      {
+        const char* record = records + k * record_bytes;
+        uint64_t i = 0;
+        if (layout.index_bytes == sizeof(uint32_t))
+        {
+          uint32_t old_i = 0;
+          memcpy(&old_i, record, sizeof(old_i));
+          i = old_i;
+        }
+        else
+          memcpy(&i, record, sizeof(i));
+        if (i >= length)
+          THROW("Model content is corrupted, weight vector index " << i << " must be less than total vector length "
+                                                                   << length);
+        weight* v = &weights.strided_index(i);
+        memcpy(v, record + layout.index_bytes, (clear_rest ? num_values : 1) * sizeof(weight));
+        if (clear_rest)
+          for (size_t j = num_values; j < stride; j++) v[j] = 0.f;
+      }
+    });
+  } while (bytes == model_io_records * record_bytes);
+}
 
+// The dense weights of --flat_model: the number of bits, the stride shift and the offset of the weights in the file,
+// zeros up to that offset, which is a multiple of flat_model_alignment to be one of the page size, then all weights as
+// they are in memory. Like the sparse layout, the weights run to the end of the model. Loading maps them from the
+// model file where it can, and reads them otherwise. Without resume only the weights themselves are kept, the rest of
+// each stride is saved as zeros.
+constexpr uint64_t flat_model_alignment = static_cast<uint64_t>(1) << 16;
+constexpr size_t flat_model_chunk_bytes = static_cast<size_t>(1) << 20;
+
+void save_load_flat_weights(vw& all, io_buf& model_file, bool read, bool resume)
+{
+  if (all.weights.sparse) THROW("--flat_model saves dense weights, it cannot be used with --sparse_weights");
+  if (read) initialize_regressor(all);
+  dense_parameters& weights = all.weights.dense_weights;
+  const size_t length = static_cast<size_t>(weights.mask()) + 1;
+  const size_t stride = weights.stride();
+
+  std::stringstream msg;
+  uint32_t num_bits = all.num_bits;
+  uint32_t stride_shift = weights.stride_shift();
+  uint64_t offset = model_file.file_position() + sizeof(num_bits) + sizeof(stride_shift) + sizeof(offset);
+  offset = (offset + flat_model_alignment - 1) / flat_model_alignment * flat_model_alignment;
+  bin_text_read_write_fixed_validated(
+      model_file, reinterpret_cast<char*>(&num_bits), sizeof(num_bits), "", read, msg, false);
+  bin_text_read_write_fixed_validated(
+      model_file, reinterpret_cast<char*>(&stride_shift), sizeof(stride_shift), "", read, msg, false);
+  bin_text_read_write_fixed_validated(
+      model_file, reinterpret_cast<char*>(&offset), sizeof(offset), "", read, msg, false);
+
+  const uint64_t position = model_file.file_position();
+  if (offset < position || offset - position >= flat_model_alignment)
+    THROW("Model content is corrupted, the flat weights cannot start at byte " << offset);
+  std::vector<char> padding(static_cast<size_t>(offset - position), 0);
+  if (!read)
+  {
+    model_file.bin_write_fixed(padding.data(), padding.size());
+    const size_t chunk_length = std::max(flat_model_chunk_bytes / sizeof(weight), stride);
+    const weight* begin = weights.first();
+    std::vector<weight> chunk;
+    for (size_t done = 0; done < length; done += chunk_length)
+    {
+      const size_t n = std::min(chunk_length, length - done);
+      if (resume || stride == 1)
+      {
+        model_file.bin_write_fixed(reinterpret_cast<const char*>(begin + done), n * sizeof(weight));
+        continue;
+      }
+      chunk.assign(n, 0.f);
+      for (size_t i = 0; i < n; i += stride) chunk[i] = begin[done + i];
+      model_file.bin_write_fixed(reinterpret_cast<const char*>(chunk.data()), n * sizeof(weight));
+    }
+    return;
+  }
+
+  if (num_bits != all.num_bits || stride_shift != weights.stride_shift())
+    THROW("Model content is corrupted, the flat weights have " << num_bits << " bits and stride shift " << stride_shift
+                                                               << " instead of " << all.num_bits << " and "
+                                                               << weights.stride_shift());
+  if (model_file.bin_read_fixed(padding.data(), padding.size(), "") != padding.size())
+    THROW("Model content is corrupted, the file ends before the flat weights");
+
+  // Mapping the weights would bypass --huge_pages, --numa_policy and --weight_snapshots, they are read into the memory
+  // allocated for them instead.
+  const auto& files = model_file.get_input_files();
+  const int fd = model_file.current < files.size() ? files[model_file.current]->file_descriptor() : -1;
+  if (fd < 0 || !all.weight_allocation.is_default() || !weights.map_file(fd, offset))
+  {
+    char* begin = reinterpret_cast<char*>(weights.first());
+    const size_t bytes = length * sizeof(weight);
+    for (size_t done = 0; done < bytes;)
+    {
+      const size_t n = std::min(flat_model_chunk_bytes, bytes - done);
+      if (model_file.bin_read_fixed(begin + done, n, "") != n)
+        THROW("Model content is corrupted, the file ends within the flat weights");
+      done += n;
+    }
+  }
+
+  // As save_load sets it up for the sparse layout, which only overwrites the weights themselves.
+  if (!resume && all.training && all.weights.adaptive && all.initial_t > 0)
+    for (auto& w : weights) (&w)[1] = all.initial_t;
+}
+
+// Hashes blocks [0, num_blocks) of weights on up to --model_io_threads threads, and tells which are not all zero.
+void hash_blocks(const vw& all, const weight* begin, uint64_t block_weights, uint64_t num_blocks,
+    std::vector<uint64_t>& hashes, std::vector<char>& non_zero)
+{
+  hashes.resize(static_cast<size_t>(num_blocks));
+  non_zero.resize(static_cast<size_t>(num_blocks));
+  const size_t num_slices =
+      static_cast<size_t>(std::max<uint64_t>(std::min<uint64_t>(model_io_threads(all), num_blocks / 256), 1));
+  const uint64_t slice = (num_blocks + num_slices - 1) / num_slices;
+  run_on_threads(num_slices, [&](size_t s) {
+    const uint64_t end = std::min(num_blocks, (s + 1) * slice);
+    for (uint64_t b = s * slice; b < end; b++)
+    {
+      const weight* block = begin + b * block_weights;
+      hashes[b] = VW::delta_checkpoints::hash_block(block, block_weights);
+      non_zero[b] = std::any_of(block, block + block_weights, [](weight w) { return w != 0.f; });
+    }
+  });
+}
+
+// The dense weights of --delta_checkpoints: the id of the model, the id of the model it is a delta of or 0 when it is
+// full, the number of weights per block and of blocks, and the number of blocks saved, each of them followed by its
+// index and its weights. A full model saves the blocks which are not all zero, a delta those changed since the model
+// saved before. Blocks are saved whole, all of each stride is kept like with --save_resume.
+void save_load_checkpoint(vw& all, io_buf& model_file, bool read)
+{
+  if (read) initialize_regressor(all);
+  auto& checkpoints = all.checkpoints;
+  weight* begin = all.weights.dense_weights.first();
+  const uint64_t length = all.weights.dense_weights.mask() + 1;
+  const uint64_t expected_block_weights = std::min<uint64_t>(VW::delta_checkpoints::block_weights, length);
+  const uint64_t expected_num_blocks = length / expected_block_weights;
+
+  std::stringstream msg;
+  std::vector<uint64_t> hashes;
+  std::vector<char> non_zero;
+  std::vector<uint64_t> blocks;
+  uint64_t id = 0;
+  uint64_t parent = 0;
+  uint64_t block_weights = expected_block_weights;
+  uint64_t num_blocks = expected_num_blocks;
+  uint64_t num_saved = 0;
+  if (!read)
+  {
+    hash_blocks(all, begin, block_weights, num_blocks, hashes, non_zero);
+    const bool full = checkpoints.last_id == 0 || checkpoints.block_hashes.size() != hashes.size() ||
+        checkpoints.chain_length + 1 >= checkpoints.full_every;
+    id = VW::delta_checkpoints::new_id();
+    parent = full ? 0 : checkpoints.last_id;
+    for (uint64_t b = 0; b < num_blocks; b++)
+    {
+      if (full ? non_zero[b] != 0 : hashes[b] != checkpoints.block_hashes[b]) blocks.push_back(b);
+    }
+    num_saved = blocks.size();
+  }
+
+  bin_text_read_write_fixed_validated(model_file, reinterpret_cast<char*>(&id), sizeof(id), "", read, msg, false);
+  bin_text_read_write_fixed_validated(
+      model_file, reinterpret_cast<char*>(&parent), sizeof(parent), "", read, msg, false);
+  bin_text_read_write_fixed_validated(
+      model_file, reinterpret_cast<char*>(&block_weights), sizeof(block_weights), "", read, msg, false);
+  bin_text_read_write_fixed_validated(
+      model_file, reinterpret_cast<char*>(&num_blocks), sizeof(num_blocks), "", read, msg, false);
+  bin_text_read_write_fixed_validated(
+      model_file, reinterpret_cast<char*>(&num_saved), sizeof(num_saved), "", read, msg, false);
+
+  if (!read)
+  {
+    for (uint64_t b : blocks)
+    {
+      model_file.bin_write_fixed(reinterpret_cast<const char*>(&b), sizeof(b));
+      model_file.bin_write_fixed(
+          reinterpret_cast<const char*>(begin + b * block_weights), block_weights * sizeof(weight));
+    }
+    checkpoints.last_id = id;
+    checkpoints.chain_length = parent == 0 ? 0 : checkpoints.chain_length + 1;
+    checkpoints.block_hashes.swap(hashes);
+    return;
+  }
+
+  if (block_weights != expected_block_weights || num_blocks != expected_num_blocks || num_saved > num_blocks)
+    THROW("Model content is corrupted, the checkpoint has " << num_blocks << " blocks of " << block_weights
+                                                            << " weights instead of " << expected_num_blocks
+                                                            << " blocks of " << expected_block_weights);
+  if (parent == 0 && checkpoints.last_id != 0)
+    THROW("Checkpoint " << id << " is full, it cannot be loaded on top of checkpoint " << checkpoints.last_id
+                        << ". Load a full checkpoint first, then the deltas saved after it in order");
+  if (parent != 0 && parent != checkpoints.last_id)
+    THROW("Checkpoint " << id << " is a delta of checkpoint " << parent << " but the weights hold "
+                        << (checkpoints.last_id == 0 ? std::string("none") : std::to_string(checkpoints.last_id))
+                        << ". Load a full checkpoint first, then the deltas saved after it in order");
+
+  for (uint64_t n = 0; n < num_saved; n++)
+  {
+    uint64_t b = 0;
+    if (model_file.bin_read_fixed(reinterpret_cast<char*>(&b), sizeof(b), "") != sizeof(b) || b >= num_blocks)
+      THROW("Model content is corrupted, block " << n << " of checkpoint " << id << " is missing or out of range");
+    const size_t bytes = static_cast<size_t>(block_weights * sizeof(weight));
+    if (model_file.bin_read_fixed(reinterpret_cast<char*>(begin + b * block_weights), bytes, "") != bytes)
+      THROW("Model content is corrupted, the file ends within block " << b << " of checkpoint " << id);
+    blocks.push_back(b);
+  }
+
+  // Only learning goes on to save further deltas. A full checkpoint may leave blocks at their initial values, so all
+  // of them are hashed, a delta only changes the blocks it holds.
+  if (!all.training)
+    checkpoints.block_hashes.clear();
+  else if (parent == 0)
+    hash_blocks(all, begin, block_weights, num_blocks, checkpoints.block_hashes, non_zero);
+  else if (checkpoints.block_hashes.size() == num_blocks)
+  {
+    for (uint64_t b : blocks)
+      checkpoints.block_hashes[b] = VW::delta_checkpoints::hash_block(begin + b * block_weights, block_weights);
+  }
+  checkpoints.last_id = id;
+  checkpoints.chain_length = parent == 0 ? 0 : checkpoints.chain_length + 1;
+}
+
+template <class T>
+void save_load_regressor(vw& all, io_buf& model_file, bool read, bool text, T& weights)
+{
   if (all.print_invert)  // write readable model with feature names
   {
     std::stringstream msg;
@@ -752,44 +1229,34 @@ void save_load_regressor(vw& all, io_buf& model_file, bool read, bool text, T& w
     return;
   }
 
-  uint64_t i = 0;
-  uint32_t old_i = 0;
-  uint64_t length = static_cast<uint64_t>(1) << all.num_bits;
-  if (read) do
-    {
-      brw = 1;
-      if (all.num_bits < 31)  // backwards compatible
-      {
-        brw = model_file.bin_read_fixed(reinterpret_cast<char*>(&old_i), sizeof(old_i), "");
-        i = old_i;
-      }
-      else
-        brw = model_file.bin_read_fixed(reinterpret_cast<char*>(&i), sizeof(i), "");
-      if (brw > 0)
-      {
-        if (i >= length)
-          THROW("Model content is corrupted, weight vector index " << i << " must be less than total vector length "
-                                                                   << length);
-        weight* v = &weights.strided_index(i);
-        brw += model_file.bin_read_fixed(reinterpret_cast<char*>(&(*v)), sizeof(*v), "");
-      }
-    } while (brw > 0);
-  else  // write
-    for (typename T::iterator v = weights.begin(); v != weights.end(); ++v)
-      if (*v != 0.)
-      {
-        i = v.index() >> weights.stride_shift();
-        std::stringstream msg;
+  if (read)
+  {
+    load_records(all, model_file, weights, weight_records(all, 1), false);
+    return;
+  }
+  if (!text)
+  {
+    save_records(all, model_file, weights, weight_records(all, 1));
+    return;
+  }
 
-        brw = write_index(model_file, msg, text, all.num_bits, i);
-        msg << ":" << *v << "\n";
-        brw += bin_text_write_fixed(model_file, (char*)&(*v), sizeof(*v), msg, text);
-      }
+  std::stringstream msg;
+  for (typename T::iterator v = weights.begin(); v != weights.end(); ++v)
+    if (*v != 0.)
+    {
+      write_index(model_file, msg, true, all.num_bits, v.index() >> weights.stride_shift());
+      msg << ":" << *v << "\n";
+      bin_text_write_fixed(model_file, (char*)&(*v), sizeof(*v), msg, true);
+    }
 }
 
 void save_load_regressor(vw& all, io_buf& model_file, bool read, bool text)
 {
-  if (all.weights.sparse)
+  if (all.checkpoints.enabled() && !text && !all.print_invert)
+    save_load_checkpoint(all, model_file, read);
+  else if (all.flat_model && !text && !all.print_invert)
+    save_load_flat_weights(all, model_file, read, false);
+  else if (all.weights.sparse)
     save_load_regressor(all, model_file, read, text, all.weights.sparse_weights);
   else
     save_load_regressor(all, model_file, read, text, all.weights.dense_weights);
@@ -799,118 +1266,57 @@ template <class T>
 void save_load_online_state(
     vw& all, io_buf& model_file, bool read, bool text, gd* g, std::stringstream& msg, uint32_t ftrl_size, T& weights)
 {
-  uint64_t length = static_cast<uint64_t>(1) << all.num_bits;
+  if (read)
+  {
+    size_t num_values = 3;  // adaptive and normalized
+    if (ftrl_size > 0)
+      num_values = ftrl_size;
+    else if (g == nullptr || (!g->adaptive_input && !g->normalized_input))
+      num_values = 1;
+    else if (g->adaptive_input != g->normalized_input)
+      num_values = 2;
+    load_records(all, model_file, weights, weight_records(all, num_values), true);
+    return;
+  }
 
-  uint64_t i = 0;
-  uint32_t old_i = 0;
-  size_t brw = 1;
+  size_t num_values = 3;  // adaptive and normalized
+  if (ftrl_size > 0)
+    num_values = ftrl_size;
+  else if (g == nullptr || (!all.weights.adaptive && !all.weights.normalized))
+    num_values = 1;
+  else if (all.weights.adaptive != all.weights.normalized)
+    num_values = 2;
+  if (!text)
+  {
+    save_records(all, model_file, weights, weight_records(all, num_values));
+    return;
+  }
 
-  if (read) do
+  for (typename T::iterator v = weights.begin(); v != weights.end(); ++v)
+  {
+    const uint64_t i = v.index() >> weights.stride_shift();
+    const weight* values = &(*v);
+
+    if (all.print_invert && *v != 0.f)  // write readable model with feature names
     {
-      brw = 1;
-      if (all.num_bits < 31)  // backwards compatible
+      const auto map_it = all.index_name_map.find(i);
+      if (map_it != all.index_name_map.end())
       {
-        brw = model_file.bin_read_fixed(reinterpret_cast<char*>(&old_i), sizeof(old_i), "");
-        i = old_i;
-      }
-      else
-        brw = model_file.bin_read_fixed(reinterpret_cast<char*>(&i), sizeof(i), "");
-      if (brw > 0)
-      {
-        if (i >= length)
-          THROW("Model content is corrupted, weight vector index " << i << " must be less than total vector length "
-                                                                   << length);
-        weight buff[8] = {0, 0, 0, 0, 0, 0, 0, 0};
-        if (ftrl_size > 0)
-          brw += model_file.bin_read_fixed(reinterpret_cast<char*>(buff), sizeof(buff[0]) * ftrl_size, "");
-        else if (g == nullptr || (!g->adaptive_input && !g->normalized_input))
-          brw += model_file.bin_read_fixed(reinterpret_cast<char*>(buff), sizeof(buff[0]), "");
-        else if ((g->adaptive_input && !g->normalized_input) || (!g->adaptive_input && g->normalized_input))
-          brw += model_file.bin_read_fixed(reinterpret_cast<char*>(buff), sizeof(buff[0]) * 2, "");
-        else  // adaptive and normalized
-          brw += model_file.bin_read_fixed(reinterpret_cast<char*>(buff), sizeof(buff[0]) * 3, "");
-        uint32_t stride = 1 << weights.stride_shift();
-        weight* v = &weights.strided_index(i);
-        for (size_t j = 0; j < stride; j++) v[j] = buff[j];
+        msg << map_it->second << ":";
+        bin_text_write_fixed(model_file, nullptr /*unused*/, 0 /*unused*/, msg, true);
       }
-    } while (brw > 0);
-  else  // write binary or text
-    for (typename T::iterator v = weights.begin(); v != weights.end(); ++v)
-    {
-      i = v.index() >> weights.stride_shift();
+    }
 
-      if (all.print_invert)  // write readable model with feature names
-      {
-        if (*v != 0.f)
-        {
-          const auto map_it = all.index_name_map.find(i);
-          if (map_it != all.index_name_map.end())
-          {
-            msg << map_it->second << ":";
-            bin_text_write_fixed(model_file, nullptr /*unused*/, 0 /*unused*/, msg, true);
-          }
-        }
-      }
+    bool non_zero = false;
+    for (size_t j = 0; j < num_values; j++) non_zero = non_zero || values[j] != 0.f;
+    if (!non_zero) continue;
 
-      if (ftrl_size == 3)
-      {
-        if (*v != 0. || (&(*v))[1] != 0. || (&(*v))[2] != 0.)
-        {
-          brw = write_index(model_file, msg, text, all.num_bits, i);
-          msg << ":" << *v << " " << (&(*v))[1] << " " << (&(*v))[2] << "\n";
-          brw += bin_text_write_fixed(model_file, (char*)&(*v), 3 * sizeof(*v), msg, text);
-        }
-      }
-      else if (ftrl_size == 4)
-      {
-        if (*v != 0. || (&(*v))[1] != 0. || (&(*v))[2] != 0. || (&(*v))[3] != 0.)
-        {
-          brw = write_index(model_file, msg, text, all.num_bits, i);
-          msg << ":" << *v << " " << (&(*v))[1] << " " << (&(*v))[2] << " " << (&(*v))[3] << "\n";
-          brw += bin_text_write_fixed(model_file, (char*)&(*v), 4 * sizeof(*v), msg, text);
-        }
-      }
-      else if (ftrl_size == 6)
-      {
-        if (*v != 0. || (&(*v))[1] != 0. || (&(*v))[2] != 0. || (&(*v))[3] != 0. || (&(*v))[4] != 0. ||
-            (&(*v))[5] != 0.)
-        {
-          brw = write_index(model_file, msg, text, all.num_bits, i);
-          msg << ":" << *v << " " << (&(*v))[1] << " " << (&(*v))[2] << " " << (&(*v))[3] << " " << (&(*v))[4] << " "
-              << (&(*v))[5] << "\n";
-          brw += bin_text_write_fixed(model_file, (char*)&(*v), 6 * sizeof(*v), msg, text);
-        }
-      }
-      else if (g == nullptr || (!all.weights.adaptive && !all.weights.normalized))
-      {
-        if (*v != 0.)
-        {
-          brw = write_index(model_file, msg, text, all.num_bits, i);
-          msg << ":" << *v << "\n";
-          brw += bin_text_write_fixed(model_file, (char*)&(*v), sizeof(*v), msg, text);
-        }
-      }
-      else if ((all.weights.adaptive && !all.weights.normalized) || (!all.weights.adaptive && all.weights.normalized))
-      {
-        // either adaptive or normalized
-        if (*v != 0. || (&(*v))[1] != 0.)
-        {
-          brw = write_index(model_file, msg, text, all.num_bits, i);
-          msg << ":" << *v << " " << (&(*v))[1] << "\n";
-          brw += bin_text_write_fixed(model_file, (char*)&(*v), 2 * sizeof(*v), msg, text);
-        }
-      }
-      else
-      {
-        // adaptive and normalized
-        if (*v != 0. || (&(*v))[1] != 0. || (&(*v))[2] != 0.)
-        {
-          brw = write_index(model_file, msg, text, all.num_bits, i);
-          msg << ":" << *v << " " << (&(*v))[1] << " " << (&(*v))[2] << "\n";
-          brw += bin_text_write_fixed(model_file, (char*)&(*v), 3 * sizeof(*v), msg, text);
-        }
-      }
-    }
+    write_index(model_file, msg, true, all.num_bits, i);
+    msg << ":" << values[0];
+    for (size_t j = 1; j < num_values; j++) msg << " " << values[j];
+    msg << "\n";
+    bin_text_write_fixed(model_file, (char*)values, num_values * sizeof(*values), msg, true);
+  }
 }
 
 void save_load_online_state(
@@ -1014,7 +1420,11 @@ void save_load_online_state(
     all.sd->total_features = 0;
     all.current_pass = 0;
   }
-  if (all.weights.sparse)
+  if (all.checkpoints.enabled() && !text && !all.print_invert)
+    save_load_checkpoint(all, model_file, read);
+  else if (all.flat_model && !text && !all.print_invert)
+    save_load_flat_weights(all, model_file, read, true);
+  else if (all.weights.sparse)
     save_load_online_state(all, model_file, read, text, g, msg, ftrl_size, all.weights.sparse_weights);
   else
     save_load_online_state(all, model_file, read, text, g, msg, ftrl_size, all.weights.dense_weights);
@@ -1023,7 +1433,10 @@ void save_load_online_state(
 void save_load(gd& g, io_buf& model_file, bool read, bool text)
 {
   vw& all = *g.all;
-  if (read)
+  if (!read) { store_hogwild_counters(g); }
+  // A delta checkpoint goes on top of the weights loaded before, see --delta_checkpoints.
+  const bool delta = read && all.checkpoints.last_id != 0;
+  if (read && !delta)
   {
     initialize_regressor(all);
 
@@ -1070,8 +1483,11 @@ void save_load(gd& g, io_buf& model_file, bool read, bool text)
   if (!all.training)  // If the regressor was saved as --save_resume, then when testing we want to materialize the
                       // weights.
     sync_weights(all);
+  if (read) { load_hogwild_counters(g); }
 }
 
+void end_examples(gd& g) { store_hogwild_counters(g); }
+
 template <bool sparse_l2, bool invariant, bool sqrt_rate, bool feature_mask_off, uint64_t adaptive, uint64_t normalized,
     uint64_t spare, uint64_t next>
 uint64_t set_learn(vw& all, gd& g)
@@ -1173,7 +1589,10 @@ base_learner* setup(options_i& options, vw& all)
       .add(make_option("l2_state", all.sd->contraction)
                .keep(all.save_resume)
                .default_value(1.)
-               .help("use per feature normalized updates"));
+               .help("use per feature normalized updates"))
+      .add(make_option("hogwild", all.hogwild_threads)
+               .default_value(1)
+               .help("Number of learner threads updating the weights at once, without synchronization"));
   options.add_and_parse(new_options);
 
   g->all = &all;
@@ -1192,6 +1611,14 @@ base_learner* setup(options_i& options, vw& all)
     g->total_weight = all.initial_t;
   }
 
+  if (all.hogwild_threads == 0) THROW("hogwild must be at least 1");
+  g->hogwild = all.hogwild_threads > 1;
+  if (g->hogwild)
+  {
+    if (all.reg_mode) THROW("--hogwild cannot be used with --l1 or --l2, which rescale all weights after updates");
+    if (all.all_reduce != nullptr) THROW("--hogwild cannot be used with --span_server or --train_threads");
+  }
+
   bool feature_mask_off = true;
   if (options.was_supplied("feature_mask")) feature_mask_off = false;
 
@@ -1274,6 +1701,9 @@ base_learner* setup(options_i& options, vw& all)
 
   all.weights.stride_shift(static_cast<uint32_t>(ceil_log_2(stride - 1)));
 
+  // After initial_t is settled above.
+  load_hogwild_counters(*g);
+
   gd* bare = g.get();
   learner<gd, example>& ret = init_learner(g, g->learn, bare->predict,
       (static_cast<uint64_t>(1) << all.weights.stride_shift()), all.get_setupfn_name(setup), true);
@@ -1282,6 +1712,7 @@ base_learner* setup(options_i& options, vw& all)
   ret.set_update(bare->update);
   ret.set_save_load(save_load);
   ret.set_end_pass(end_pass);
+  ret.set_end_examples(end_examples);
   return make_base(ret);
 }
 
@@ -62,14 +62,17 @@ void mf_print_offset_features(gdmf& d, example& ec, size_t offset)
           {
             std::cout << '\t' << f1.audit()->first << k << '^' << f1.audit()->second << ':' << ((f1.index() + k) & mask)
                       << "(" << ((f1.index() + offset + k) & mask) << ")" << ':' << f1.value();
-            std::cout << ':' << (&weights[f1.index()])[offset + k];
+            // a sparse weight is copied before the next lookup, which may move it
+            const float w1 = (&weights[f1.index()])[offset + k];
+            std::cout << ':' << w1;
 
             std::cout << ':' << f2.audit()->first << k << '^' << f2.audit()->second << ':'
                       << ((f2.index() + k + d.rank) & mask) << "(" << ((f2.index() + offset + k + d.rank) & mask) << ")"
                       << ':' << f2.value();
-            std::cout << ':' << (&weights[f2.index()])[offset + k + d.rank];
+            const float w2 = (&weights[f2.index()])[offset + k + d.rank];
+            std::cout << ':' << w2;
 
-            std::cout << ':' << (&weights[f1.index()])[offset + k] * (&weights[f2.index()])[offset + k + d.rank];
+            std::cout << ':' << w1 * w2;
           }
       }
     }
@@ -181,7 +184,10 @@ template <class T>
 void sd_offset_update(T& weights, features& fs, uint64_t offset, float update, float regularization)
 {
   for (size_t i = 0; i < fs.size(); i++)
-    (&weights[fs.indicies[i]])[offset] += update * fs.values[i] - regularization * (&weights[fs.indicies[i]])[offset];
+  {
+    weight& w = (&weights[fs.indicies[i]])[offset];
+    w += update * fs.values[i] - regularization * w;
+  }
 }
 
 template <class T>
@@ -13,6 +13,13 @@
 
 namespace GD
 {
+// Prefetches the weight of feature ahead of fs, if there is one, see INTERACTIONS::prefetch_distance.
+template <class WeightsT>
+inline void prefetch_ahead(const WeightsT& weights, const features& fs, size_t ahead, uint64_t offset)
+{
+  if (ahead < fs.size()) { INTERACTIONS::prefetch_weight(weights, fs.indicies[ahead] + offset); }
+}
+
 // iterate through one namespace (or its part), callback function FuncT(some_data_R, feature_value_x, feature_index)
 template <class DataT, void (*FuncT)(DataT&, float feature_value, uint64_t feature_index), class WeightsT>
 void foreach_feature(WeightsT& /*weights*/, const features& fs, DataT& dat, uint64_t offset = 0, float mult = 1.)
@@ -24,6 +31,16 @@ void foreach_feature(WeightsT& /*weights*/, const features& fs, DataT& dat, uint
 template <class DataT, void (*FuncT)(DataT&, const float feature_value, float& weight_reference), class WeightsT>
 inline void foreach_feature(WeightsT& weights, const features& fs, DataT& dat, uint64_t offset = 0, float mult = 1.)
 {
+  const size_t distance = INTERACTIONS::prefetch_distance(weights);
+  if (distance != 0)
+  {
+    for (size_t i = 0; i < fs.size(); ++i)
+    {
+      prefetch_ahead(weights, fs, i + distance, offset);
+      FuncT(dat, mult * fs.values[i], weights[fs.indicies[i] + offset]);
+    }
+    return;
+  }
   for (const auto& f : fs)
   {
     weight& w = weights[(f.index() + offset)];
@@ -36,6 +53,16 @@ template <class DataT, void (*FuncT)(DataT&, float, float), class WeightsT>
 inline void foreach_feature(
     const WeightsT& weights, const features& fs, DataT& dat, uint64_t offset = 0, float mult = 1.)
 {
+  const size_t distance = INTERACTIONS::prefetch_distance(weights);
+  if (distance != 0)
+  {
+    for (size_t i = 0; i < fs.size(); ++i)
+    {
+      prefetch_ahead(weights, fs, i + distance, offset);
+      FuncT(dat, mult * fs.values[i], weights[fs.indicies[i] + offset]);
+    }
+    return;
+  }
   for (const auto& f : fs) { FuncT(dat, mult * f.value(), weights[(f.index() + offset)]); }
 }
 
@@ -91,6 +118,19 @@ inline void foreach_feature(WeightsT& weights, bool ignore_some_linear, std::arr
 }
 
 inline void vec_add(float& p, float fx, float fw) { p += fw * fx; }
+}  // namespace GD
+
+namespace INTERACTIONS
+{
+template <>
+struct simd_func<float, float, GD::vec_add>
+{
+  static constexpr simd_op op = simd_op::dot;
+};
+}  // namespace INTERACTIONS
+
+namespace GD
+{
 
 template <class WeightsT>
 inline float inline_predict(WeightsT& weights, bool ignore_some_linear, std::array<bool, NUM_NAMESPACES>& ignore_linear,
@@ -156,8 +156,9 @@ void print_raw_text_by_ref(VW::io::writer* f, const std::string& s, const v_arra
 
 void set_mm(shared_data* sd, float label)
 {
-  sd->min_label = std::min(sd->min_label, label);
-  if (label != FLT_MAX) sd->max_label = std::max(sd->max_label, label);
+  // Only writes when the range grows, as --hogwild learner threads call this on labels already in range.
+  if (label < sd->min_label) sd->min_label = label;
+  if (label != FLT_MAX && label > sd->max_label) sd->max_label = label;
 }
 
 void noop_mm(shared_data*, float) {}
@@ -339,6 +340,9 @@ vw::vw() : options(nullptr, nullptr)
   passes_complete = 0;
 
   save_per_pass = false;
+  save_in_background = false;
+  background_save_pid = 0;
+  flat_model = false;
 
   stdin_off = false;
   do_reset_source = false;
@@ -3,11 +3,15 @@
 // license as described in the file LICENSE.
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include "array_parameters_dense.h"
 #include "constant.h"
 #include "feature_group.h"
 #include "interactions.h"
+#include "interactions_simd.h"
 #include "example_predict.h"
+#include <type_traits>
 #include <vector>
 #include <string>
 
@@ -43,6 +47,100 @@ inline void call_FuncT(DataT& dat, WeightsT& /*weights*/, const float ft_value,
   FuncT(dat, ft_value, ft_idx);
 }
 
+// How many features ahead the loops over features prefetch the weights, 0 for not at all. Only dense weights prefetch,
+// see --prefetch_distance.
+template <class WeightsT>
+inline size_t prefetch_distance(const WeightsT&)
+{
+  return 0;
+}
+inline size_t prefetch_distance(const dense_parameters& weights) { return weights.prefetch_distance(); }
+
+template <class WeightsT>
+inline void prefetch_weight(const WeightsT&, uint64_t)
+{
+}
+inline void prefetch_weight(const dense_parameters& weights, uint64_t index) { weights.prefetch(index); }
+
+// The FuncT which have a vectorized inner kernel (see interactions_simd.h). A FuncT opts in by specializing simd_func
+// next to its definition with
+//   simd_op::dot if it is FuncT(float& p, float x, float w) { p += w * x; }
+//   simd_op::add if it is FuncT(float& update, float x, float& w) { w += update * x; } for finite x
+enum class simd_op
+{
+  none,
+  dot,
+  add
+};
+
+template <class DataT, class WeightOrIndexT, void (*FuncT)(DataT&, float, WeightOrIndexT)>
+struct simd_func
+{
+  static constexpr simd_op op = simd_op::none;
+};
+
+template <class WeightsT>
+using is_dense_weights = std::is_same<typename std::remove_const<WeightsT>::type, dense_parameters>;
+
+// Runs the inner loop of inner_kernel with the active vectorized kernel. Returns false when there is none for FuncT
+// or the weights, or when the loop is too short to bother, and inner_kernel has to run the loop itself.
+template <simd_op op>
+struct simd_inner_kernel
+{
+  template <class DataT, class WeightsT, class IsDenseT>
+  static bool run(DataT&, WeightsT&, const features::const_audit_iterator&, const features::const_audit_iterator&,
+      uint64_t, feature_value, feature_index, IsDenseT)
+  {
+    return false;
+  }
+};
+
+template <>
+struct simd_inner_kernel<simd_op::dot>
+{
+  template <class WeightsT>
+  static bool run(float&, WeightsT&, const features::const_audit_iterator&, const features::const_audit_iterator&,
+      uint64_t, feature_value, feature_index, std::false_type)
+  {
+    return false;
+  }
+
+  static bool run(float& dat, const dense_parameters& weights, const features::const_audit_iterator& begin,
+      const features::const_audit_iterator& end, uint64_t offset, feature_value ft_value, feature_index halfhash,
+      std::true_type)
+  {
+    const simd_kernels* kernels = active_simd_kernels();
+    const size_t count = end - begin;
+    if (kernels == nullptr || count < simd_min_features) { return false; }
+    dat += kernels->dot(&weights[0], weights.mask(), &begin.index(), &begin.value(), count, halfhash, offset, ft_value,
+        weights.prefetch_distance());
+    return true;
+  }
+};
+
+template <>
+struct simd_inner_kernel<simd_op::add>
+{
+  template <class WeightsT>
+  static bool run(float&, WeightsT&, const features::const_audit_iterator&, const features::const_audit_iterator&,
+      uint64_t, feature_value, feature_index, std::false_type)
+  {
+    return false;
+  }
+
+  static bool run(float& update, dense_parameters& weights, const features::const_audit_iterator& begin,
+      const features::const_audit_iterator& end, uint64_t offset, feature_value ft_value, feature_index halfhash,
+      std::true_type)
+  {
+    const simd_kernels* kernels = active_simd_kernels();
+    const size_t count = end - begin;
+    if (kernels == nullptr || count < simd_min_features) { return false; }
+    kernels->add(weights.first(), weights.mask(), &begin.index(), &begin.value(), count, halfhash, offset, ft_value,
+        update, weights.prefetch_distance());
+    return true;
+  }
+};
+
 // state data used in non-recursive feature generation algorithm
 // contains N feature_gen_data records (where N is length of interaction)
 struct feature_gen_data
@@ -85,6 +183,26 @@ inline void inner_kernel(DataT& dat, features::const_audit_iterator& begin, feat
   }
   else
   {
+    if (simd_inner_kernel<simd_func<DataT, WeightOrIndexT, FuncT>::op>::run(
+            dat, weights, begin, end, offset, ft_value, halfhash, is_dense_weights<WeightsT>{}))
+    { return; }
+    const size_t distance = prefetch_distance(weights);
+    if (distance != 0)
+    {
+      // The hash of a feature is known long before its weight is needed, so its cache line can be asked for early.
+      auto ahead = begin + std::min(static_cast<std::ptrdiff_t>(distance), end - begin);
+      for (; begin != end; ++begin)
+      {
+        if (ahead != end)
+        {
+          prefetch_weight(weights, (ahead.index() ^ halfhash) + offset);
+          ++ahead;
+        }
+        call_FuncT<DataT, FuncT>(
+            dat, weights, INTERACTION_VALUE(ft_value, begin.value()), (begin.index() ^ halfhash) + offset);
+      }
+      return;
+    }
     for (; begin != end; ++begin)
       call_FuncT<DataT, FuncT>(
           dat, weights, INTERACTION_VALUE(ft_value, begin.value()), (begin.index() ^ halfhash) + offset);
@@ -102,7 +220,7 @@ inline void generate_interactions(const std::vector<std::vector<namespace_index>
     size_t& num_features)  // default value removed to eliminate ambiguity in old complers
 {
   num_features = 0;
-  features* features_data = ec.feature_space.data();
+  auto& features_data = ec.feature_space;
 
   // often used values
   const uint64_t offset = ec.ft_offset;
@@ -0,0 +1,355 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#include "interactions_simd.h"
+
+#include <cfloat>
+
+#include "array_parameters_dense.h"
+
+#if !defined(VW_NO_INLINE_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#  define VW_SIMD_KERNELS
+#  include <immintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#endif
+
+// GCC and clang only emit AVX instructions in functions which ask for them. MSVC emits whatever intrinsics are used.
+#if defined(VW_SIMD_KERNELS) && (defined(__GNUC__) || defined(__clang__))
+#  define VW_SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#  define VW_SIMD_TARGET(isa)
+#endif
+
+namespace
+{
+inline uint64_t weight_index(const uint64_t* indices, size_t i, uint64_t halfhash, uint64_t offset, uint64_t mask)
+{
+  return ((indices[i] ^ halfhash) + offset) & mask;
+}
+
+// Prefetches the weights of features begin to end, the ones the loop gets to after distance more features.
+inline void prefetch_range(const float* weights, uint64_t mask, const uint64_t* indices, size_t begin, size_t end,
+    size_t count, uint64_t halfhash, uint64_t offset)
+{
+  if (end > count) { end = count; }
+  for (size_t i = begin; i < end; ++i) { VW_PREFETCH(weights + weight_index(indices, i, halfhash, offset, mask)); }
+}
+
+inline float dot_scalar_range(const float* weights, uint64_t mask, const uint64_t* indices, const float* values,
+    size_t begin, size_t end, uint64_t halfhash, uint64_t offset, float ft_value, float sum)
+{
+  for (size_t i = begin; i < end; ++i)
+  { sum += weights[weight_index(indices, i, halfhash, offset, mask)] * (ft_value * values[i]); }
+  return sum;
+}
+
+// The same checks as GD::update_feature with the feature mask off and no adaptive or normalized state.
+inline void add_scalar_range(float* weights, uint64_t mask, const uint64_t* indices, const float* values, size_t begin,
+    size_t end, uint64_t halfhash, uint64_t offset, float ft_value, float update)
+{
+  for (size_t i = begin; i < end; ++i)
+  {
+    const float x = ft_value * values[i];
+    if (x < FLT_MAX && x > -FLT_MAX) { weights[weight_index(indices, i, halfhash, offset, mask)] += update * x; }
+  }
+}
+
+float dot_scalar(const float* weights, uint64_t mask, const uint64_t* indices, const float* values, size_t count,
+    uint64_t halfhash, uint64_t offset, float ft_value, size_t prefetch_distance)
+{
+  float sum = 0.f;
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (prefetch_distance != 0)
+    {
+      prefetch_range(
+          weights, mask, indices, i + prefetch_distance, i + prefetch_distance + 1, count, halfhash, offset);
+    }
+    sum = dot_scalar_range(weights, mask, indices, values, i, i + 1, halfhash, offset, ft_value, sum);
+  }
+  return sum;
+}
+
+void add_scalar(float* weights, uint64_t mask, const uint64_t* indices, const float* values, size_t count,
+    uint64_t halfhash, uint64_t offset, float ft_value, float update, size_t prefetch_distance)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (prefetch_distance != 0)
+    {
+      prefetch_range(
+          weights, mask, indices, i + prefetch_distance, i + prefetch_distance + 1, count, halfhash, offset);
+    }
+    add_scalar_range(weights, mask, indices, values, i, i + 1, halfhash, offset, ft_value, update);
+  }
+}
+
+#if defined(VW_SIMD_KERNELS)
+VW_SIMD_TARGET("avx2")
+inline __m256i weight_indices_avx2(
+    const uint64_t* indices, size_t i, __m256i halfhash, __m256i offset, __m256i mask)
+{
+  const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+  return _mm256_and_si256(_mm256_add_epi64(_mm256_xor_si256(index, halfhash), offset), mask);
+}
+
+VW_SIMD_TARGET("avx2")
+inline bool all_finite(__m128 x)
+{
+  const __m128 abs_x = _mm_andnot_ps(_mm_set1_ps(-0.f), x);
+  return _mm_movemask_ps(_mm_cmplt_ps(abs_x, _mm_set1_ps(FLT_MAX))) == 0xF;
+}
+
+VW_SIMD_TARGET("avx2")
+float dot_avx2(const float* weights, uint64_t mask, const uint64_t* indices, const float* values, size_t count,
+    uint64_t halfhash, uint64_t offset, float ft_value, size_t prefetch_distance)
+{
+  const __m256i halfhash_v = _mm256_set1_epi64x(static_cast<int64_t>(halfhash));
+  const __m256i offset_v = _mm256_set1_epi64x(static_cast<int64_t>(offset));
+  const __m256i mask_v = _mm256_set1_epi64x(static_cast<int64_t>(mask));
+  const __m128 ft_value_v = _mm_set1_ps(ft_value);
+
+  // AVX2 gathers four floats through 64 bit indices. Two independent sums keep two gathers in flight.
+  __m128 sum0 = _mm_setzero_ps();
+  __m128 sum1 = _mm_setzero_ps();
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    if (prefetch_distance != 0)
+    {
+      prefetch_range(
+          weights, mask, indices, i + prefetch_distance, i + prefetch_distance + 8, count, halfhash, offset);
+    }
+    const __m128 w0 = _mm256_i64gather_ps(weights, weight_indices_avx2(indices, i, halfhash_v, offset_v, mask_v), 4);
+    const __m128 w1 =
+        _mm256_i64gather_ps(weights, weight_indices_avx2(indices, i + 4, halfhash_v, offset_v, mask_v), 4);
+    sum0 = _mm_add_ps(sum0, _mm_mul_ps(w0, _mm_mul_ps(ft_value_v, _mm_loadu_ps(values + i))));
+    sum1 = _mm_add_ps(sum1, _mm_mul_ps(w1, _mm_mul_ps(ft_value_v, _mm_loadu_ps(values + i + 4))));
+  }
+  for (; i + 4 <= count; i += 4)
+  {
+    if (prefetch_distance != 0)
+    {
+      prefetch_range(
+          weights, mask, indices, i + prefetch_distance, i + prefetch_distance + 4, count, halfhash, offset);
+    }
+    const __m128 w = _mm256_i64gather_ps(weights, weight_indices_avx2(indices, i, halfhash_v, offset_v, mask_v), 4);
+    sum0 = _mm_add_ps(sum0, _mm_mul_ps(w, _mm_mul_ps(ft_value_v, _mm_loadu_ps(values + i))));
+  }
+
+  __m128 sum = _mm_add_ps(sum0, sum1);
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return dot_scalar_range(weights, mask, indices, values, i, count, halfhash, offset, ft_value, _mm_cvtss_f32(sum));
+}
+
+// AVX2 has no scatter. The indices and updates are computed four at a time and then added one by one, which also
+// gets repeated indices right.
+VW_SIMD_TARGET("avx2")
+void add_avx2(float* weights, uint64_t mask, const uint64_t* indices, const float* values, size_t count,
+    uint64_t halfhash, uint64_t offset, float ft_value, float update, size_t prefetch_distance)
+{
+  const __m256i halfhash_v = _mm256_set1_epi64x(static_cast<int64_t>(halfhash));
+  const __m256i offset_v = _mm256_set1_epi64x(static_cast<int64_t>(offset));
+  const __m256i mask_v = _mm256_set1_epi64x(static_cast<int64_t>(mask));
+  const __m128 ft_value_v = _mm_set1_ps(ft_value);
+  const __m128 update_v = _mm_set1_ps(update);
+
+  alignas(32) uint64_t lane_indices[4];
+  alignas(16) float lane_updates[4];
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    if (prefetch_distance != 0)
+    {
+      prefetch_range(
+          weights, mask, indices, i + prefetch_distance, i + prefetch_distance + 4, count, halfhash, offset);
+    }
+    const __m128 x = _mm_mul_ps(ft_value_v, _mm_loadu_ps(values + i));
+    if (!all_finite(x))
+    {
+      add_scalar_range(weights, mask, indices, values, i, i + 4, halfhash, offset, ft_value, update);
+      continue;
+    }
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lane_indices),
+        weight_indices_avx2(indices, i, halfhash_v, offset_v, mask_v));
+    _mm_store_ps(lane_updates, _mm_mul_ps(update_v, x));
+    for (size_t lane = 0; lane < 4; ++lane) { weights[lane_indices[lane]] += lane_updates[lane]; }
+  }
+  add_scalar_range(weights, mask, indices, values, i, count, halfhash, offset, ft_value, update);
+}
+
+VW_SIMD_TARGET("avx512f,avx512cd")
+inline __m512i weight_indices_avx512(
+    const uint64_t* indices, size_t i, __m512i halfhash, __m512i offset, __m512i mask)
+{
+  const __m512i index = _mm512_loadu_si512(indices + i);
+  return _mm512_and_si512(_mm512_add_epi64(_mm512_xor_si512(index, halfhash), offset), mask);
+}
+
+// The plain gather leaves its pass-through operand undefined, which GCC warns about.
+VW_SIMD_TARGET("avx512f,avx512cd")
+inline __m256 gather_avx512(const float* weights, __m512i index)
+{
+  return _mm512_mask_i64gather_ps(_mm256_setzero_ps(), 0xFF, index, weights, 4);
+}
+
+VW_SIMD_TARGET("avx512f,avx512cd")
+float dot_avx512(const float* weights, uint64_t mask, const uint64_t* indices, const float* values, size_t count,
+    uint64_t halfhash, uint64_t offset, float ft_value, size_t prefetch_distance)
+{
+  const __m512i halfhash_v = _mm512_set1_epi64(static_cast<int64_t>(halfhash));
+  const __m512i offset_v = _mm512_set1_epi64(static_cast<int64_t>(offset));
+  const __m512i mask_v = _mm512_set1_epi64(static_cast<int64_t>(mask));
+  const __m256 ft_value_v = _mm256_set1_ps(ft_value);
+
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    if (prefetch_distance != 0)
+    {
+      prefetch_range(
+          weights, mask, indices, i + prefetch_distance, i + prefetch_distance + 16, count, halfhash, offset);
+    }
+    const __m256 w0 = gather_avx512(weights, weight_indices_avx512(indices, i, halfhash_v, offset_v, mask_v));
+    const __m256 w1 = gather_avx512(weights, weight_indices_avx512(indices, i + 8, halfhash_v, offset_v, mask_v));
+    sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(w0, _mm256_mul_ps(ft_value_v, _mm256_loadu_ps(values + i))));
+    sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(w1, _mm256_mul_ps(ft_value_v, _mm256_loadu_ps(values + i + 8))));
+  }
+  for (; i + 8 <= count; i += 8)
+  {
+    if (prefetch_distance != 0)
+    {
+      prefetch_range(
+          weights, mask, indices, i + prefetch_distance, i + prefetch_distance + 8, count, halfhash, offset);
+    }
+    const __m256 w = gather_avx512(weights, weight_indices_avx512(indices, i, halfhash_v, offset_v, mask_v));
+    sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(w, _mm256_mul_ps(ft_value_v, _mm256_loadu_ps(values + i))));
+  }
+
+  const __m256 sum8 = _mm256_add_ps(sum0, sum1);
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return dot_scalar_range(weights, mask, indices, values, i, count, halfhash, offset, ft_value, _mm_cvtss_f32(sum));
+}
+
+// Gathers eight weights, adds the updates and scatters them back. Eight features hashing to the same weight would
+// lose all but one of their updates, so such groups are found with AVX512CD and added one by one.
+VW_SIMD_TARGET("avx512f,avx512cd")
+void add_avx512(float* weights, uint64_t mask, const uint64_t* indices, const float* values, size_t count,
+    uint64_t halfhash, uint64_t offset, float ft_value, float update, size_t prefetch_distance)
+{
+  const __m512i halfhash_v = _mm512_set1_epi64(static_cast<int64_t>(halfhash));
+  const __m512i offset_v = _mm512_set1_epi64(static_cast<int64_t>(offset));
+  const __m512i mask_v = _mm512_set1_epi64(static_cast<int64_t>(mask));
+  const __m256 ft_value_v = _mm256_set1_ps(ft_value);
+  const __m256 update_v = _mm256_set1_ps(update);
+  const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  const __m256 flt_max = _mm256_set1_ps(FLT_MAX);
+
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    if (prefetch_distance != 0)
+    {
+      prefetch_range(
+          weights, mask, indices, i + prefetch_distance, i + prefetch_distance + 8, count, halfhash, offset);
+    }
+    const __m512i index = weight_indices_avx512(indices, i, halfhash_v, offset_v, mask_v);
+    const __m256 x = _mm256_mul_ps(ft_value_v, _mm256_loadu_ps(values + i));
+    const __m512i conflicts = _mm512_conflict_epi64(index);
+    const bool finite = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_and_ps(x, abs_mask), flt_max, _CMP_LT_OQ)) == 0xFF;
+    if (!finite || _mm512_test_epi64_mask(conflicts, conflicts) != 0)
+    {
+      add_scalar_range(weights, mask, indices, values, i, i + 8, halfhash, offset, ft_value, update);
+      continue;
+    }
+    const __m256 w = gather_avx512(weights, index);
+    _mm512_i64scatter_ps(weights, index, _mm256_add_ps(w, _mm256_mul_ps(update_v, x)), 4);
+  }
+  add_scalar_range(weights, mask, indices, values, i, count, halfhash, offset, ft_value, update);
+}
+#endif
+
+const INTERACTIONS::simd_kernels scalar_kernels = {dot_scalar, add_scalar};
+#if defined(VW_SIMD_KERNELS)
+const INTERACTIONS::simd_kernels avx2_kernels = {dot_avx2, add_avx2};
+const INTERACTIONS::simd_kernels avx512_kernels = {dot_avx512, add_avx512};
+#endif
+
+// What generate_interactions runs, kernels is nullptr at the scalar level.
+struct active_kernels
+{
+  INTERACTIONS::simd_level level;
+  const INTERACTIONS::simd_kernels* kernels;
+};
+
+active_kernels make_active_kernels(INTERACTIONS::simd_level level)
+{
+  const INTERACTIONS::simd_level supported = INTERACTIONS::detect_simd_level();
+  if (static_cast<int>(level) > static_cast<int>(supported)) { level = supported; }
+  return {level, level == INTERACTIONS::simd_level::scalar ? nullptr : &INTERACTIONS::kernels_for(level)};
+}
+
+active_kernels& active()
+{
+  static active_kernels state = make_active_kernels(INTERACTIONS::detect_simd_level());
+  return state;
+}
+}  // namespace
+
+namespace INTERACTIONS
+{
+simd_level detect_simd_level()
+{
+#if defined(VW_SIMD_KERNELS)
+#  if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) { return simd_level::scalar; }
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx) { return simd_level::scalar; }
+  // The OS has to save the AVX (and AVX-512) registers on context switches.
+  const auto xcr0 = _xgetbv(0);
+  if ((xcr0 & 0x6) != 0x6) { return simd_level::scalar; }
+  __cpuidex(info, 7, 0);
+  const bool avx2 = (info[1] & (1 << 5)) != 0;
+  const bool avx512f = (info[1] & (1 << 16)) != 0;
+  const bool avx512cd = (info[1] & (1 << 28)) != 0;
+  if (avx512f && avx512cd && (xcr0 & 0xe6) == 0xe6) { return simd_level::avx512; }
+  if (avx2) { return simd_level::avx2; }
+#  else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd")) { return simd_level::avx512; }
+  if (__builtin_cpu_supports("avx2")) { return simd_level::avx2; }
+#  endif
+#endif
+  return simd_level::scalar;
+}
+
+const simd_kernels& kernels_for(simd_level level)
+{
+#if defined(VW_SIMD_KERNELS)
+  const simd_level supported = detect_simd_level();
+  if (level == simd_level::avx512 && supported == simd_level::avx512) { return avx512_kernels; }
+  if (level != simd_level::scalar && supported != simd_level::scalar) { return avx2_kernels; }
+#else
+  (void)level;
+#endif
+  return scalar_kernels;
+}
+
+const simd_kernels* active_simd_kernels() { return active().kernels; }
+
+simd_level active_simd_level() { return active().level; }
+
+void set_simd_level(simd_level level) { active() = make_active_kernels(level); }
+}  // namespace INTERACTIONS
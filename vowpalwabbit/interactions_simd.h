@@ -0,0 +1,54 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized inner loops of generate_interactions for dense weights. The inner loop of an interaction runs over the
+// features of its last namespace, feature i having the weight weights[((indices[i] ^ halfhash) + offset) & mask] and
+// the value ft_value * values[i]. The kernels are compiled for AVX2 and AVX-512 and the one to run is picked at
+// runtime with CPUID, so that a single binary runs everywhere. With a prefetch_distance other than 0 the vectorized
+// kernels prefetch the weights that many features ahead.
+namespace INTERACTIONS
+{
+enum class simd_level
+{
+  scalar,
+  avx2,
+  avx512
+};
+
+// Returns the sum of weight * value over the features.
+using simd_dot_kernel = float (*)(const float* weights, uint64_t mask, const uint64_t* indices, const float* values,
+    size_t count, uint64_t halfhash, uint64_t offset, float ft_value, size_t prefetch_distance);
+// Adds update * value to the weight of every feature whose value is finite, the same as the plain sgd update.
+using simd_add_kernel = void (*)(float* weights, uint64_t mask, const uint64_t* indices, const float* values,
+    size_t count, uint64_t halfhash, uint64_t offset, float ft_value, float update, size_t prefetch_distance);
+
+struct simd_kernels
+{
+  simd_dot_kernel dot;
+  simd_add_kernel add;
+};
+
+// Shorter inner loops are left to inner_kernel, the call does not pay off for them.
+constexpr size_t simd_min_features = 8;
+
+// The highest level both this build and the CPU support. Always scalar when built with VW_NO_INLINE_SIMD or for
+// anything but x86-64.
+simd_level detect_simd_level();
+
+// The kernels of level, or of the highest supported level below it. The scalar ones are the plain loops.
+const simd_kernels& kernels_for(simd_level level);
+
+// The kernels generate_interactions runs, nullptr when it runs its own scalar loops. Starts out at
+// detect_simd_level().
+const simd_kernels* active_simd_kernels();
+simd_level active_simd_level();
+
+// Switches generate_interactions to level, or to the highest supported level below it. Not thread safe, meant for
+// benchmarks and tests comparing the levels.
+void set_simd_level(simd_level level);
+}  // namespace INTERACTIONS
@@ -10,7 +10,10 @@
 #  include <winsock2.h>
 #  include <io.h>
 #else
+#  include <sys/mman.h>
+#  include <climits>
 #  include <sys/socket.h>
+#  include <sys/uio.h>
 #  include <unistd.h>
 #endif
 
@@ -18,6 +21,7 @@
 #include <sys/types.h>
 #include <fcntl.h>
 
+#include <cerrno>
 #include <cstdio>
 #include <cassert>
 #include <cstring>
@@ -78,6 +82,22 @@ private:
   std::shared_ptr<details::socket_closer> _closer;
 };
 
+struct batched_socket_writer : public writer
+{
+  batched_socket_writer(int fd, const std::shared_ptr<details::socket_closer>& closer)
+      : _socket_fd{fd}, _closer{closer}
+  {
+  }
+  ~batched_socket_writer() override { flush(); }
+  ssize_t write(const char* buffer, size_t num_bytes) override;
+  void flush() override;
+
+private:
+  int _socket_fd;
+  std::shared_ptr<details::socket_closer> _closer;
+  std::vector<std::string> _pending;
+};
+
 struct file_adapter : public writer, public reader
 {
   // investigate whether not using the old flags affects perf. Old claim:
@@ -88,6 +108,7 @@ struct file_adapter : public writer, public reader
   ssize_t read(char* buffer, size_t num_bytes) override;
   ssize_t write(const char* buffer, size_t num_bytes) override;
   void reset() override;
+  int file_descriptor() const override { return _file_descriptor; }
 
 private:
   int _file_descriptor;
@@ -138,6 +159,25 @@ private:
   gzFile _gz_stdout;
 };
 
+#ifndef _WIN32
+struct mapped_file_adapter : public reader
+{
+  // Takes ownership of both the file descriptor and the mapping.
+  mapped_file_adapter(int file_descriptor, char* data, size_t length);
+  ~mapped_file_adapter();
+  ssize_t read(char* buffer, size_t num_bytes) override;
+  bool map_remaining(char*& data, size_t& len) override;
+  void reset() override;
+  int file_descriptor() const override { return _file_descriptor; }
+
+private:
+  int _file_descriptor;
+  char* _data;
+  size_t _length;
+  size_t _position = 0;
+};
+#endif
+
 struct custom_func_writer : public writer
 {
   custom_func_writer(void* context, write_func_t write_func);
@@ -186,6 +226,28 @@ std::unique_ptr<reader> open_file_reader(const std::string& file_path)
   return std::unique_ptr<reader>(new file_adapter(file_path.c_str(), file_mode::read));
 }
 
+std::unique_ptr<reader> open_mapped_file_reader(const std::string& file_path)
+{
+#ifdef _WIN32
+  return open_file_reader(file_path);
+#else
+  int file_descriptor = open(file_path.c_str(), O_RDONLY | O_LARGEFILE);
+  if (file_descriptor == -1) { THROWERRNO("can't open: " << file_path); }
+
+  struct stat file_stat;
+  // Empty files cannot be mapped and anything else, such as a pipe, cannot be mapped as a whole.
+  if (fstat(file_descriptor, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) || file_stat.st_size <= 0)
+  { return std::unique_ptr<reader>(new file_adapter(file_descriptor, file_mode::read, true)); }
+
+  const auto length = static_cast<size_t>(file_stat.st_size);
+  void* data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+  if (data == MAP_FAILED) { return std::unique_ptr<reader>(new file_adapter(file_descriptor, file_mode::read, true)); }
+  // Pages are read in order, so ask for aggressive read ahead and early reclaim of pages already read.
+  madvise(data, length, MADV_SEQUENTIAL);
+  return std::unique_ptr<reader>(new mapped_file_adapter(file_descriptor, static_cast<char*>(data), length));
+#endif
+}
+
 std::unique_ptr<writer> open_compressed_file_writer(const std::string& file_path)
 {
   return std::unique_ptr<writer>(new gzip_file_adapter(file_path.c_str(), file_mode::write));
@@ -266,6 +328,59 @@ std::unique_ptr<writer> socket::get_writer()
   return std::unique_ptr<writer>(new socket_adapter(_socket_fd, _closer));
 }
 
+std::unique_ptr<writer> socket::get_batched_writer()
+{
+  return std::unique_ptr<writer>(new batched_socket_writer(_socket_fd, _closer));
+}
+
+//
+// batched_socket_writer
+//
+
+ssize_t batched_socket_writer::write(const char* buffer, size_t num_bytes)
+{
+  _pending.emplace_back(buffer, num_bytes);
+  return static_cast<ssize_t>(num_bytes);
+}
+
+void batched_socket_writer::flush()
+{
+#ifdef _WIN32
+  for (const auto& piece : _pending) { send(_socket_fd, piece.data(), (int)(piece.size()), 0); }
+#else
+  std::vector<iovec> pieces(_pending.size());
+  for (size_t i = 0; i < _pending.size(); i++)
+  {
+    pieces[i].iov_base = const_cast<char*>(_pending[i].data());
+    pieces[i].iov_len = _pending[i].size();
+  }
+  size_t first = 0;
+  while (first < pieces.size())
+  {
+    const auto count = static_cast<int>(std::min(pieces.size() - first, static_cast<size_t>(IOV_MAX)));
+    ssize_t written = ::writev(_socket_fd, &pieces[first], count);
+    if (written < 0)
+    {
+      // As with socket_adapter::write the client finds out about errors by missing predictions.
+      if (errno == EINTR) continue;
+      break;
+    }
+    // The socket may take only part of it, down to part of a piece.
+    while (first < pieces.size() && static_cast<size_t>(written) >= pieces[first].iov_len)
+    {
+      written -= static_cast<ssize_t>(pieces[first].iov_len);
+      first++;
+    }
+    if (first < pieces.size())
+    {
+      pieces[first].iov_base = static_cast<char*>(pieces[first].iov_base) + written;
+      pieces[first].iov_len -= static_cast<size_t>(written);
+    }
+  }
+#endif
+  _pending.clear();
+}
+
 //
 // stdio_adapter
 //
@@ -349,6 +464,41 @@ file_adapter::~file_adapter()
   }
 }
 
+#ifndef _WIN32
+//
+// mapped_file_adapter
+//
+
+mapped_file_adapter::mapped_file_adapter(int file_descriptor, char* data, size_t length)
+    : reader(true /*is_resettable*/), _file_descriptor(file_descriptor), _data(data), _length(length)
+{
+}
+
+mapped_file_adapter::~mapped_file_adapter()
+{
+  munmap(_data, _length);
+  ::close(_file_descriptor);
+}
+
+ssize_t mapped_file_adapter::read(char* buffer, size_t num_bytes)
+{
+  const size_t num_read = std::min(num_bytes, _length - _position);
+  memcpy(buffer, _data + _position, num_read);
+  _position += num_read;
+  return static_cast<ssize_t>(num_read);
+}
+
+bool mapped_file_adapter::map_remaining(char*& data, size_t& len)
+{
+  data = _data + _position;
+  len = _length - _position;
+  _position = _length;
+  return true;
+}
+
+void mapped_file_adapter::reset() { _position = 0; }
+#endif
+
 //
 // gzip_file_adapter
 //
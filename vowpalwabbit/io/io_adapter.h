@@ -52,6 +52,19 @@ struct reader
   /// \returns true if this reader can be reset, otherwise false
   bool is_resettable() const { return _is_resettable; }
 
+  /// Readers backed by addressable memory may hand out the unread remainder of their contents instead of copying it
+  /// through read. The reader is then positioned at its end. The memory must not be modified and stays valid until the
+  /// reader is destroyed.
+  /// \param data set to the first unread byte
+  /// \param len set to the number of unread bytes
+  /// \returns false if this reader does not support it, in which case data and len are untouched
+  virtual bool map_remaining(char*& /* data */, size_t& /* len */) { return false; }
+
+  /// Readers of regular files expose the descriptor of the file, e.g. so that parts of a model can be mapped into
+  /// memory on their own. The descriptor stays owned by the reader.
+  /// \returns -1 if this reader does not read a file
+  virtual int file_descriptor() const { return -1; }
+
   reader(reader& other) = delete;
   reader& operator=(reader& other) = delete;
   reader(reader&& other) = delete;
@@ -87,6 +100,8 @@ struct socket
   ~socket() = default;
   std::unique_ptr<reader> get_reader();
   std::unique_ptr<writer> get_writer();
+  /// Keeps what is written until flush, which sends it all with a single writev.
+  std::unique_ptr<writer> get_batched_writer();
 
 private:
   int _socket_fd;
@@ -95,6 +110,9 @@ private:
 
 std::unique_ptr<writer> open_file_writer(const std::string& file_path);
 std::unique_ptr<reader> open_file_reader(const std::string& file_path);
+/// Opens the file as a read only memory mapping with sequential read ahead, which io_buf reads from in place rather
+/// than copying into its own buffer. Falls back to open_file_reader where mapping is not supported or fails.
+std::unique_ptr<reader> open_mapped_file_reader(const std::string& file_path);
 std::unique_ptr<writer> open_compressed_file_writer(const std::string& file_path);
 std::unique_ptr<reader> open_compressed_file_reader(const std::string& file_path);
 std::unique_ptr<reader> open_compressed_stdin();
@@ -15,6 +15,8 @@ size_t io_buf::buf_read(char*& pointer, size_t n)
   }
   else  // out of bytes, so refill.
   {
+    // Mapped memory cannot be shifted, so the remainder moves to the owned buffer.
+    unmap_buffer();
     if (head != _buffer._begin)  // There exists room to shift.
     {
       // Out of buffer so swap to beginning.
@@ -61,6 +63,7 @@ size_t io_buf::readto(char*& pointer, char terminal)
   }
   else
   {
+    unmap_buffer();
     if (_buffer._end == _buffer._end_array)
     {
       _buffer.shift_to_front(head);
@@ -72,6 +75,8 @@ size_t io_buf::readto(char*& pointer, char terminal)
       return readto(pointer, terminal);
     else  // no more bytes to read, return everything we have.
     {
+      // The unread bytes may have moved since the search above, none of them is the terminal.
+      pointer = _buffer._end;
       size_t n = pointer - head;
       head = pointer;
       pointer -= n;
@@ -110,6 +115,7 @@ size_t io_buf::copy_to(void* dst, size_t max_size)
 
 void io_buf::replace_buffer(char* buff, size_t capacity)
 {
+  if (_buffer_is_mapped) { restore_owned_buffer(); }
   if (_buffer._begin != nullptr) { std::free(_buffer._begin); }
 
   _buffer._begin = buff;
@@ -125,6 +131,7 @@ void io_buf::flush()
     auto bytes_written = output_files[0]->write(_buffer._begin, unflushed_bytes_count());
     if (bytes_written != static_cast<ssize_t>(unflushed_bytes_count()))
     { VW::io::logger::errlog_error("error, failed to write example"); }
+    _file_bytes += unflushed_bytes_count();
     head = _buffer._begin;
     output_files[0]->flush();
   }
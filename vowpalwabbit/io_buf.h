@@ -5,12 +5,15 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <vector>
 #include <memory>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <utility>
 
 #include "v_array.h"
 #include "hash.h"
@@ -38,6 +41,9 @@
 ** The interval [head, _buffer._end] may be shifted down to _buffer._begin
 ** if the requested number of bytes to be read is larger than the interval size.
 ** This is done to avoid reallocating arrays as much as possible.
+**
+** When the current input file exposes its contents through VW::io::reader::map_remaining, _buffer is pointed at that
+** memory instead and nothing is copied or shifted until it is exhausted. The owned buffer is set aside in the meantime.
 */
 
 class io_buf
@@ -89,6 +95,52 @@ class io_buf
   internal_buffer _buffer;
   char* head = nullptr;
 
+  // Bytes loaded from the current input file or flushed to the output file so far, see file_position().
+  uint64_t _file_bytes = 0;
+
+  // Set while _buffer points into memory owned by an input file, see fill().
+  bool _buffer_is_mapped = false;
+  internal_buffer _unmapped_buffer;
+
+  void map_buffer(char* data, size_t len)
+  {
+    std::swap(_buffer._begin, _unmapped_buffer._begin);
+    std::swap(_buffer._end, _unmapped_buffer._end);
+    std::swap(_buffer._end_array, _unmapped_buffer._end_array);
+    _buffer._begin = data;
+    _buffer._end = data + len;
+    _buffer._end_array = data + len;
+    head = data;
+    _buffer_is_mapped = true;
+  }
+
+  // Puts the owned buffer back in place. Its contents are stale, callers reset or refill it.
+  void restore_owned_buffer()
+  {
+    _buffer._begin = _unmapped_buffer._begin;
+    _buffer._end = _unmapped_buffer._end;
+    _buffer._end_array = _unmapped_buffer._end_array;
+    _unmapped_buffer._begin = _unmapped_buffer._end = _unmapped_buffer._end_array = nullptr;
+    _buffer_is_mapped = false;
+  }
+
+  // Switches back to the owned buffer, carrying over any bytes not read yet.
+  void unmap_buffer()
+  {
+    if (!_buffer_is_mapped) { return; }
+    const char* unread = head;
+    const size_t num_unread = _buffer._end - head;
+    restore_owned_buffer();
+
+    _buffer._end = _buffer._begin;
+    size_t capacity = _buffer.capacity();
+    while (capacity < num_unread) { capacity *= 2; }
+    if (capacity != _buffer.capacity()) { _buffer.realloc(capacity); }
+    memcpy(_buffer._begin, unread, num_unread);
+    _buffer._end = _buffer._begin + num_unread;
+    head = _buffer._begin;
+  }
+
   std::vector<std::unique_ptr<VW::io::reader>> input_files;
   std::vector<std::unique_ptr<VW::io::writer>> output_files;
 
@@ -99,6 +151,12 @@ public:
     head = _buffer._begin;
   }
 
+  ~io_buf()
+  {
+    // The mapped memory belongs to the input file, only the owned buffer is freed.
+    if (_buffer_is_mapped) { restore_owned_buffer(); }
+  }
+
   io_buf(io_buf& other) = delete;
   io_buf& operator=(io_buf& other) = delete;
   io_buf(io_buf&& other) = delete;
@@ -128,16 +186,19 @@ public:
   {
     assert(output_files.empty());
     input_files.push_back(std::move(file));
+    _file_bytes = 0;
   }
 
   void add_file(std::unique_ptr<VW::io::writer>&& file)
   {
     assert(input_files.empty());
     output_files.push_back(std::move(file));
+    _file_bytes = 0;
   }
 
   void reset_buffer()
   {
+    if (_buffer_is_mapped) { restore_owned_buffer(); }
     _buffer._end = _buffer._begin;
     head = _buffer._begin;
   }
@@ -146,6 +207,7 @@ public:
   {
     f->reset();
     reset_buffer();
+    _file_bytes = 0;
   }
 
   void set(char* p) { head = p; }
@@ -164,6 +226,18 @@ public:
 
   ssize_t fill(VW::io::reader* f)
   {
+    unmap_buffer();
+    // With nothing left to read in the buffer, a file which can be read in place replaces it until it is exhausted.
+    char* data;
+    size_t len;
+    if (head == _buffer._end && f->map_remaining(data, len))
+    {
+      if (len == 0) { return 0; }
+      map_buffer(data, len);
+      _file_bytes += len;
+      return static_cast<ssize_t>(len);
+    }
+
     // if the loaded values have reached the allocated space
     if (_buffer._end_array - _buffer._end == 0)
     {  // reallocate to twice as much space
@@ -177,6 +251,7 @@ public:
     {
       // if some bytes were actually loaded, update the end of loaded values
       _buffer._end += num_read;
+      _file_bytes += num_read;
       return num_read;
     }
 
@@ -188,19 +263,31 @@ public:
   //   - Read mode: The offset of the position that has been read up to so far.
   size_t unflushed_bytes_count() { return head - _buffer._begin; }
 
+  // Bytes loaded from the input files which were not read yet, so that reading them does not wait.
+  size_t unread_bytes_count() const { return _buffer._end - head; }
+
+  // The offset in the file of the next byte read or written. Only meaningful with a single file, as model files are.
+  uint64_t file_position() const
+  {
+    return output_files.empty() ? _file_bytes - unread_bytes_count() : _file_bytes + (head - _buffer._begin);
+  }
+
   void flush();
 
   bool close_file()
   {
     if (!input_files.empty())
     {
+      unmap_buffer();
       input_files.pop_back();
+      _file_bytes = 0;
       return true;
     }
 
     if (!output_files.empty())
     {
       output_files.pop_back();
+      _file_bytes = 0;
       return true;
     }
 
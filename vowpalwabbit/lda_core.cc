@@ -1327,9 +1327,11 @@ VW::LEARNER::base_learner *lda_setup(options_i &options, vw &all)
   if (minibatch2 > all.example_parser->ring_size)
   {
     bool previous_strict_parse = all.example_parser->strict_parse;
+    size_t previous_parse_threads = all.example_parser->num_parse_threads;
     delete all.example_parser;
     all.example_parser = new parser{minibatch2, previous_strict_parse};
     all.example_parser->_shared_data = all.sd;
+    all.example_parser->num_parse_threads = previous_parse_threads;
   }
 
   ld->v.resize_but_with_stl_behavior(all.lda * ld->minibatch);
@@ -7,6 +7,14 @@
 #include "vw.h"
 #include "parse_regressor.h"
 #include "parse_dispatch_loop.h"
+#include "parallel_parse.h"
+#include "shared_data.h"
+
+#include <cfloat>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 #define CASE(type) \
   case type:       \
@@ -272,8 +280,156 @@ void generic_driver(ready_examples_queue& examples, context_type& context)
   drain_examples(context.get_master());
 }
 
+// Lets the --hogwild learner threads work on batches at the same time, while end of pass and save examples, and growing
+// the label range, wait for every other thread to put its batch down, as those work on state all of them read.
+class hogwild_gate
+{
+public:
+  void begin_batch()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cv.wait(lock, [this] { return !_exclusive; });
+    _active++;
+  }
+
+  void end_batch()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _active--;
+    _cv.notify_all();
+  }
+
+  // Must be called between begin_batch and end_batch.
+  template <typename F>
+  void run_exclusively(F f)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _active--;
+    _cv.notify_all();
+    _cv.wait(lock, [this] { return !_exclusive; });
+    _exclusive = true;
+    _cv.wait(lock, [this] { return _active == 0; });
+    lock.unlock();
+
+    std::exception_ptr error;
+    try
+    {
+      f();
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+
+    lock.lock();
+    _exclusive = false;
+    _active++;
+    _cv.notify_all();
+    if (error) { std::rethrow_exception(error); }
+  }
+
+private:
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  size_t _active = 0;
+  bool _exclusive = false;
+};
+
+// Every learner thread reads the label range of shared_data while it learns, so the range only grows while none of
+// them holds a batch. The scorer then finds the label in range and set_minmax writes nothing.
+void widen_label_range(vw& all, hogwild_gate& gate, const example& ec)
+{
+  if (all.set_minmax == noop_mm || ec.test_only || !all.training) { return; }
+  const float label = ec.l.simple.label;
+  if (label < all.sd->min_label || (label != FLT_MAX && label > all.sd->max_label))
+  { gate.run_exclusively([&all, label] { all.set_minmax(all.sd, label); }); }
+}
+
+// One of the --hogwild learner threads. Whole batches are taken off the ready queue, so examples do not go through
+// VW::get_example which serves a single learner. Learning updates the weights without synchronization, while finishing
+// an example updates shared_data and writes output, so that is done by one thread at a time.
+void hogwild_learner(vw& all, hogwild_gate& gate, std::mutex& finish_lock)
+{
+  parser& p = *all.example_parser;
+  while (true)
+  {
+    // Waiting for input does not count as working on a batch, or end of pass and save examples would wait for the
+    // next input too.
+    v_array<example*>* batch = !all.early_terminate ? p.ready_parsed_examples.pop() : nullptr;
+    if (batch == nullptr) { return; }
+    gate.begin_batch();
+
+    try
+    {
+      for (example* ec : *batch)
+      {
+        if (ec->indices.size() <= 1 && (ec->end_pass || is_save_cmd(ec)))
+        {
+          gate.run_exclusively([&all, ec] {
+            if (ec->end_pass)
+              end_pass(*ec, all);
+            else
+              save(*ec, all);
+          });
+        }
+        else
+        {
+          widen_label_range(all, gate, *ec);
+          all.learn(*ec);
+          std::lock_guard<std::mutex> lock(finish_lock);
+          as_singleline(all.l)->finish_example(all, *ec);
+        }
+      }
+    }
+    catch (...)
+    {
+      gate.end_batch();
+      throw;
+    }
+
+    release_ready_batch(p, batch);
+    gate.end_batch();
+  }
+}
+
+// The reductions have been checked by parse_args to support this.
+void hogwild_driver(vw& all)
+{
+  hogwild_gate gate;
+  std::mutex finish_lock;
+  std::vector<std::exception_ptr> errors(all.hogwild_threads);
+  auto run_learner = [&all, &gate, &finish_lock, &errors](size_t index) {
+    try
+    {
+      hogwild_learner(all, gate, finish_lock);
+    }
+    catch (...)
+    {
+      errors[index] = std::current_exception();
+      // Stops the parser and the other learners.
+      set_done(all);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < all.hogwild_threads; i++) { threads.emplace_back(run_learner, i); }
+  run_learner(0);
+  for (auto& thread : threads) { thread.join(); }
+  for (auto& error : errors)
+  {
+    if (error) { std::rethrow_exception(error); }
+  }
+  drain_examples(all);
+}
+
 void generic_driver(vw& all)
 {
+  if (all.hogwild_threads > 1)
+  {
+    hogwild_driver(all);
+    return;
+  }
+
   single_instance_context context(all);
   ready_examples_queue examples(all);
   generic_driver(examples, context);
@@ -296,7 +452,7 @@ void generic_driver_onethread(vw& all)
     custom_examples_queue examples_queue(examples);
     process_examples(examples_queue, handler);
   };
-  parse_dispatch(all, multi_ex_fptr);
+  parse_dispatch_maybe_parallel(all, multi_ex_fptr);
   all.l->end_examples();
 }
 
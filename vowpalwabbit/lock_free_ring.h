@@ -0,0 +1,124 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace VW
+{
+// Bounded multi-producer multi-consumer ring. Every slot carries a sequence number which tells producers and consumers
+// whether it is theirs to fill or drain, so push and pop only contend on a single compare and swap each and never
+// block. try_push fails when the ring is full and try_pop fails when it is empty, including while the slot at the head
+// is still being written or read by another thread; callers are expected to retry or wait.
+template <typename T>
+class lock_free_ring
+{
+public:
+  lock_free_ring() = default;
+  // With a single slot its sequence number could not tell a filled slot from one free for the next lap, so the ring
+  // always has at least two.
+  explicit lock_free_ring(size_t capacity)
+      : _capacity(std::max(capacity, static_cast<size_t>(2))), _slots(new slot[_capacity])
+  {
+    for (size_t i = 0; i < _capacity; i++) { _slots[i].sequence.store(i, std::memory_order_relaxed); }
+  }
+
+  lock_free_ring(const lock_free_ring&) = delete;
+  lock_free_ring& operator=(const lock_free_ring&) = delete;
+
+  bool try_push(T item)
+  {
+    if (_capacity == 0) { return false; }
+    size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+    while (true)
+    {
+      auto& current = _slots[pos % _capacity];
+      const size_t sequence = current.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0)
+      {
+        if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          current.value = std::move(item);
+          current.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0)
+      {
+        // The slot has not been drained since the previous lap.
+        return false;
+      }
+      else
+      {
+        pos = _enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool try_pop(T& item)
+  {
+    if (_capacity == 0) { return false; }
+    size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+    while (true)
+    {
+      auto& current = _slots[pos % _capacity];
+      const size_t sequence = current.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0)
+      {
+        if (_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          item = std::move(current.value);
+          current.sequence.store(pos + _capacity, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0)
+      {
+        // The slot has not been filled yet.
+        return false;
+      }
+      else
+      {
+        pos = _dequeue_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Only exact when no push or pop is in progress.
+  size_t size() const
+  {
+    const size_t dequeued = _dequeue_pos.load(std::memory_order_acquire);
+    const size_t enqueued = _enqueue_pos.load(std::memory_order_acquire);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+  }
+
+  size_t capacity() const { return _capacity; }
+
+private:
+  static constexpr size_t cache_line_size = 64;
+
+  struct slot
+  {
+    std::atomic<size_t> sequence{0};
+    T value{};
+  };
+
+  size_t _capacity = 0;
+  std::unique_ptr<slot[]> _slots;
+
+  // Producers and consumers each get their own cache line so they do not invalidate each other's position.
+  char _pad0[cache_line_size];
+  std::atomic<size_t> _enqueue_pos{0};
+  char _pad1[cache_line_size - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> _dequeue_pos{0};
+  char _pad2[cache_line_size - sizeof(std::atomic<size_t>)];
+};
+}  // namespace VW
@@ -14,6 +14,8 @@
 #include "parse_regressor.h"
 #include "accumulate.h"
 #include "best_constant.h"
+#include "parallel_train.h"
+#include "prediction_server.h"
 #include "vw_exception.h"
 #include <fstream>
 
@@ -99,7 +101,21 @@ int main(int argc, char* argv[])
       return 0;
     }
 
-    if (should_use_onethread)
+    if (all.predict_threads > 0)
+    {
+      if (alls.size() == 1)
+        VW::serve_predictions(all);
+      else
+        THROW("--predict_threads doesn't make sense with multiple learners");
+    }
+    else if (all.train_threads > 1)
+    {
+      if (alls.size() == 1)
+        VW::train_in_threads(all);
+      else
+        THROW("--train_threads doesn't make sense with multiple learners");
+    }
+    else if (should_use_onethread)
     {
       if (alls.size() == 1)
         VW::LEARNER::generic_driver_onethread(all);
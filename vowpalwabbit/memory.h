@@ -5,6 +5,7 @@
 #pragma once
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include "vw_exception.h"
@@ -0,0 +1,214 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#include "model_host.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+#include "example.h"
+#include "global_data.h"
+#include "learner.h"
+#include "object_pool.h"
+#include "parse_example.h"
+#include "parser.h"
+#include "queue.h"
+#include "vw.h"
+#include "vw_exception.h"
+
+void clean_example(vw&, example&, bool rewind);
+
+namespace VW
+{
+namespace
+{
+// Examples a worker may have queued before submit blocks.
+constexpr size_t worker_queue_size = 1024;
+
+struct hosted_model
+{
+  std::string tenant;
+  vw* model;
+  size_t worker;
+};
+
+struct request
+{
+  hosted_model* target = nullptr;
+  std::string line;
+};
+
+struct worker
+{
+  worker() : requests(worker_queue_size) {}
+
+  VW::ptr_queue<request> requests;
+  size_t num_models = 0;
+  std::thread thread;
+};
+
+void pin_to_core(std::thread& thread, size_t index)
+{
+#ifdef __linux__
+  const auto num_cores = std::max(std::thread::hardware_concurrency(), 1U);
+  cpu_set_t cores;
+  CPU_ZERO(&cores);
+  CPU_SET(index % num_cores, &cores);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(cores), &cores);
+#else
+  _UNUSED(thread);
+  _UNUSED(index);
+#endif
+}
+}  // namespace
+
+struct model_host_state
+{
+  model_host_state(size_t num_workers, model_host::result_func result)
+      : on_result(std::move(result)), workers(num_workers)
+  {
+  }
+
+  // Parses, learns and finishes one example, as VW::read_example and the driver would, on the worker of its model.
+  void process(request& r)
+  {
+    vw& model = *r.target->model;
+    example* ec = &VW::get_unused_example(&model);
+    try
+    {
+      substring_to_example(&model, ec, r.line);
+      setup_example(model, ec);
+      model.example_parser->end_parsed_examples++;
+      model.learn(*ec);
+      if (on_result) { on_result(r.target->tenant, model, *ec); }
+    }
+    catch (...)
+    {
+      clean_example(model, *ec, false);
+      throw;
+    }
+    VW::finish_example(model, *ec);
+  }
+
+  void run_worker(worker& w)
+  {
+    while (request* r = w.requests.pop())
+    {
+      try
+      {
+        process(*r);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(done_lock);
+        if (!error) { error = std::current_exception(); }
+      }
+      requests.return_object(r);
+      if (pending.fetch_sub(1) == 1)
+      {
+        std::lock_guard<std::mutex> lock(done_lock);
+        done.notify_all();
+      }
+    }
+  }
+
+  model_host::result_func on_result;
+  std::vector<worker> workers;
+  std::unordered_map<std::string, std::unique_ptr<hosted_model>> models;
+  VW::object_pool<request> requests{worker_queue_size};
+
+  std::atomic<size_t> pending{0};
+  std::mutex done_lock;
+  std::condition_variable done;
+  std::exception_ptr error;
+};
+
+model_host::model_host(size_t num_workers, result_func on_result, bool pin_to_cores)
+{
+  if (num_workers == 0) THROW("A model host needs at least one worker");
+  _state.reset(new model_host_state(num_workers, std::move(on_result)));
+  auto& state = *_state;
+  for (size_t i = 0; i < num_workers; i++)
+  {
+    worker& w = state.workers[i];
+    w.thread = std::thread([&state, &w] { state.run_worker(w); });
+    if (pin_to_cores) { pin_to_core(w.thread, i); }
+  }
+}
+
+model_host::~model_host()
+{
+  for (auto& w : _state->workers) { w.requests.set_done(); }
+  for (auto& w : _state->workers) { w.thread.join(); }
+}
+
+void model_host::add_model(const std::string& tenant, vw& model)
+{
+  auto& state = *_state;
+  if (model.l->is_multiline) THROW("The model of tenant '" << tenant << "' takes multi line examples");
+  if (state.models.count(tenant) > 0) THROW("There is a model for tenant '" << tenant << "' already");
+  auto least_loaded = std::min_element(state.workers.begin(), state.workers.end(),
+      [](const worker& a, const worker& b) { return a.num_models < b.num_models; });
+  least_loaded->num_models++;
+  const auto index = static_cast<size_t>(least_loaded - state.workers.begin());
+  state.models[tenant].reset(new hosted_model{tenant, &model, index});
+}
+
+void model_host::submit(const std::string& tenant, VW::string_view line)
+{
+  auto& state = *_state;
+  auto found = state.models.find(tenant);
+  if (found == state.models.end()) THROW("There is no model for tenant '" << tenant << "'");
+  request* r = state.requests.get_object();
+  r->target = found->second.get();
+  r->line.assign(line.begin(), line.end());
+  state.pending++;
+  state.workers[r->target->worker].requests.push(r);
+}
+
+void model_host::submit(VW::string_view line)
+{
+  const auto tenant = tenant_of(line);
+  submit(std::string(tenant.begin(), tenant.end()), line);
+}
+
+void model_host::wait()
+{
+  auto& state = *_state;
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lock(state.done_lock);
+    state.done.wait(lock, [&state] { return state.pending.load() == 0; });
+    std::swap(error, state.error);
+  }
+  if (error) { std::rethrow_exception(error); }
+}
+
+VW::string_view model_host::tenant_of(VW::string_view line)
+{
+  // The tag is in front of the first namespace, the token starting with a quote.
+  const auto header = line.substr(0, line.find('|'));
+  for (size_t i = 0; i < header.size(); i++)
+  {
+    const bool token_start = i == 0 || header[i - 1] == ' ' || header[i - 1] == '\t';
+    if (header[i] != '\'' || !token_start) continue;
+    size_t end = i + 1;
+    while (end < header.size() && header[end] != ' ' && header[end] != '\t') { end++; }
+    return header.substr(i + 1, end - i - 1);
+  }
+  return VW::string_view();
+}
+}  // namespace VW
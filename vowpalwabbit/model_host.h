@@ -0,0 +1,61 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "vw_string_view.h"
+
+struct vw;
+struct example;
+
+namespace VW
+{
+struct model_host_state;
+
+// Learns and predicts with many independent models, e.g. one per tenant, on a fixed pool of worker threads instead of
+// a parse thread per model. Every model belongs to one worker, which parses, learns and finishes all of its examples,
+// so a model is only ever touched by a single thread and needs no locking. Lines are routed to the model of their
+// tenant, given explicitly or taken from the tag of the example. Models are plain vw instances from VW::initialize or
+// seed_vw_model that never had start_parser called; the host only borrows them, VW::finish them once the host is
+// gone. Reductions taking multi line examples are not supported.
+class model_host
+{
+public:
+  // Called on the worker thread with every example after it was learned or predicted, before it is finished.
+  using result_func = std::function<void(const std::string& tenant, vw& model, example& ec)>;
+
+  // Starts num_workers threads. With pin_to_cores worker i only runs on core i, modulo the number of cores (Linux
+  // only).
+  explicit model_host(size_t num_workers, result_func on_result = nullptr, bool pin_to_cores = false);
+  model_host(const model_host&) = delete;
+  model_host& operator=(const model_host&) = delete;
+  // Waits for the submitted examples and stops the workers.
+  ~model_host();
+
+  // Hands the model of tenant to the least loaded worker. Not thread safe, models must all be added before
+  // submitting.
+  void add_model(const std::string& tenant, vw& model);
+
+  // Queues one example in the text format for the model of tenant, throwing for unknown tenants. Blocks while the
+  // worker of that model has too much queued already. May be called from several threads at once.
+  void submit(const std::string& tenant, VW::string_view line);
+
+  // Queues one example for the model of the tenant named by its tag, e.g. "1 'tenant_a |f x y".
+  void submit(VW::string_view line);
+
+  // Blocks until all examples submitted so far are done, then rethrows the first error a worker ran into.
+  void wait();
+
+  // The tag of a line of the text format, empty if it has none.
+  static VW::string_view tenant_of(VW::string_view line);
+
+private:
+  std::unique_ptr<model_host_state> _state;
+};
+}  // namespace VW
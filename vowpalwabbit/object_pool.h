@@ -4,9 +4,15 @@
 
 #pragma once
 
+#include "lock_free_ring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <set>
 #include <queue>
 #include <stack>
+#include <vector>
 
 // Mutex and CV cannot be used in managed C++, tell the compiler that this is unmanaged even if included in a managed
 // project.
@@ -99,6 +105,9 @@ struct no_lock_object_pool
     return false;
   }
 
+  size_t num_chunks() const { return m_chunk_bounds.size(); }
+  const std::pair<T*, T*>& chunk_bounds(size_t index) const { return m_chunk_bounds[index]; }
+
 private:
   void new_chunk(size_t size)
   {
@@ -153,26 +162,43 @@ struct object_pool
 {
   object_pool() = default;
   object_pool(size_t initial_chunk_size, TInitializer initializer = {}, size_t chunk_size = 8)
-      : inner_pool(initial_chunk_size, initializer, chunk_size)
+      : inner_pool(initial_chunk_size, initializer, chunk_size), m_returned(std::max(initial_chunk_size, chunk_size))
+  {
+    publish_chunk_bounds();
+  }
+
+  ~object_pool()
   {
+    // The inner pool cleans up and checks all objects are accounted for, so hand back the ones still in the ring.
+    T* obj;
+    while (m_returned.try_pop(obj)) { inner_pool.return_object(obj); }
   }
 
+  // Objects typically move from one thread to another, examples being taken by the parser and returned by the
+  // learner, so returned objects go through a lock free ring and are handed out again from there. The mutex is only
+  // taken when the ring is empty or full.
   void return_object(T* obj)
   {
+    assert(is_from_pool(obj));
+    if (m_returned.try_push(obj)) { return; }
     std::unique_lock<std::mutex> lock(m_lock);
     inner_pool.return_object(obj);
   }
 
   T* get_object()
   {
+    T* obj;
+    if (m_returned.try_pop(obj)) { return obj; }
     std::unique_lock<std::mutex> lock(m_lock);
-    return inner_pool.get_object();
+    obj = inner_pool.get_object();
+    publish_chunk_bounds();
+    return obj;
   }
 
   bool empty() const
   {
     std::unique_lock<std::mutex> lock(m_lock);
-    return inner_pool.empty();
+    return inner_pool.empty() && m_returned.size() == 0;
   }
 
   size_t size() const
@@ -181,14 +207,50 @@ struct object_pool
     return inner_pool.size();
   }
 
+  // Called for every finished example, so this reads a snapshot of the chunk bounds instead of taking the lock.
   bool is_from_pool(T* obj) const
   {
-    std::unique_lock<std::mutex> lock(m_lock);
-    return inner_pool.is_from_pool(obj);
+    const size_t num_bounds = m_num_bounds.load(std::memory_order_acquire);
+    const auto* bounds = m_bounds.load(std::memory_order_acquire);
+    for (size_t i = 0; i < num_bounds; i++)
+    {
+      if (obj >= bounds[i].first && obj <= bounds[i].second) { return true; }
+    }
+
+    return false;
   }
 
 private:
+  // Must be called with m_lock held. Chunks are never freed before the pool is, so bounds are only ever appended. When
+  // the table grows, the previous one is kept alive as readers may still be scanning it.
+  void publish_chunk_bounds()
+  {
+    size_t num_bounds = m_num_bounds.load(std::memory_order_relaxed);
+    while (num_bounds < inner_pool.num_chunks())
+    {
+      auto* bounds = m_bounds.load(std::memory_order_relaxed);
+      if (num_bounds == m_bounds_capacity)
+      {
+        const size_t new_capacity = std::max(static_cast<size_t>(4), m_bounds_capacity * 2);
+        std::unique_ptr<std::pair<T*, T*>[]> grown(new std::pair<T*, T*>[new_capacity]);
+        std::copy(bounds, bounds + num_bounds, grown.get());
+        bounds = grown.get();
+        m_bounds_storage.push_back(std::move(grown));
+        m_bounds_capacity = new_capacity;
+        m_bounds.store(bounds, std::memory_order_release);
+      }
+      bounds[num_bounds] = inner_pool.chunk_bounds(num_bounds);
+      m_num_bounds.store(++num_bounds, std::memory_order_release);
+    }
+  }
+
   mutable std::mutex m_lock;
   no_lock_object_pool<T, TInitializer, TCleanup> inner_pool;
+  lock_free_ring<T*> m_returned;
+
+  std::vector<std::unique_ptr<std::pair<T*, T*>[]>> m_bounds_storage;
+  size_t m_bounds_capacity = 0;
+  std::atomic<std::pair<T*, T*>*> m_bounds{nullptr};
+  std::atomic<size_t> m_num_bounds{0};
 };
 }  // namespace VW
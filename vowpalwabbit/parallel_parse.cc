@@ -0,0 +1,440 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#include "parallel_parse.h"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "cache.h"
+#include "parser.h"
+#include "parse_example.h"
+#include "parse_example_json.h"
+#include "vw.h"
+#include "io/logger.h"
+
+namespace
+{
+// Number of chunks each worker may have queued or in progress before the parse thread waits for the oldest one.
+constexpr size_t chunks_per_thread = 2;
+
+enum class chunk_format
+{
+  text,
+  json,
+  json_audit,
+  cache,
+  cache_blocks
+};
+
+struct parse_chunk_item
+{
+  // Location of the null terminated line in parse_chunk::buffer. Unused for cache input.
+  size_t offset = 0;
+  size_t length = 0;
+  // The examples produced by this line or cache record, in order. Empty if the line was skipped.
+  v_array<example*> examples;
+};
+
+// Location of the encoded features of a cache block in parse_chunk::buffer and of its examples in parse_chunk::items.
+struct cache_block_columns
+{
+  size_t offset;
+  size_t length;
+  size_t first_item;
+  size_t num_items;
+};
+
+struct parse_chunk
+{
+  chunk_format format = chunk_format::text;
+  std::vector<char> buffer;
+  std::vector<parse_chunk_item> items;
+  std::vector<VW::cached_payload> payloads;
+  std::vector<cache_block_columns> blocks;
+
+  // Guarded by parse_worker_pool::_mutex
+  bool parsed = false;
+  std::exception_ptr exc;
+
+  void reset(chunk_format new_format)
+  {
+    format = new_format;
+    buffer.clear();
+    items.clear();
+    payloads.clear();
+    blocks.clear();
+    parsed = false;
+    exc = nullptr;
+  }
+};
+
+chunk_format current_format(const vw& all)
+{
+  const auto reader = all.example_parser->reader;
+  if (reader == read_cached_features) { return chunk_format::cache; }
+  if (reader == read_cached_block_features) { return chunk_format::cache_blocks; }
+  if (reader == &read_features_json<true>) { return chunk_format::json_audit; }
+  if (reader == &read_features_json<false>) { return chunk_format::json; }
+  return chunk_format::text;
+}
+
+// Copies up to max_items lines out of the input. Returns false once the input is exhausted.
+bool read_line_chunk(vw& all, parse_chunk& chunk, size_t max_items)
+{
+  while (chunk.items.size() < max_items)
+  {
+    char* line;
+    size_t num_chars;
+    if (read_features(&all, line, num_chars) < 1) { return false; }
+
+    parse_chunk_item item;
+    item.offset = chunk.buffer.size();
+    item.length = num_chars;
+    chunk.buffer.insert(chunk.buffer.end(), line, line + num_chars);
+    // Both parsers expect a terminated line, and the JSON one parses in place.
+    chunk.buffer.push_back('\0');
+    chunk.items.push_back(std::move(item));
+  }
+  return true;
+}
+
+// Cache records are not self delimiting, so the label, tag and namespace headers are read here on the parse thread and
+// only decoding the feature payloads, which is the bulk of the work, is left to the workers.
+bool read_cache_chunk(vw& all, parse_chunk& chunk, size_t max_items)
+{
+  parser& p = *all.example_parser;
+  while (chunk.items.size() < max_items)
+  {
+    parse_chunk_item item;
+    item.examples.push_back(&VW::get_unused_example(&all));
+    const size_t num_payloads = chunk.payloads.size();
+    if (VW::read_example_from_cache_deferred(*p.input, item.examples[0], p.lbl_parser, p.sorted_cache,
+            p._shared_data, chunk.buffer, chunk.payloads) == 0)
+    {
+      chunk.payloads.resize(num_payloads);
+      VW::return_multiple_example(all, item.examples);
+      return false;
+    }
+    chunk.items.push_back(std::move(item));
+  }
+  return true;
+}
+
+// Blocks are decoded from their start, so a chunk always holds whole blocks. As with records only the headers are read
+// on the parse thread and the features, which are stored apart from them, are left to the workers.
+bool read_cache_block_chunk(vw& all, parse_chunk& chunk, size_t max_items)
+{
+  parser& p = *all.example_parser;
+  while (chunk.items.size() < max_items)
+  {
+    if (!p.cache_reader.read_block(*p.input)) { return false; }
+
+    cache_block_columns block;
+    block.offset = chunk.buffer.size();
+    block.length = p.cache_reader.columns_end() - p.cache_reader.columns_begin();
+    block.first_item = chunk.items.size();
+    chunk.buffer.insert(chunk.buffer.end(), p.cache_reader.columns_begin(), p.cache_reader.columns_end());
+
+    while (p.cache_reader.remaining() > 0)
+    {
+      parse_chunk_item item;
+      item.examples.push_back(&VW::get_unused_example(&all));
+      if (p.cache_reader.read_example_header(item.examples[0], p.lbl_parser, p.sorted_cache, p._shared_data) == 0)
+      {
+        VW::return_multiple_example(all, item.examples);
+        block.num_items = chunk.items.size() - block.first_item;
+        chunk.blocks.push_back(block);
+        return false;
+      }
+      chunk.items.push_back(std::move(item));
+    }
+    block.num_items = chunk.items.size() - block.first_item;
+    chunk.blocks.push_back(block);
+  }
+  return true;
+}
+
+bool read_chunk(vw& all, parse_chunk& chunk, size_t max_items)
+{
+  chunk.reset(current_format(all));
+  if (chunk.format == chunk_format::cache) { return read_cache_chunk(all, chunk, max_items); }
+  if (chunk.format == chunk_format::cache_blocks) { return read_cache_block_chunk(all, chunk, max_items); }
+  return read_line_chunk(all, chunk, max_items);
+}
+
+template <bool audit>
+void parse_json_item(vw& all, char* line, size_t length, v_array<example*>& examples)
+{
+  examples.push_back(&VW::get_unused_example(&all));
+  if (!parse_line_json<audit>(&all, line, length, examples))
+  {
+    // read_features_json would move on to the next line, so a skipped line does not produce any examples.
+    VW::return_multiple_example(all, examples);
+    return;
+  }
+  append_empty_newline_example_for_driver(&all, examples);
+}
+
+void parse_items(vw& all, parser& scratch, parse_chunk& chunk)
+{
+  if (chunk.format == chunk_format::cache)
+  {
+    for (const auto& payload : chunk.payloads)
+    {
+      char* begin = chunk.buffer.data() + payload.offset;
+      VW::decode_cached_features(
+          begin, begin + payload.length, payload.ex->feature_space[payload.index], payload.ex->sorted);
+    }
+    return;
+  }
+
+  if (chunk.format == chunk_format::cache_blocks)
+  {
+    VW::cache_column_decoder decoder;
+    for (const auto& block : chunk.blocks)
+    {
+      const char* begin = chunk.buffer.data() + block.offset;
+      decoder.reset(begin, begin + block.length);
+      for (size_t i = block.first_item; i < block.first_item + block.num_items; i++)
+      { decoder.decode_example(*chunk.items[i].examples[0]); }
+    }
+    return;
+  }
+
+  for (auto& item : chunk.items)
+  {
+    char* line = chunk.buffer.data() + item.offset;
+    switch (chunk.format)
+    {
+      case chunk_format::json:
+        parse_json_item<false>(all, line, item.length, item.examples);
+        break;
+      case chunk_format::json_audit:
+        parse_json_item<true>(all, line, item.length, item.examples);
+        break;
+      default:
+        item.examples.push_back(&VW::get_unused_example(&all));
+        substring_to_example(&all, &scratch, item.examples[0], VW::string_view(line, item.length));
+        break;
+    }
+  }
+}
+
+class parse_worker_pool
+{
+public:
+  parse_worker_pool(vw& all, size_t num_threads) : _all(all), _work(num_threads * chunks_per_thread)
+  {
+    for (size_t i = 0; i < num_threads; i++)
+    {
+      // Label parsers and the tokenizer keep scratch state in the parser, so each worker gets its own.
+      _scratch.push_back(VW::make_unique<parser>(0, all.example_parser->strict_parse));
+      _threads.emplace_back(&parse_worker_pool::work, this, _scratch.back().get());
+    }
+  }
+
+  parse_worker_pool(const parse_worker_pool&) = delete;
+  parse_worker_pool& operator=(const parse_worker_pool&) = delete;
+
+  ~parse_worker_pool()
+  {
+    _work.set_done();
+    for (auto& thread : _threads) { thread.join(); }
+  }
+
+  void submit(parse_chunk& chunk) { _work.push(&chunk); }
+
+  void wait(parse_chunk& chunk)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _parsed.wait(lock, [&chunk] { return chunk.parsed; });
+  }
+
+private:
+  void work(parser* scratch)
+  {
+    parse_chunk* chunk;
+    while ((chunk = _work.pop()) != nullptr)
+    {
+      std::exception_ptr exc;
+      try
+      {
+        parse_items(_all, *scratch, *chunk);
+      }
+      catch (...)
+      {
+        exc = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        chunk->exc = exc;
+        chunk->parsed = true;
+      }
+      _parsed.notify_all();
+    }
+  }
+
+  vw& _all;
+  VW::ptr_queue<parse_chunk> _work;
+  std::mutex _mutex;
+  std::condition_variable _parsed;
+  std::vector<std::unique_ptr<parser>> _scratch;
+  std::vector<std::thread> _threads;
+};
+
+void discard_chunk(vw& all, parse_chunk& chunk)
+{
+  for (auto& item : chunk.items) { VW::return_multiple_example(all, item.examples); }
+  chunk.items.clear();
+}
+}  // namespace
+
+namespace VW
+{
+bool can_parse_in_parallel(const vw& all)
+{
+  const auto reader = all.example_parser->reader;
+  const bool supported_reader = reader == read_features_string || reader == read_cached_features ||
+      reader == read_cached_block_features || reader == &read_features_json<true> ||
+      reader == &read_features_json<false>;
+  // The dsjson metrics record the first and last event seen and are not synchronized.
+  return supported_reader && !all.daemon && all.example_parser->metrics == nullptr;
+}
+
+void parallel_parse_dispatch(vw& all, dispatch_fptr dispatch)
+{
+  parser& p = *all.example_parser;
+  const size_t max_in_flight = p.num_parse_threads * chunks_per_thread;
+  // Keep about ring_size examples in flight so memory use stays close to that of a single parse thread.
+  const size_t items_per_chunk = std::max(static_cast<size_t>(1), p.ring_size / max_in_flight);
+
+  std::vector<std::unique_ptr<parse_chunk>> free_chunks;
+  std::deque<std::unique_ptr<parse_chunk>> in_flight;
+  // Declared after the chunks so the workers are joined before the chunks they use are destroyed.
+  parse_worker_pool workers(all, p.num_parse_threads);
+
+  auto recycle = [&free_chunks](std::unique_ptr<parse_chunk>&& chunk) { free_chunks.push_back(std::move(chunk)); };
+  auto discard_in_flight = [&]() {
+    while (!in_flight.empty())
+    {
+      workers.wait(*in_flight.front());
+      discard_chunk(all, *in_flight.front());
+      recycle(std::move(in_flight.front()));
+      in_flight.pop_front();
+    }
+  };
+
+  size_t example_number = 0;  // for variable-size batch learning algorithms
+  bool end_of_input = false;
+
+  try
+  {
+    while (!p.done)
+    {
+      // Keep the workers busy by reading ahead of the chunk currently being dispatched.
+      while (!end_of_input && in_flight.size() < max_in_flight)
+      {
+        std::unique_ptr<parse_chunk> chunk;
+        if (free_chunks.empty()) { chunk = VW::make_unique<parse_chunk>(); }
+        else
+        {
+          chunk = std::move(free_chunks.back());
+          free_chunks.pop_back();
+        }
+
+        end_of_input = !read_chunk(all, *chunk, items_per_chunk);
+        if (chunk->items.empty())
+        {
+          recycle(std::move(chunk));
+          break;
+        }
+        workers.submit(*chunk);
+        in_flight.push_back(std::move(chunk));
+      }
+
+      bool end_of_pass = in_flight.empty();
+      if (!end_of_pass)
+      {
+        auto chunk = std::move(in_flight.front());
+        in_flight.pop_front();
+        workers.wait(*chunk);
+        if (chunk->exc)
+        {
+          discard_chunk(all, *chunk);
+          std::rethrow_exception(chunk->exc);
+        }
+
+        // Examples are set up here rather than in the workers as holdout, cache writing and example counters depend on
+        // the input order.
+        for (auto& item : chunk->items)
+        {
+          if (item.examples.empty()) { continue; }
+          if (end_of_pass || all.do_reset_source || example_number == all.pass_length ||
+              all.max_examples <= example_number)
+          {
+            end_of_pass = true;
+            VW::return_multiple_example(all, item.examples);
+            continue;
+          }
+
+          VW::setup_examples(all, item.examples);
+          example_number += item.examples.size();
+          dispatch(all, item.examples);
+        }
+        chunk->items.clear();
+        recycle(std::move(chunk));
+      }
+
+      if (end_of_pass)
+      {
+        // Anything read ahead belongs to the pass that just ended.
+        discard_in_flight();
+        end_of_input = false;
+
+        v_array<example*> examples;
+        examples.push_back(&VW::get_unused_example(&all));
+
+        reset_source(all, all.num_bits);
+        all.do_reset_source = false;
+        all.passes_complete++;
+
+        // setup an end_pass example
+        p.lbl_parser.default_label(&examples[0]->l);
+        examples[0]->end_pass = true;
+        p.in_pass_counter = 0;
+
+        if (all.passes_complete == all.numpasses && example_number == all.pass_length)
+        {
+          all.passes_complete = 0;
+          all.pass_length = all.pass_length * 2 + 1;
+        }
+        dispatch(all, examples);  // must be called before lock_done or race condition exists.
+        if (all.passes_complete >= all.numpasses && all.max_examples >= example_number) lock_done(p);
+        example_number = 0;
+      }
+    }
+  }
+  catch (VW::vw_exception& e)
+  {
+    VW::io::logger::errlog_error(
+        "vw example #{0}({1}:{2}): {3}", example_number, e.Filename(), e.LineNumber(), e.what());
+
+    // Stash the exception so it can be thrown on the main thread.
+    p.exc_ptr = std::current_exception();
+  }
+  catch (std::exception& e)
+  {
+    VW::io::logger::errlog_error("vw: example #{0}{1}", example_number, e.what());
+
+    // Stash the exception so it can be thrown on the main thread.
+    p.exc_ptr = std::current_exception();
+  }
+
+  discard_in_flight();
+  lock_done(p);
+}
+}  // namespace VW
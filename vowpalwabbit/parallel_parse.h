@@ -0,0 +1,33 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+#include "parse_dispatch_loop.h"
+
+struct vw;
+
+namespace VW
+{
+// Returns true if the input currently configured for all can be split into chunks and parsed by several threads.
+// Text, JSON/DSJSON and cache input are supported. Daemon mode always parses serially as its socket input is
+// interactive.
+bool can_parse_in_parallel(const vw& all);
+
+// Drop in replacement for parse_dispatch. The parse thread reads line aligned chunks (or cache records) from the input
+// and hands them to all.example_parser->num_parse_threads workers which parse and hash them. Parsed chunks are then
+// set up and dispatched by the parse thread in input order, so learning is identical to parsing with a single thread.
+void parallel_parse_dispatch(vw& all, dispatch_fptr dispatch);
+}  // namespace VW
+
+// Dispatches with parallel_parse_dispatch when more than one parse thread was requested and the input supports it.
+inline void parse_dispatch_maybe_parallel(vw& all, dispatch_fptr dispatch)
+{
+  if (all.example_parser->num_parse_threads > 1 && VW::can_parse_in_parallel(all))
+  { VW::parallel_parse_dispatch(all, std::move(dispatch)); }
+  else
+  {
+    parse_dispatch(all, std::move(dispatch));
+  }
+}
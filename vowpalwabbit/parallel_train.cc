@@ -0,0 +1,154 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#include "parallel_train.h"
+
+#include <exception>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "allreduce.h"
+#include "cache.h"
+#include "learner.h"
+#include "options_serializer_boost_po.h"
+#include "parse_args.h"
+#include "parser.h"
+#include "unique_sort.h"
+#include "vw.h"
+
+void clean_example(vw&, example&, bool rewind);
+
+namespace
+{
+// Options left to the first learner. The others would write the same files or output, reread the data, or are
+// replaced when the other learners are set up.
+const std::set<std::string> first_learner_only_options = {"train_threads", "kill_cache", "no_stdin", "quiet",
+    "progress", "audit", "final_regressor", "readable_model", "invert_hash", "save_per_pass", "predictions",
+    "raw_predictions", "output_feature_regularizer_binary", "output_feature_regularizer_text"};
+
+// Reads the whole input into the cache without learning from it, then switches the input over to the cache.
+void write_cache(vw& all)
+{
+  parser& p = *all.example_parser;
+  v_array<example*> examples;
+  bool more = true;
+  while (more)
+  {
+    examples.push_back(&VW::get_unused_example(&all));
+    more = p.reader(&all, examples) > 0;
+    for (example* ex : examples)
+    {
+      if (more)
+      {
+        if (p.sort_features && ex->sorted == false) unique_sort_features(all.parse_mask, ex);
+        p.cache_writer.add_example(*p.output, ex, p.lbl_parser, all.parse_mask);
+      }
+      clean_example(all, *ex, true);
+    }
+    examples.clear();
+  }
+  reset_source(all, all.num_bits);
+}
+
+// The first learner's supplied options, which rebuild the same model around the cache it reads.
+std::string learner_arguments(vw& all)
+{
+  VW::config::options_serializer_boost_po serializer;
+  for (auto const& option : all.options->get_all_options())
+  {
+    if (all.options->was_supplied(option->m_name) && first_learner_only_options.count(option->m_name) == 0)
+    { serializer.add(*option); }
+  }
+  return serializer.str() + " --quiet --no_stdin";
+}
+
+void train_shard(vw& all)
+{
+  VW::start_parser(all);
+  VW::LEARNER::generic_driver(all);
+  VW::end_parser(all);
+  if (all.example_parser->exc_ptr) { std::rethrow_exception(all.example_parser->exc_ptr); }
+  VW::sync_stats(all);
+}
+}  // namespace
+
+void VW::train_in_threads(vw& all)
+{
+  if (all.train_threads <= 1)
+  {
+    VW::start_parser(all);
+    VW::LEARNER::generic_driver(all);
+    VW::end_parser(all);
+    return;
+  }
+
+  if (all.daemon || all.active) { THROW("--train_threads cannot be used in daemon or active mode"); }
+  parser& p = *all.example_parser;
+  if (p.write_cache) { write_cache(all); }
+  if (p.reader != read_cached_block_features)
+  {
+    THROW("--train_threads trains on shards of a cache, use -c or --cache_file. Caches written by older versions must "
+          "be rewritten with -k.");
+  }
+
+  // The learners are set up before any of them starts so that a failure leaves nobody waiting on the others.
+  auto* root = static_cast<AllReduceThreads*>(all.all_reduce);
+  const std::string arguments = learner_arguments(all);
+  std::vector<vw*> learners{&all};
+  try
+  {
+    for (size_t node = 1; node < all.train_threads; node++)
+    {
+      vw* learner = VW::initialize(arguments);
+      learner->all_reduce_type = AllReduceType::Thread;
+      learner->all_reduce = new AllReduceThreads(root, all.train_threads, node, true);
+      learners.push_back(learner);
+    }
+  }
+  catch (...)
+  {
+    for (size_t node = 1; node < learners.size(); node++) { VW::finish(*learners[node]); }
+    throw;
+  }
+  for (size_t node = 0; node < learners.size(); node++)
+  { learners[node]->example_parser->cache_reader.set_shard(node, learners.size()); }
+
+  std::vector<std::exception_ptr> errors(learners.size());
+  std::vector<std::thread> threads;
+  for (size_t node = 1; node < learners.size(); node++)
+  {
+    threads.emplace_back([&learners, &errors, node] {
+      try
+      {
+        train_shard(*learners[node]);
+      }
+      catch (...)
+      {
+        errors[node] = std::current_exception();
+      }
+    });
+  }
+  try
+  {
+    train_shard(all);
+  }
+  catch (...)
+  {
+    errors[0] = std::current_exception();
+  }
+  for (auto& thread : threads) { thread.join(); }
+
+  for (size_t node = 1; node < learners.size(); node++) { VW::finish(*learners[node]); }
+  // Everything has been averaged and summed up, the first learner goes on alone.
+  delete all.all_reduce;
+  all.all_reduce = nullptr;
+  all.train_threads = 1;
+
+  for (auto& error : errors)
+  {
+    if (error) { std::rethrow_exception(error); }
+  }
+}
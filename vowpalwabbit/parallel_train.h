@@ -0,0 +1,19 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+struct vw;
+
+namespace VW
+{
+// Trains all with all.train_threads learners (--train_threads) in a single process. Every learner is a vw instance of
+// its own with its own copy of the weights and trains on a shard of the cache made of every train_threads-th block.
+// The copies are averaged at the end of every pass through the AllReduceThreads set up by parse_args, just as
+// --span_server does across processes, and all learners leave with the averaged model. A cache which does not exist
+// yet is written before training starts. Only all writes the model, predictions and progress.
+//
+// Takes the place of start_parser, generic_driver and end_parser. When all.train_threads is 1 it does just that.
+void train_in_threads(vw& all);
+}  // namespace VW
@@ -9,6 +9,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <algorithm>
+#include <set>
 
 #include "parse_regressor.h"
 #include "parser.h"
@@ -286,7 +287,7 @@ void parse_dictionary_argument(vw& all, const std::string& str)
     // clear up ec
     ec->tag.clear();
     ec->indices.clear();
-    for (size_t i = 0; i < 256; i++) { ec->feature_space[i].clear(); }
+    for (features& fs : ec->feature_space) { fs.clear(); }
   } while ((rc != EOF) && (nread > 0));
   free(buffer);
   VW::dealloc_examples(ec, 1);
@@ -444,8 +445,14 @@ input_options parse_source(vw& all, options_i& options)
                .help("in persistent daemon mode, do not run in the background"))
       .add(make_option("port", parsed_options.port).help("port to listen on; use 0 to pick unused port"))
       .add(make_option("num_children", all.num_children).help("number of children for persistent daemon mode"))
+      .add(make_option("predict_threads", all.predict_threads)
+               .help("in persistent daemon mode, serve predictions from this many threads of a single process sharing "
+                     "the weights, instead of children. Never learns. Linux only"))
       .add(make_option("pid_file", parsed_options.pid_file).help("Write pid file in persistent daemon mode"))
       .add(make_option("port_file", parsed_options.port_file).help("Write port used in persistent daemon mode"))
+      .add(make_option("pipeline", parsed_options.pipeline)
+               .help("in persistent daemon mode, predict all the examples a client sent so far as one batch and send "
+                     "their predictions back with a single writev"))
       .add(make_option("cache", parsed_options.cache).short_name("c").help("Use a cache.  The default is <data>.cache"))
       .add(make_option("cache_file", parsed_options.cache_files).help("The location(s) of cache_file."))
       .add(make_option("json", parsed_options.json).help("Enable JSON parsing."))
@@ -468,7 +475,15 @@ input_options parse_source(vw& all, options_i& options)
                      "A^B^C. Note: this will become the default in a future version, so enabling this option will "
                      "migrate you to the new behavior and silence the warning."))
       .add(make_option("flatbuffer", parsed_options.flatbuffer)
-               .help("data file will be interpreted as a flatbuffer file"));
+               .help("data file will be interpreted as a flatbuffer file"))
+      .add(make_option("arrow", parsed_options.arrow)
+               .help("data file will be interpreted as an Apache Arrow IPC file or stream of record batches"))
+      .add(make_option("arrow_label", parsed_options.arrow_label)
+               .help("Column of the Arrow record batches with the label"))
+      .add(make_option("arrow_tag", parsed_options.arrow_tag).help("Column of the Arrow record batches with the tag"))
+      .add(make_option("arrow_namespace", parsed_options.arrow_namespaces)
+               .help("Columns of the Arrow record batches that make up a namespace, as name:column,column,... Without "
+                     "any, all other columns go to the default namespace"));
 #ifdef BUILD_EXTERNAL_PARSER
   VW::external::parser::set_parse_args(input_options, parsed_options);
 #endif
@@ -492,6 +507,8 @@ input_options parse_source(vw& all, options_i& options)
     // allow each child to process up to 1e5 connections
     all.numpasses = static_cast<size_t>(1e5);
   }
+  if (all.predict_threads > 0 && (!all.daemon || all.active || parsed_options.json || parsed_options.dsjson))
+  { THROW("predict_threads needs daemon mode with text input"); }
 
   // Add an implicit cache file based on the data filename.
   if (parsed_options.cache) { parsed_options.cache_files.push_back(all.data_filename + ".cache"); }
@@ -1070,6 +1087,9 @@ void parse_example_tweaks(options_i& options, vw& all)
       .add(make_option("sort_features", all.example_parser->sort_features)
                .help("turn this on to disregard order in which features have been defined. This will lead to smaller "
                      "cache sizes"))
+      .add(make_option("feature_arena", all.example_parser->feature_arena)
+               .help("Keep the features of each example in one block of memory reused from example to example instead "
+                     "of separate buffers per namespace"))
       .add(make_option("loss_function", loss_function)
                .default_value("squared")
                .help("Specify the loss function to be used, uses squared by default. Currently available ones are "
@@ -1195,6 +1215,22 @@ void parse_output_model(options_i& options, vw& all)
       .add(make_option("preserve_performance_counters", all.preserve_performance_counters)
                .help("reset performance counters when warmstarting"))
       .add(make_option("save_per_pass", all.save_per_pass).help("Save the model after every pass over data"))
+      .add(make_option("save_in_background", all.save_in_background)
+               .help("Save models before the final one from a forked copy of the process, so that learning goes on "
+                     "meanwhile. Only the pages learning writes to are copied. Not on Windows"))
+      .add(make_option("flat_model", all.flat_model)
+               .keep()
+               .help("Save dense weights raw and page aligned in binary models, so that loading them maps the file "
+                     "instead of reading it and processes on a host share the pages. Kept by the models saved"))
+      .add(make_option("delta_checkpoints", all.checkpoints.full_every)
+               .keep()
+               .help("Save every n-th model in full and the others as deltas of the model saved before, holding the "
+                     "blocks of weights changed since and the state of the reductions. Load a chain with -i full "
+                     "-i delta -i delta ..."))
+      .add(make_option("model_io_threads", all.model_io_threads)
+               .default_value(0)
+               .help("Threads saving and loading dense weights in binary models, 0 for one per core. The model is "
+                     "the same for any number of threads"))
       .add(make_option("output_feature_regularizer_binary", all.per_feature_regularizer_output)
                .help("Per feature regularization output file"))
       .add(make_option("output_feature_regularizer_text", all.per_feature_regularizer_text)
@@ -1206,6 +1242,13 @@ void parse_output_model(options_i& options, vw& all)
     *(all.trace_message) << "final_regressor = " << all.final_regressor_name << endl;
 
   if (options.was_supplied("invert_hash")) all.hash_inv = true;
+  // The forked process would save the delta, and the next model saved would not know about it.
+  if (all.checkpoints.enabled() && all.save_in_background)
+    THROW("--delta_checkpoints cannot be used with --save_in_background");
+  // Deltas hold blocks of the dense weights, which a flat model maps from its file as a whole.
+  if (all.checkpoints.enabled() && all.flat_model) THROW("--delta_checkpoints cannot be used with --flat_model");
+  if (all.checkpoints.enabled() && all.weights.sparse)
+    THROW("--delta_checkpoints saves dense weights, it cannot be used with --sparse_weights");
 
   // Question: This doesn't seem necessary
   // if (options.was_supplied("id") && find(arg.args.begin(), arg.args.end(), "--id") == arg.args.end())
@@ -1235,6 +1278,17 @@ void load_input_model(vw& all, io_buf& io_temp)
     all.l->save_load(io_temp, true, false);
     io_temp.close_file();
   }
+
+  // The models after the first are the deltas saved since, see --delta_checkpoints.
+  if (all.checkpoints.enabled())
+  {
+    for (size_t i = 1; i < all.initial_regressors.size(); i++) load_delta_checkpoint(all, all.initial_regressors[i]);
+  }
+  else if (all.initial_regressors.size() > 1 && !all.logger.quiet)
+  {
+    *(all.trace_message) << "warning: ignoring remaining " << (all.initial_regressors.size() - 1)
+                         << " initial regressors" << endl;
+  }
 }
 
 VW::LEARNER::base_learner* setup_base(options_i& options, vw& all)
@@ -1417,16 +1471,22 @@ vw& parse_args(
 
     bool strict_parse = false;
     int ring_size_tmp;
+    int parse_threads_tmp;
     option_group_definition vw_args("VW options");
     vw_args.add(make_option("ring_size", ring_size_tmp).default_value(256).help("size of example ring"))
-        .add(make_option("strict_parse", strict_parse).help("throw on malformed examples"));
+        .add(make_option("strict_parse", strict_parse).help("throw on malformed examples"))
+        .add(make_option("parse_threads", parse_threads_tmp)
+                 .default_value(1)
+                 .help("number of threads used to parse and hash examples. Examples are still learned in input order"));
     all.options->add_and_parse(vw_args);
 
     if (ring_size_tmp <= 0) { THROW("ring_size should be positive"); }
     size_t ring_size = static_cast<size_t>(ring_size_tmp);
+    if (parse_threads_tmp <= 0) { THROW("parse_threads should be positive"); }
 
     all.example_parser = new parser{ring_size, strict_parse};
     all.example_parser->_shared_data = all.sd;
+    all.example_parser->num_parse_threads = static_cast<size_t>(parse_threads_tmp);
 
     option_group_definition update_args("Update options");
     update_args.add(make_option("learning_rate", all.eta).help("Set learning rate").short_name("l"))
@@ -1439,6 +1499,8 @@ vw& parse_args(
                        "given, also used for initial weights."));
     all.options->add_and_parse(update_args);
 
+    std::string huge_pages;
+    std::string numa;
     option_group_definition weight_args("Weight options");
     weight_args
         .add(make_option("initial_regressor", all.initial_regressors).help("Initial regressor(s)").short_name("i"))
@@ -1447,9 +1509,24 @@ vw& parse_args(
         .add(make_option("normal_weights", all.normal_weights).help("make initial weights normal"))
         .add(make_option("truncated_normal_weights", all.tnormal_weights).help("make initial weights truncated normal"))
         .add(make_option("sparse_weights", all.weights.sparse).help("Use a sparse datastructure for weights"))
+        .add(make_option("prefetch_distance", all.prefetch_distance)
+                 .help("Prefetch dense weights this many features ahead while going through the features and their "
+                       "interactions. Helps when the weights are much larger than the cache, e.g. with -b 28 or more. "
+                       "0 to never prefetch"))
+        .add(make_option("huge_pages", huge_pages)
+                 .help("Back dense weights with huge pages: transparent (madvise) or explicit (reserved in "
+                       "/proc/sys/vm/nr_hugepages, falls back to transparent). Linux only"))
+        .add(make_option("numa_policy", numa)
+                 .help("Place dense weights on the NUMA nodes: interleave over all nodes, or first_touch to leave "
+                       "each page on the node of the training thread writing it first. Linux only"))
+        .add(make_option("weight_snapshots", all.weight_allocation.snapshots)
+                 .help("Keep dense weights in a memory file, so that snapshots of them can be taken copy-on-write "
+                       "while learning goes on. Linux only"))
         .add(make_option("input_feature_regularizer", all.per_feature_regularizer_input)
                  .help("Per feature regularization input file"));
     all.options->add_and_parse(weight_args);
+    if (!huge_pages.empty()) all.weight_allocation.pages = VW::parse_page_policy(huge_pages);
+    if (!numa.empty()) all.weight_allocation.numa = VW::parse_numa_policy(numa);
 
     std::string span_server_arg;
     int span_server_port_arg;
@@ -1467,7 +1544,11 @@ vw& parse_args(
         .add(make_option("node", node_arg).default_value(0).help("node number in cluster parallel job"))
         .add(make_option("span_server_port", span_server_port_arg)
                  .default_value(26543)
-                 .help("Port of the server for setting up spanning tree"));
+                 .help("Port of the server for setting up spanning tree"))
+        .add(make_option("train_threads", all.train_threads)
+                 .default_value(1)
+                 .help("Number of threads which train copies of the model on shards of the cache, averaging them after "
+                       "every pass"));
     all.options->add_and_parse(parallelization_args);
 
     // total, unique_id and node must be specified together.
@@ -1484,6 +1565,14 @@ vw& parse_args(
           span_server_arg, span_server_port_arg, unique_id_arg, total_arg, node_arg, all.logger.quiet);
     }
 
+    if (all.train_threads == 0) { THROW("train_threads must be at least 1"); }
+    if (all.train_threads > 1)
+    {
+      if (all.options->was_supplied("span_server")) { THROW("train_threads cannot be used with span_server"); }
+      all.all_reduce_type = AllReduceType::Thread;
+      all.all_reduce = new AllReduceThreads(all.train_threads, 0, all.logger.quiet);
+    }
+
     parse_diagnostics(*all.options.get(), all);
 
     all.initial_t = static_cast<float>(all.sd->t);
@@ -1634,6 +1723,30 @@ void parse_modules(
 
   parse_reductions(options, all);
 
+  if (all.hogwild_threads > 1)
+  {
+    // Everything but these keeps per example state in the reduction, which the learner threads would share.
+    const std::set<std::string> hogwild_reductions = {"gd", "scorer", "binary"};
+    for (const auto& reduction : all.enabled_reductions)
+    {
+      if (hogwild_reductions.count(reduction) == 0)
+      { THROW("--hogwild does not support the " << reduction << " reduction"); }
+    }
+  }
+
+  if (all.checkpoints.enabled())
+  {
+    // Every delta is read by the whole stack again. These reductions add to their state on each read instead of
+    // replacing it, and these base learners save their own weights, which gd never writes as deltas.
+    const std::set<std::string> no_delta_reductions = {"log_multi", "ccb_explore_adf", "marginal", "memory_tree",
+        "bfgs", "OjaNewton", "ftrl", "svrg", "rank", "ksvm", "lda", "cbzo", "stage_poly"};
+    for (const auto& reduction : all.enabled_reductions)
+    {
+      if (no_delta_reductions.count(reduction) != 0)
+      { THROW("--delta_checkpoints does not support the " << reduction << " reduction"); }
+    }
+  }
+
   if (!all.logger.quiet)
   {
     *(all.trace_message) << "Num weight bits = " << all.num_bits << endl;
@@ -1984,6 +2097,8 @@ void finish(vw& all, bool delete_all)
     }
 
     *(all.trace_message) << endl << "total feature number = " << all.sd->total_features;
+    if (!all.weight_allocation.is_default() && !all.weights.sparse)
+    { *(all.trace_message) << endl << "weight pages = " << VW::to_string(all.weights.dense_weights.pages()); }
     if (all.sd->queries > 0) *(all.trace_message) << endl << "total queries = " << all.sd->queries;
     *(all.trace_message) << endl;
   }
@@ -13,6 +13,7 @@ struct input_options
   size_t port;
   std::string pid_file;
   std::string port_file;
+  bool pipeline = false;
 
   bool cache;
   std::vector<std::string> cache_files;
@@ -22,6 +23,10 @@ struct input_options
   bool compressed;
   bool chain_hash_json;
   bool flatbuffer = false;
+  bool arrow = false;
+  std::string arrow_label;
+  std::string arrow_tag;
+  std::vector<std::string> arrow_namespaces;
 #ifdef BUILD_EXTERNAL_PARSER
   // pointer because it is an incomplete type
   std::unique_ptr<VW::external::parser_options> ext_opts;
@@ -314,6 +314,7 @@ public:
             const auto& feats = feats_it->second;
             features& dict_fs = _ae->feature_space[dictionary_namespace];
             if (dict_fs.size() == 0) _ae->indices.push_back(dictionary_namespace);
+            dict_fs.reserve(dict_fs.size() + feats->size());
             dict_fs.values.insert(dict_fs.values.end(), feats->values.begin(), feats->values.end());
             dict_fs.indicies.insert(dict_fs.indicies.end(), feats->indicies.begin(), feats->indicies.end());
             dict_fs.sum_feat_sq += feats->sum_feat_sq;
@@ -473,6 +474,11 @@ public:
 };
 
 void substring_to_example(vw* all, example* ae, VW::string_view example)
+{
+  substring_to_example(all, all->example_parser, ae, example);
+}
+
+void substring_to_example(vw* all, parser* scratch, example* ae, VW::string_view example)
 {
   if (example.empty()) { ae->is_newline = true; }
 
@@ -480,7 +486,7 @@ void substring_to_example(vw* all, example* ae, VW::string_view example)
 
   size_t bar_idx = example.find('|');
 
-  all->example_parser->words.clear();
+  scratch->words.clear();
   if (bar_idx != 0)
   {
     VW::string_view label_space(example);
@@ -493,21 +499,21 @@ void substring_to_example(vw* all, example* ae, VW::string_view example)
     size_t tab_idx = label_space.find('\t');
     if (tab_idx != VW::string_view::npos) { label_space.remove_prefix(tab_idx + 1); }
 
-    tokenize(' ', label_space, all->example_parser->words);
-    if (all->example_parser->words.size() > 0 &&
-        (all->example_parser->words.back().end() == label_space.end() ||
-            all->example_parser->words.back().front() == '\''))  // The last field is a tag, so record and strip it off
+    tokenize(' ', label_space, scratch->words);
+    if (scratch->words.size() > 0 &&
+        (scratch->words.back().end() == label_space.end() ||
+            scratch->words.back().front() == '\''))  // The last field is a tag, so record and strip it off
     {
-      VW::string_view tag = all->example_parser->words.back();
-      all->example_parser->words.pop_back();
+      VW::string_view tag = scratch->words.back();
+      scratch->words.pop_back();
       if (tag.front() == '\'') { tag.remove_prefix(1); }
       ae->tag.insert(ae->tag.end(), tag.begin(), tag.end());
     }
   }
 
-  if (!all->example_parser->words.empty())
-    all->example_parser->lbl_parser.parse_label(all->example_parser, all->example_parser->_shared_data, &ae->l,
-        all->example_parser->words, ae->_reduction_features);
+  if (!scratch->words.empty())
+    all->example_parser->lbl_parser.parse_label(
+        scratch, all->example_parser->_shared_data, &ae->l, scratch->words, ae->_reduction_features);
 
   if (bar_idx != VW::string_view::npos)
   {
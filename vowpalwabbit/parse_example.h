@@ -15,6 +15,8 @@ typedef enum
 } FeatureInputType;
 
 void substring_to_example(vw* all, example* ae, VW::string_view example);
+// scratch provides the tokenizer state used while parsing, so that several threads can parse for the same vw.
+void substring_to_example(vw* all, parser* scratch, example* ae, VW::string_view example);
 
 namespace VW
 {
@@ -9,9 +9,7 @@
 #include <cstring>
 #include <cfloat>
 
-// seems to help with skipping spaces
-//#define RAPIDJSON_SIMD
-//#define RAPIDJSON_SSE42
+// RapidJSON skips whitespace with SSE2 when built with -DRAPIDJSON_SIMD=ON, see ext_libs/ext_libs.cmake.
 
 // Let MSVC know that it should not even try to compile RapidJSON as managed
 // - pragma documentation: https://docs.microsoft.com/en-us/cpp/preprocessor/managed-unmanaged?view=vs-2017
@@ -53,12 +51,140 @@ VW_WARNING_STATE_POP
 #  define _stricmp strcasecmp
 #endif
 
+#if !defined(VW_NO_INLINE_SIMD) && defined(__SSE2__) && !((_MANAGED == 1) || (_M_CEE == 1))
+#  define VW_JSON_SSE2_SCAN
+#  include <emmintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif
+#endif
+
 namespace logger = VW::io::logger;
 
 using namespace rapidjson;
 
 struct vw;
 
+// The keys the parser acts on. Every key of a line is looked up once, by its length first, so feature names that are
+// not keys cost a switch instead of a string compare per known key. Keys of the label object and the "_label_*"
+// prefix are not in here.
+enum class json_key
+{
+  unknown,
+  label,                // "_label"
+  label_property,       // "_label_*"
+  label_index,          // "_labelIndex", any case after "_label"
+  text,                 // "_text"
+  multi,                // "_multi"
+  slots,                // "_slots"
+  tag,                  // "_tag", any case
+  inc,                  // "_inc", any case
+  label_actions,        // "_a"
+  label_probabilities,  // "_p"
+  slot_id,              // "_slot_id"
+  dedup_id,             // "__aid", any case
+  skip_learn,           // "_skipLearn"
+  outcomes,             // "_outcomes"
+  actions,              // "a"
+  probabilities,        // "p"
+  context,              // "c"
+  pdf,                  // "pdf"
+  pdrop,                // "pdrop"
+  event_id,             // "EventId"
+  timestamp             // "Timestamp"
+};
+
+inline json_key lookup_json_key(const char* str, rapidjson::SizeType length)
+{
+  switch (length)
+  {
+    case 1:
+      if (str[0] == 'a') return json_key::actions;
+      if (str[0] == 'p') return json_key::probabilities;
+      if (str[0] == 'c') return json_key::context;
+      break;
+    case 2:
+      if (str[0] == '_' && str[1] == 'a') return json_key::label_actions;
+      if (str[0] == '_' && str[1] == 'p') return json_key::label_probabilities;
+      break;
+    case 3:
+      if (!memcmp(str, "pdf", 3)) return json_key::pdf;
+      break;
+    case 4:
+      if (!_stricmp(str, "_tag")) return json_key::tag;
+      if (!_stricmp(str, "_inc")) return json_key::inc;
+      break;
+    case 5:
+      if (!memcmp(str, "_text", 5)) return json_key::text;
+      if (!memcmp(str, "pdrop", 5)) return json_key::pdrop;
+      if (!_stricmp(str, "__aid")) return json_key::dedup_id;
+      break;
+    case 6:
+      if (!memcmp(str, "_label", 6)) return json_key::label;
+      if (!memcmp(str, "_multi", 6)) return json_key::multi;
+      if (!memcmp(str, "_slots", 6)) return json_key::slots;
+      break;
+    case 7:
+      if (!memcmp(str, "EventId", 7)) return json_key::event_id;
+      break;
+    case 8:
+      if (!memcmp(str, "_slot_id", 8)) return json_key::slot_id;
+      break;
+    case 9:
+      if (!memcmp(str, "Timestamp", 9)) return json_key::timestamp;
+      if (!memcmp(str, "_outcomes", 9)) return json_key::outcomes;
+      break;
+    case 10:
+      if (!memcmp(str, "_skipLearn", 10)) return json_key::skip_learn;
+      break;
+    case 11:
+      if (!memcmp(str, "_label", 6) && !_stricmp(str + 6, "Index")) return json_key::label_index;
+      break;
+  }
+  if (length >= 7 && !memcmp(str, "_label_", 7)) return json_key::label_property;
+  return json_key::unknown;
+}
+
+// Returns the first byte in [head, end) that DefaultState::Ignore has to look at, or where the plain scan has to take
+// over, 16 bytes at a time with SSE2. Never reads at or past end.
+inline char* skip_to_json_special(char* head, const char* end)
+{
+#ifdef VW_JSON_SSE2_SCAN
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i comma = _mm_set1_epi8(',');
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i open_curly = _mm_set1_epi8('{');
+  const __m128i close_curly = _mm_set1_epi8('}');
+  const __m128i open_square = _mm_set1_epi8('[');
+  const __m128i close_square = _mm_set1_epi8(']');
+  while (end - head >= 16)
+  {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(head));
+    const __m128i strings = _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash));
+    const __m128i separators = _mm_or_si128(_mm_cmpeq_epi8(bytes, comma), _mm_cmpeq_epi8(bytes, zero));
+    const __m128i curlies = _mm_or_si128(_mm_cmpeq_epi8(bytes, open_curly), _mm_cmpeq_epi8(bytes, close_curly));
+    const __m128i squares = _mm_or_si128(_mm_cmpeq_epi8(bytes, open_square), _mm_cmpeq_epi8(bytes, close_square));
+    const __m128i special = _mm_or_si128(_mm_or_si128(strings, separators), _mm_or_si128(curlies, squares));
+    const int mask = _mm_movemask_epi8(special);
+    if (mask != 0)
+    {
+#  ifdef _MSC_VER
+      unsigned long first;
+      _BitScanForward(&first, static_cast<unsigned long>(mask));
+      return head + first;
+#  else
+      return head + __builtin_ctz(static_cast<unsigned int>(mask));
+#  endif
+    }
+    head += 16;
+  }
+#else
+  _UNUSED(end);
+#endif
+  return head;
+}
+
 template <bool audit>
 struct BaseState;
 
@@ -239,6 +365,9 @@ public:
   void init(vw* /* all */)
   {
     found = found_cb = found_cb_continuous = false;
+    actions.clear();
+    probs.clear();
+    inc.clear();
 
     cb_label = CB::cb_class{};
     cont_label_element = {0., 0., 0.};
@@ -799,6 +928,7 @@ public:
     bool stop = false;
     while (!stop)
     {
+      head = skip_to_json_special(head, ctx.stream_end);
       switch (*head)
       {
         case '\0':
@@ -810,7 +940,7 @@ public:
           bool stopInner = false;
           while (!stopInner)
           {
-            head++;
+            head = skip_to_json_special(head + 1, ctx.stream_end);
             switch (*head)
             {
               case '\0':
@@ -871,78 +1001,74 @@ public:
     ctx.key = str;
     ctx.key_length = length;
 
-    if (length > 0 && str[0] == '_')
+    if (length == 0 || str[0] != '_') return this;
+
+    switch (lookup_json_key(str, length))
     {
-      // match _label*
-      if (ctx.key_length >= 6 && !strncmp(ctx.key, "_label", 6))
-      {
-        if (ctx.key_length >= 7 && ctx.key[6] == '_')
-        {
-          if (length >= 9 && !strncmp(&ctx.key[7], "ca", 2)) { ctx.label_object_state.found_cb_continuous = true; }
-          return &ctx.label_single_property_state;
-        }
-        else if (ctx.key_length == 6)
-          return &ctx.label_state;
-        else if (ctx.key_length == 11 && !_stricmp(ctx.key, "_labelIndex"))
-          return &ctx.label_index_state;
-        else
-        {
-          ctx.error() << "Unsupported key '" << ctx.key << "' len: " << length;
-          return nullptr;
-        }
-      }
+      case json_key::label_property:
+        if (length >= 9 && !strncmp(&ctx.key[7], "ca", 2)) { ctx.label_object_state.found_cb_continuous = true; }
+        return &ctx.label_single_property_state;
+
+      case json_key::label:
+        return &ctx.label_state;
 
-      if (ctx.key_length == 5 && !strcmp(ctx.key, "_text")) return &ctx.text_state;
+      case json_key::label_index:
+        return &ctx.label_index_state;
+
+      case json_key::text:
+        return &ctx.text_state;
 
       // TODO: _multi in _multi...
-      if (ctx.key_length == 6 && !strcmp(ctx.key, "_multi")) { return &ctx.multi_state; }
+      case json_key::multi:
+        return &ctx.multi_state;
 
-      if (ctx.key_length == 6 && !strcmp(ctx.key, "_slots")) return &ctx.slots_state;
+      case json_key::slots:
+        return &ctx.slots_state;
 
-      if (ctx.key_length == 4 && !_stricmp(ctx.key, "_tag")) return &ctx.tag_state;
+      case json_key::tag:
+        return &ctx.tag_state;
 
-      if (ctx.key_length == 4 && !_stricmp(ctx.key, "_inc"))
-      {
+      case json_key::inc:
         ctx.array_uint_state.output_array = &ctx.label_object_state.inc;
         ctx.array_uint_state.return_state = this;
         return &ctx.array_uint_state;
-      }
 
-      if (ctx.key_length == 2 && ctx.key[1] == 'a')
-      {
+      case json_key::label_actions:
         ctx.array_uint_state.output_array = &ctx.label_object_state.actions;
         ctx.array_uint_state.return_state = this;
         return &ctx.array_uint_state;
-      }
 
-      if (ctx.key_length == 2 && ctx.key[1] == 'p')
-      {
+      case json_key::label_probabilities:
         // Ignore "_p" when it is inside the "c" key in decision service state.
         if (ctx.root_state == &ctx.decision_service_state) { Ignore(ctx, length); }
 
         ctx.array_float_state.output_array = &ctx.label_object_state.probs;
         ctx.array_float_state.return_state = this;
         return &ctx.array_float_state;
-      }
 
-      else if (length == 8 && !strncmp(str, "_slot_id", 8))
-      {
+      case json_key::slot_id:
         if (ctx.all->example_parser->lbl_parser.label_type != label_type_t::slates)
-        { THROW("Can only use _slot_id with slates examples"); } ctx.uint_state.output_uint = &ctx.ex->l.slates.slot_id;
+        { THROW("Can only use _slot_id with slates examples"); }
+        ctx.uint_state.output_uint = &ctx.ex->l.slates.slot_id;
         ctx.array_float_state.return_state = this;
         return &ctx.array_float_state;
-      }
 
-      else if (ctx.key_length == 5 && !_stricmp(ctx.key, "__aid"))
-      {
+      case json_key::dedup_id:
         ctx.uint_dedup_state.return_state = this;
         return &ctx.uint_dedup_state;
-      }
 
-      return Ignore(ctx, length);
+      default:
+        break;
     }
 
-    return this;
+    // match _label*
+    if (length >= 6 && !strncmp(str, "_label", 6))
+    {
+      ctx.error() << "Unsupported key '" << ctx.key << "' len: " << length;
+      return nullptr;
+    }
+
+    return Ignore(ctx, length);
   }
 
   BaseState<audit>* String(Context<audit>& ctx, const char* str, rapidjson::SizeType length, bool) override
@@ -1350,83 +1476,71 @@ public:
 
   BaseState<audit>* Key(Context<audit>& ctx, const char* str, rapidjson::SizeType length, bool /* copy */) override
   {
-    if (length == 1)
-    {
-      switch (str[0])
-      {
-        case 'a':
-          ctx.array_uint_state.output_array = &data->actions;
-          ctx.array_uint_state.return_state = this;
-          return &ctx.array_uint_state;
-        case 'p':
-          data->probabilities.clear();
-          ctx.array_float_state.output_array = &data->probabilities;
-          ctx.array_float_state.return_state = this;
-          return &ctx.array_float_state;
-        case 'c':
-          ctx.key = " ";
-          ctx.key_length = 1;
-          return &ctx.default_state;
-      }
-    }
-    else if (length == 3 && !strcmp(str, "pdf"))
-    {
-      ctx.array_pdf_state.return_state = this;
-      return &ctx.array_pdf_state;
-    }
-    else if (length == 5 && !strcmp(str, "pdrop"))
+    switch (lookup_json_key(str, length))
     {
-      ctx.float_state.output_float = &data->probabilityOfDrop;
-      ctx.float_state.return_state = this;
-      return &ctx.float_state;
-    }
-    else if (length == 7 && !strcmp(str, "EventId"))
-    {
-      ctx.string_state.output_string = &data->eventId;
-      ctx.string_state.return_state = this;
-      return &ctx.string_state;
-    }
-    else if (length == 9 && !strcmp(str, "Timestamp"))
-    {
-      ctx.string_state.output_string = &data->timestamp;
-      ctx.string_state.return_state = this;
-      return &ctx.string_state;
-    }
-    else if (length > 0 && str[0] == '_')
-    {
-      // match _label*
-      if (length >= 6 && !strncmp(str, "_label", 6))
-      {
+      case json_key::actions:
+        ctx.array_uint_state.output_array = &data->actions;
+        ctx.array_uint_state.return_state = this;
+        return &ctx.array_uint_state;
+
+      case json_key::probabilities:
+      case json_key::label_probabilities:
+        data->probabilities.clear();
+        ctx.array_float_state.output_array = &data->probabilities;
+        ctx.array_float_state.return_state = this;
+        return &ctx.array_float_state;
+
+      case json_key::context:
+        ctx.key = " ";
+        ctx.key_length = 1;
+        return &ctx.default_state;
+
+      case json_key::pdf:
+        ctx.array_pdf_state.return_state = this;
+        return &ctx.array_pdf_state;
+
+      case json_key::pdrop:
+        ctx.float_state.output_float = &data->probabilityOfDrop;
+        ctx.float_state.return_state = this;
+        return &ctx.float_state;
+
+      case json_key::event_id:
+        ctx.string_state.output_string = &data->eventId;
+        ctx.string_state.return_state = this;
+        return &ctx.string_state;
+
+      case json_key::timestamp:
+        ctx.string_state.output_string = &data->timestamp;
+        ctx.string_state.return_state = this;
+        return &ctx.string_state;
+
+      case json_key::label_property:
         ctx.key = str;
         ctx.key_length = length;
-        if (length >= 7 && ctx.key[6] == '_')
-        {
-          if (length >= 9 && !strncmp(&ctx.key[7], "ca", 2)) { ctx.label_object_state.found_cb_continuous = true; }
-          return &ctx.label_single_property_state;
-        }
-        else if (length == 6)
-          return &ctx.label_state;
-        else if (length == 11 && !_stricmp(str, "_labelIndex"))
-          return &ctx.label_index_state;
-      }
-      else if (length == 10 && !strncmp(str, "_skipLearn", 10))
-      {
+        if (length >= 9 && !strncmp(&ctx.key[7], "ca", 2)) { ctx.label_object_state.found_cb_continuous = true; }
+        return &ctx.label_single_property_state;
+
+      case json_key::label:
+        ctx.key = str;
+        ctx.key_length = length;
+        return &ctx.label_state;
+
+      case json_key::label_index:
+        ctx.key = str;
+        ctx.key_length = length;
+        return &ctx.label_index_state;
+
+      case json_key::skip_learn:
         ctx.bool_state.output_bool = &data->skipLearn;
         ctx.bool_state.return_state = this;
         return &ctx.bool_state;
-      }
-      else if (length == 9 && !strncmp(str, "_outcomes", 9))
-      {
+
+      case json_key::outcomes:
         ctx.slot_outcome_list_state.interactions = data;
         return &ctx.slot_outcome_list_state;
-      }
-      else if (length == 2 && !strncmp(str, "_p", 2))
-      {
-        data->probabilities.clear();
-        ctx.array_float_state.output_array = &data->probabilities;
-        ctx.array_float_state.return_state = this;
-        return &ctx.array_float_state;
-      }
+
+      default:
+        break;
     }
 
     // ignore unknown properties
@@ -1497,13 +1611,26 @@ public:
     root_state = &default_state;
   }
 
+  // Also resets whatever the previous line left behind, the same context parses every line of a thread.
   void init(vw* pall)
   {
     all = pall;
     key = " ";
     key_length = 1;
+    current_state = &default_state;
+    root_state = &default_state;
     previous_state = nullptr;
+    namespace_path.clear();
+    return_path.clear();
     label_object_state.init(pall);
+    label_index_state.index = -1;
+    array_float_state.has_seen_array_start = false;
+    array_uint_state.has_seen_array_start = false;
+    if (error_ptr)
+    {
+      error_ptr->str("");
+      error_ptr->clear();
+    }
   }
 
   std::stringstream& error()
@@ -1524,7 +1651,7 @@ public:
     Namespace<audit> n;
     n.feature_group = ns[0];
     n.namespace_hash = VW::hash_space_cstr(*all, ns);
-    n.ftrs = ex->feature_space.data() + ns[0];
+    n.ftrs = &ex->feature_space[ns[0]];
     n.feature_count = 0;
 
     n.name = ns;
@@ -1621,8 +1748,25 @@ struct json_parser
 {
   rapidjson::Reader reader;
   VWReaderHandler<audit> handler;
+  // Holds the line when the caller asks for it to be left intact.
+  std::vector<char> line_copy;
 };
 
+// The parser of the calling thread. Its states, stacks and buffers are reused from line to line instead of being built
+// for every line. Managed code has no thread_local and gets a parser per call instead.
+template <bool audit>
+json_parser<audit>& get_json_parser(std::unique_ptr<json_parser<audit>>& owned)
+{
+#if (_MANAGED == 1) || (_M_CEE == 1)
+  owned.reset(new json_parser<audit>());
+  return *owned;
+#else
+  _UNUSED(owned);
+  static thread_local json_parser<audit> parser;
+  return parser;
+#endif
+}
+
 namespace VW
 {
 template <bool audit>
@@ -1639,7 +1783,8 @@ void read_line_json_s(vw& all, v_array<example*>& examples, char* line, size_t l
   // string line_copy(line);
   // destructive parsing
   InsituStringStream ss(line);
-  json_parser<audit> parser;
+  std::unique_ptr<json_parser<audit>> owned_parser;
+  json_parser<audit>& parser = get_json_parser(owned_parser);
 
   VWReaderHandler<audit>& handler = parser.handler;
   handler.init(&all, &examples, &ss, line + length, example_factory, ex_factory_context, dedup_examples);
@@ -1701,15 +1846,15 @@ bool read_line_decision_service_json(vw& all, v_array<example*>& examples, char*
     return apply_pdrop(all, data->probabilityOfDrop, examples);
   }
 
-  std::vector<char> line_vec;
+  std::unique_ptr<json_parser<audit>> owned_parser;
+  json_parser<audit>& parser = get_json_parser(owned_parser);
   if (copy_line)
   {
-    line_vec.insert(line_vec.end(), line, line + length);
-    line = &line_vec.front();
+    parser.line_copy.assign(line, line + length);
+    line = parser.line_copy.data();
   }
 
   InsituStringStream ss(line);
-  json_parser<audit> parser;
 
   VWReaderHandler<audit>& handler = parser.handler;
   handler.init(&all, &examples, &ss, line + length, example_factory, ex_factory_context);
@@ -1818,10 +1963,9 @@ inline void append_empty_newline_example_for_driver(vw* all, v_array<example*>&
   // insert new line example at the end
   if (examples.size() > 1)
   {
+    // this is equivalent to parsing an empty line, without touching the shared tokenizer state of the parser.
     example& ae = VW::get_unused_example(all);
-    static const char empty[] = "";
-    VW::string_view example(empty);
-    substring_to_example(all, &ae, example);
+    all->example_parser->lbl_parser.default_label(&ae.l);
     ae.is_newline = true;
 
     examples.push_back(&ae);
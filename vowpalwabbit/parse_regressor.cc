@@ -7,6 +7,7 @@
 #include "crossplat_compat.h"
 
 #ifndef _WIN32
+#  include <sys/wait.h>
 #  include <unistd.h>
 #endif
 
@@ -28,6 +29,9 @@
 #include "vw_versions.h"
 #include "options_serializer_boost_po.h"
 #include "shared_data.h"
+#include "io/logger.h"
+
+namespace logger = VW::io::logger;
 
 void initialize_weights_as_random_positive(weight* weights, uint64_t index) { weights[0] = 0.1f * merand48(index); }
 void initialize_weights_as_random(weight* weights, uint64_t index) { weights[0] = merand48(index) - 0.5f; }
@@ -57,6 +61,18 @@ double calculate_sd(vw& /* all */, T& weights)
   double sq_sum = inner_product(diff.begin(), diff.end(), diff.begin(), 0.0);
   return std::sqrt(sq_sum / my_size);
 }
+void reallocate(vw& all, dense_parameters& weights, size_t length, uint32_t stride_shift)
+{
+  weights.~dense_parameters();
+  new (&weights) dense_parameters(length, stride_shift, all.weight_allocation);
+}
+
+void reallocate(vw& /* all */, sparse_parameters& weights, size_t length, uint32_t stride_shift)
+{
+  weights.~sparse_parameters();
+  new (&weights) sparse_parameters(length, stride_shift);
+}
+
 template <class T>
 void initialize_regressor(vw& all, T& weights)
 {
@@ -67,8 +83,7 @@ void initialize_regressor(vw& all, T& weights)
   try
   {
     uint32_t ss = weights.stride_shift();
-    weights.~T();  // dealloc so that we can realloc, now with a known size
-    new (&weights) T(length, ss);
+    reallocate(all, weights, length, ss);  // dealloc so that we can realloc, now with a known size
   }
   catch (const VW::vw_exception&)
   {
@@ -105,9 +120,16 @@ void initialize_regressor(vw& all, T& weights)
 void initialize_regressor(vw& all)
 {
   if (all.weights.sparse)
+  {
     initialize_regressor(all, all.weights.sparse_weights);
+    // The --hogwild learner threads add weights at the same time.
+    if (all.hogwild_threads > 1) all.weights.sparse_weights.make_concurrent();
+  }
   else
+  {
     initialize_regressor(all, all.weights.dense_weights);
+    all.weights.dense_weights.prefetch_distance(all.prefetch_distance);
+  }
 }
 
 constexpr size_t default_buf_size = 512;
@@ -482,16 +504,78 @@ void dump_regressor(vw& all, std::string reg_name, bool as_text)
         << start_name.c_str() << " to " << reg_name.c_str());
 }
 
+namespace
+{
+// Waits for the model saved by save_in_background, if any.
+void wait_for_background_save(vw& all)
+{
+#ifndef _WIN32
+  if (all.background_save_pid == 0) return;
+  int status = 0;
+  while (waitpid(all.background_save_pid, &status, 0) < 0 && errno == EINTR) {}
+  all.background_save_pid = 0;
+  all.background_save_snapshot.reset();
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) logger::errlog_warn("Saving the model in the background failed");
+#else
+  _UNUSED(all);
+#endif
+}
+
+// Saves the model from a forked copy of the process. The child sees the model frozen at the fork while the kernel
+// copies the pages the parent goes on writing, so learning only stops for the fork itself.
+void save_in_background(vw& all, const std::string& reg_name)
+{
+#ifndef _WIN32
+  wait_for_background_save(all);
+  // Weights in the memory file of --weight_snapshots are mapped shared, so the child would see the parent's writes.
+  // A snapshot maps them copy-on-write from the file instead, and holding on to it keeps later snapshots from
+  // writing to that file while the child reads it.
+  if (!all.weights.sparse && all.weights.dense_weights.snapshots_enabled())
+  { all.background_save_snapshot = all.weights.dense_weights.snapshot(); }
+  std::cout.flush();
+  std::cerr.flush();
+  const pid_t pid = fork();
+  if (pid < 0)
+  {
+    all.background_save_snapshot.reset();
+    THROWERRNO("fork to save the model in the background failed");
+  }
+  if (pid == 0)
+  {
+    int status = 0;
+    try
+    {
+      dump_regressor(all, reg_name, false);
+    }
+    catch (const std::exception& e)
+    {
+      logger::errlog_error("Saving the model in the background failed: {}", e.what());
+      status = 1;
+    }
+    // Skips the atexit handlers and destructors of the parent's state.
+    _exit(status);
+  }
+  all.background_save_pid = pid;
+#else
+  dump_regressor(all, reg_name, false);
+#endif
+}
+}  // namespace
+
 void save_predictor(vw& all, std::string reg_name, size_t current_pass)
 {
   std::stringstream filename;
   filename << reg_name;
   if (all.save_per_pass) filename << "." << current_pass;
-  dump_regressor(all, filename.str(), false);
+  if (all.save_in_background)
+    save_in_background(all, filename.str());
+  else
+    dump_regressor(all, filename.str(), false);
 }
 
 void finalize_regressor(vw& all, std::string reg_name)
 {
+  wait_for_background_save(all);
   if (!all.early_terminate)
   {
     if (all.per_feature_regularizer_output.length() > 0)
@@ -515,16 +599,8 @@ void read_regressor_file(vw& all, std::vector<std::string> all_intial, io_buf& i
   if (all_intial.size() > 0)
   {
     io_temp.add_file(VW::io::open_file_reader(all_intial[0]));
-
-    if (!all.logger.quiet)
-    {
-      // *(all.trace_message) << "initial_regressor = " << regs[0] << std::endl;
-      if (all_intial.size() > 1)
-      {
-        *(all.trace_message) << "warning: ignoring remaining " << (all_intial.size() - 1) << " initial regressors"
-                             << std::endl;
-      }
-    }
+    // The remaining ones are only known to be delta checkpoints once the header of the first is read, see
+    // load_input_model.
   }
 }
 
@@ -570,6 +646,16 @@ void parse_mask_regressor_args(vw& all, std::string feature_mask, std::vector<st
   }
 }
 
+void load_delta_checkpoint(vw& all, const std::string& file_name)
+{
+  std::string unused;
+  io_buf io_temp;
+  io_temp.add_file(VW::io::open_file_reader(file_name));
+  save_load_header(all, io_temp, true, false, unused, *all.options);
+  all.l->save_load(io_temp, true, false);
+  io_temp.close_file();
+}
+
 namespace VW
 {
 void save_predictor(vw& all, std::string reg_name) { dump_regressor(all, reg_name, false); }
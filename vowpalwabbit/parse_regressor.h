@@ -16,3 +16,6 @@ void save_load_header(
     vw& all, io_buf& model_file, bool read, bool text, std::string& file_options, VW::config::options_i& options);
 
 void parse_mask_regressor_args(vw& all, std::string feature_mask, std::vector<std::string> initial_regressors);
+
+// Loads a model saved with --delta_checkpoints on top of the weights and the reductions loaded before.
+void load_delta_checkpoint(vw& all, const std::string& file_name);
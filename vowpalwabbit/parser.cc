@@ -57,11 +57,15 @@ int VW_getpid() { return (int)::GetCurrentProcessId(); }
 #include "vw_exception.h"
 #include "parse_example_json.h"
 #include "parse_dispatch_loop.h"
+#include "parallel_parse.h"
 #include "parse_args.h"
 #include "io/io_adapter.h"
 #ifdef BUILD_FLATBUFFERS
 #  include "parser/flatbuffer/parse_example_flatbuffer.h"
 #endif
+#ifdef BUILD_ARROW
+#  include "parser/arrow/parse_example_arrow.h"
+#endif
 
 #ifdef BUILD_EXTERNAL_PARSER
 #  include "parse_example_external.h"
@@ -92,7 +96,7 @@ bool is_test_only(uint32_t counter, uint32_t period, uint32_t after, bool holdou
 
 void set_compressed(parser* /*par*/) {}
 
-uint32_t cache_numbits(io_buf* buf, VW::io::reader* filepointer)
+uint32_t cache_numbits(io_buf* buf, VW::io::reader* filepointer, uint32_t& cache_format)
 {
   size_t v_length;
   buf->read_file(filepointer, reinterpret_cast<char*>(&v_length), sizeof(v_length));
@@ -111,7 +115,17 @@ uint32_t cache_numbits(io_buf* buf, VW::io::reader* filepointer)
   char temp;
   if (buf->read_file(filepointer, &temp, 1) < 1) THROW("failed to read");
 
-  if (temp != 'c') THROW("data file is not a cache file");
+  // Caches in the original format have no format version.
+  if (temp == 'c') { cache_format = VW::cache_format_records; }
+  else if (temp == 'C')
+  {
+    if (buf->read_file(filepointer, &cache_format, sizeof(cache_format)) < static_cast<int>(sizeof(cache_format)))
+      THROW("failed to read");
+    // Unknown formats are treated like caches written by another version, they are rewritten.
+    if (cache_format != VW::cache_format_blocks) { return 0; }
+  }
+  else
+    THROW("data file is not a cache file");
 
   uint32_t cache_numbits;
   if (buf->read_file(filepointer, &cache_numbits, sizeof(cache_numbits)) < static_cast<int>(sizeof(cache_numbits)))
@@ -120,7 +134,11 @@ uint32_t cache_numbits(io_buf* buf, VW::io::reader* filepointer)
   return cache_numbits;
 }
 
-void set_cache_reader(vw& all) { all.example_parser->reader = read_cached_features; }
+void set_cache_reader(vw& all)
+{
+  all.example_parser->reader = all.example_parser->cache_format == VW::cache_format_blocks ? read_cached_block_features
+                                                                                          : read_cached_features;
+}
 
 void set_string_reader(vw& all)
 {
@@ -191,10 +209,12 @@ void reset_source(vw& all, size_t numbits)
 {
   io_buf* input = all.example_parser->input.get();
   input->current = 0;
+  all.example_parser->cache_reader.reset();
 
   // If in write cache mode then close all of the input files then open the written cache as the new input.
   if (all.example_parser->write_cache)
   {
+    all.example_parser->cache_writer.finish(*all.example_parser->output);
     all.example_parser->output->flush();
     // Turn off write_cache as we are now reading it instead of writing!
     all.example_parser->write_cache = false;
@@ -209,7 +229,8 @@ void reset_source(vw& all, size_t numbits)
                                                                           << all.example_parser->finalname);
     input->close_files();
     // Now open the written cache as the new input file.
-    input->add_file(VW::io::open_file_reader(all.example_parser->finalname));
+    input->add_file(VW::io::open_mapped_file_reader(all.example_parser->finalname));
+    all.example_parser->cache_format = VW::cache_format_blocks;
     set_cache_reader(all);
   }
 
@@ -242,7 +263,8 @@ void reset_source(vw& all, size_t numbits)
       // note: breaking cluster parallel online learning by dropping support for id
 
       auto socket = VW::io::wrap_socket_descriptor(f);
-      all.final_prediction_sink.push_back(socket->get_writer());
+      all.final_prediction_sink.push_back(
+          all.example_parser->pipelined ? socket->get_batched_writer() : socket->get_writer());
       all.example_parser->input->add_file(socket->get_reader());
 
       set_daemon_reader(all, is_currently_json_reader(all), is_currently_dsjson_reader(all));
@@ -252,7 +274,8 @@ void reset_source(vw& all, size_t numbits)
       for (auto& file : input->get_input_files())
       {
         input->reset_file(file.get());
-        if (cache_numbits(input, file.get()) < numbits) THROW("argh, a bug in caching of some sort!");
+        uint32_t cache_format = VW::cache_format_records;
+        if (cache_numbits(input, file.get(), cache_format) < numbits) THROW("argh, a bug in caching of some sort!");
       }
     }
   }
@@ -284,7 +307,9 @@ void make_write_cache(vw& all, std::string& newname, bool quiet)
 
   output->bin_write_fixed(reinterpret_cast<const char*>(&v_length), sizeof(v_length));
   output->bin_write_fixed(VW::version.to_string().c_str(), v_length);
-  output->bin_write_fixed("c", 1);
+  const uint32_t cache_format = VW::cache_format_blocks;
+  output->bin_write_fixed("C", 1);
+  output->bin_write_fixed(reinterpret_cast<const char*>(&cache_format), sizeof(cache_format));
   output->bin_write_fixed(reinterpret_cast<const char*>(&all.num_bits), sizeof(all.num_bits));
   output->flush();
 
@@ -302,7 +327,7 @@ void parse_cache(vw& all, std::vector<std::string> cache_files, bool kill_cache,
     bool cache_file_opened = false;
     if (!kill_cache) try
       {
-        all.example_parser->input->add_file(VW::io::open_file_reader(file));
+        all.example_parser->input->add_file(VW::io::open_mapped_file_reader(file));
         cache_file_opened = true;
       }
       catch (const std::exception&)
@@ -313,8 +338,9 @@ void parse_cache(vw& all, std::vector<std::string> cache_files, bool kill_cache,
       make_write_cache(all, file, quiet);
     else
     {
-      uint64_t c =
-          cache_numbits(all.example_parser->input.get(), all.example_parser->input->get_input_files().back().get());
+      uint32_t cache_format = VW::cache_format_records;
+      uint64_t c = cache_numbits(
+          all.example_parser->input.get(), all.example_parser->input->get_input_files().back().get(), cache_format);
       if (c < all.num_bits)
       {
         if (!quiet)
@@ -326,6 +352,10 @@ void parse_cache(vw& all, std::vector<std::string> cache_files, bool kill_cache,
       else
       {
         if (!quiet) *(all.trace_message) << "using cache_file = " << file.c_str() << endl;
+        // The files are read as a single stream, so they must share a format.
+        if (all.example_parser->input->num_input_files() > 1 && cache_format != all.example_parser->cache_format)
+          THROW("cache files " << cache_files.front() << " and " << file << " are written in different formats");
+        all.example_parser->cache_format = cache_format;
         set_cache_reader(all);
         if (c == all.num_bits)
           all.example_parser->sorted_cache = true;
@@ -358,6 +388,24 @@ void enable_sources(vw& all, bool quiet, size_t passes, input_options& input_opt
 
   if (!all.no_daemon && (all.daemon || all.active))
   {
+    parser& p = *all.example_parser;
+    if (input_options.pipeline)
+    {
+      if (all.hogwild_threads > 1 || p.num_parse_threads > 1)
+      { THROW("pipeline cannot be used with hogwild or parse_threads"); }
+      // Batches end where the input received so far does, see thread_dispatch.
+      p.pipelined = true;
+      p.min_ready_batch_size = p.max_ready_batch_size;
+      p.ready_batch_size = p.max_ready_batch_size;
+    }
+    else
+    {
+      // Clients wait for each prediction before sending more, so examples cannot be held back to fill a batch.
+      p.min_ready_batch_size = 1;
+      p.max_ready_batch_size = 1;
+      p.ready_batch_size = 1;
+    }
+
 #ifdef _WIN32
     WSAData wsaData;
     int lastError = WSAStartup(MAKEWORD(2, 2), &wsaData);
@@ -395,7 +443,9 @@ void enable_sources(vw& all, bool quiet, size_t passes, input_options& input_opt
       THROWERRNO("bind");
 
     // listen on socket
-    if (listen(all.example_parser->bound_sock, 1) < 0) THROWERRNO("listen");
+    // The prediction server takes many connections at once, children one at a time.
+    const int backlog = all.predict_threads > 0 ? SOMAXCONN : 1;
+    if (listen(all.example_parser->bound_sock, backlog) < 0) THROWERRNO("listen");
 
     // write port file
     if (all.options->was_supplied("port_file"))
@@ -439,6 +489,9 @@ void enable_sources(vw& all, bool quiet, size_t passes, input_options& input_opt
 #endif
     }
 
+    // VW::serve_predictions takes over from here.
+    if (all.predict_threads > 0) return;
+
     if (all.daemon && !all.active)
     {
 #ifdef _WIN32
@@ -524,7 +577,7 @@ void enable_sources(vw& all, bool quiet, size_t passes, input_options& input_opt
 
     auto socket = VW::io::wrap_socket_descriptor(f_a);
 
-    all.final_prediction_sink.push_back(socket->get_writer());
+    all.final_prediction_sink.push_back(p.pipelined ? socket->get_batched_writer() : socket->get_writer());
 
     all.example_parser->input->add_file(socket->get_reader());
     if (!all.logger.quiet) *(all.trace_message) << "reading data from port " << port << endl;
@@ -566,6 +619,8 @@ void enable_sources(vw& all, bool quiet, size_t passes, input_options& input_opt
           {
             adapter = VW::io::open_stdin();
           }
+          // Batches end where the input read so far does, see thread_dispatch.
+          all.example_parser->interactive_input = true;
         }
 
         if (adapter) { all.example_parser->input->add_file(std::move(adapter)); }
@@ -598,6 +653,16 @@ void enable_sources(vw& all, bool quiet, size_t passes, input_options& input_opt
         all.example_parser->reader = VW::parsers::flatbuffer::flatbuffer_to_examples;
       }
 #endif
+#ifdef BUILD_ARROW
+      else if (input_options.arrow)
+      {
+        all.arrow_converter = VW::make_unique<VW::parsers::arrow::parser>(VW::parsers::arrow::schema_spec::parse(
+            input_options.arrow_label, input_options.arrow_tag, input_options.arrow_namespaces));
+        // Without a data file, record batches are handed over in memory through arrow_converter->open_buffer.
+        if (!all.data_filename.empty()) { all.arrow_converter->open_file(all.data_filename); }
+        all.example_parser->reader = VW::parsers::arrow::arrow_to_examples;
+      }
+#endif
 
 #ifdef BUILD_EXTERNAL_PARSER
       else if (input_options.ext_opts && input_options.ext_opts->is_enabled())
@@ -622,8 +687,44 @@ void enable_sources(vw& all, bool quiet, size_t passes, input_options& input_opt
   if (!quiet && !all.daemon) *(all.trace_message) << "num sources = " << all.example_parser->input->num_files() << endl;
 }
 
+namespace
+{
+void flush_ready_examples(parser& p)
+{
+  if (p.pending_ready_batch == nullptr) { return; }
+  // Parsing waits here for the learner to get the examples in flight back within ring_size. A batch goes out anyway
+  // once nothing is queued before it, since the learner may need all of it to finish a sequence.
+  p.ready_parsed_examples.push_when(p.pending_ready_batch,
+      [&p]() { return p.ready_parsed_examples.size() == 0 || p.ready_examples.load() <= p.ring_size; });
+  p.pending_ready_batch = nullptr;
+
+  // Shrink batches when this one is all the learner has left to work on, and grow them while it has a backlog so each
+  // handoff carries more examples.
+  const size_t queued = p.ready_parsed_examples.size();
+  if (queued <= 1) { p.ready_batch_size = std::max(p.ready_batch_size / 2, p.min_ready_batch_size); }
+  else if (queued * 2 >= ready_batch_queue_size(p.ring_size))
+  {
+    p.ready_batch_size = std::min(p.ready_batch_size * 2, p.max_ready_batch_size);
+  }
+}
+
+void return_ready_batch(vw& all, v_array<example*>* batch, size_t first_unfinished)
+{
+  for (size_t i = first_unfinished; i < batch->size(); i++) { VW::finish_example(all, *(*batch)[i]); }
+  release_ready_batch(*all.example_parser, batch);
+}
+}  // namespace
+
+void release_ready_batch(parser& p, v_array<example*>* batch)
+{
+  p.ready_examples -= batch->size();
+  batch->clear();
+  p.example_batch_pool.return_object(batch);
+}
+
 void lock_done(parser& p)
 {
+  flush_ready_examples(p);
   p.done = true;
   // in case get_example() is waiting for a fresh example, wake so it can realize there are no more.
   p.ready_parsed_examples.set_done();
@@ -632,7 +733,9 @@ void lock_done(parser& p)
 void set_done(vw& all)
 {
   all.early_terminate = true;
-  lock_done(*all.example_parser);
+  // Unlike lock_done this may be called from the learner, so the batch the parse thread is filling is left alone.
+  all.example_parser->done = true;
+  all.example_parser->ready_parsed_examples.set_done();
 }
 
 void end_pass_example(vw& all, example* ae)
@@ -659,6 +762,7 @@ example& get_unused_example(vw* all)
 {
   parser* p = all->example_parser;
   auto ex = p->example_pool.get_object();
+  if (p->feature_arena) { use_feature_arena(*ex); }
   p->begin_parsed_examples++;
   VW_WARNING_STATE_PUSH
   VW_WARNING_DISABLE_DEPRECATED_USAGE
@@ -677,7 +781,10 @@ void setup_example(vw& all, example* ae)
   if (all.example_parser->sort_features && ae->sorted == false) unique_sort_features(all.parse_mask, ae);
 
   if (all.example_parser->write_cache)
-  { VW::write_example_to_cache(*all.example_parser->output, ae, all.example_parser->lbl_parser, all.parse_mask); }
+  {
+    all.example_parser->cache_writer.add_example(
+        *all.example_parser->output, ae, all.example_parser->lbl_parser, all.parse_mask);
+  }
 
   ae->partial_prediction = 0.;
   ae->num_features = 0;
@@ -846,6 +953,7 @@ void parse_example_label(vw& all, example& ec, std::string label)
 void empty_example(vw& /*all*/, example& ec)
 {
   for (features& fs : ec) fs.clear();
+  if (ec.arena != nullptr) { VW::reset_feature_arena(ec); }
 
   ec.indices.clear();
   ec.tag.clear();
@@ -879,6 +987,15 @@ void finish_example(vw& all, example& ec)
 
   clean_example(all, ec, false);
 
+  // The predictions of a pipelined batch go out together once its last example is done, before reset_source can see
+  // the batch finished and drop the connection.
+  parser& p = *all.example_parser;
+  if (p.pipelined && p.current_ready_batch != nullptr && p.current_ready_index == p.current_ready_batch->size() &&
+      p.current_ready_batch->back() == &ec)
+  {
+    for (auto& sink : all.final_prediction_sink) { sink->flush(); }
+  }
+
   {
     std::lock_guard<std::mutex> lock(all.example_parser->output_lock);
     ++all.example_parser->finished_examples;
@@ -889,15 +1006,38 @@ void finish_example(vw& all, example& ec)
 
 void thread_dispatch(vw& all, const v_array<example*>& examples)
 {
-  all.example_parser->end_parsed_examples += examples.size();
-  for (auto example : examples) { all.example_parser->ready_parsed_examples.push(example); }
+  parser& p = *all.example_parser;
+  p.end_parsed_examples += examples.size();
+  p.ready_examples += examples.size();
+  if (p.pending_ready_batch == nullptr) { p.pending_ready_batch = p.example_batch_pool.get_object(); }
+  auto& batch = *p.pending_ready_batch;
+  for (auto example : examples) { batch.push_back(example); }
+
+  const example& last = *examples.back();
+  // Multiline learners get whole sequences, which end with a newline example, unless one is longer than a batch.
+  const bool sequence_complete = !all.l->is_multiline || example_is_newline(last) || last.end_pass;
+  // A pipelining client, or someone typing into stdin, waits once everything sent so far is parsed.
+  const bool input_drained = (p.pipelined || p.interactive_input) && p.input->unread_bytes_count() == 0;
+  if (last.end_pass || input_drained || batch.size() >= p.max_ready_batch_size ||
+      (sequence_complete && batch.size() >= p.ready_batch_size))
+  { flush_ready_examples(p); }
 }
 
-void main_parse_loop(vw* all) { parse_dispatch(*all, thread_dispatch); }
+void main_parse_loop(vw* all) { parse_dispatch_maybe_parallel(*all, thread_dispatch); }
 
 namespace VW
 {
-example* get_example(parser* p) { return p->ready_parsed_examples.pop(); }
+example* get_example(parser* p)
+{
+  while (p->current_ready_batch == nullptr || p->current_ready_index == p->current_ready_batch->size())
+  {
+    if (p->current_ready_batch != nullptr) { release_ready_batch(*p, p->current_ready_batch); }
+    p->current_ready_batch = p->ready_parsed_examples.pop();
+    p->current_ready_index = 0;
+    if (p->current_ready_batch == nullptr) { return nullptr; }
+  }
+  return (*p->current_ready_batch)[p->current_ready_index++];
+}
 
 float get_topic_prediction(example* ec, size_t i) { return ec->pred.scalars[i]; }
 
@@ -958,12 +1098,20 @@ void start_parser(vw& all) { all.parse_thread = std::thread(main_parse_loop, &al
 void free_parser(vw& all)
 {
   // It is possible to exit early when the queue is not yet empty.
+  // finish_example also handles examples that were not from the pool.
+  parser& p = *all.example_parser;
+  if (p.current_ready_batch != nullptr)
+  {
+    return_ready_batch(all, p.current_ready_batch, p.current_ready_index);
+    p.current_ready_batch = nullptr;
+  }
+
+  while (p.ready_parsed_examples.size() > 0) { return_ready_batch(all, p.ready_parsed_examples.pop(), 0); }
 
-  while (all.example_parser->ready_parsed_examples.size() > 0)
+  if (p.pending_ready_batch != nullptr)
   {
-    auto* current = all.example_parser->ready_parsed_examples.pop();
-    // this function also handles examples that were not from the pool.
-    VW::finish_example(all, *current);
+    return_ready_batch(all, p.pending_ready_batch, 0);
+    p.pending_ready_batch = nullptr;
   }
 
   // There should be no examples in flight at this point.
@@ -20,9 +20,11 @@
 #  include <condition_variable>
 #endif
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include "vw_string_view.h"
+#include "cache.h"
 #include "queue.h"
 #include "object_pool.h"
 #include "hashstring.h"
@@ -31,11 +33,28 @@
 struct vw;
 struct input_options;
 struct dsjson_metrics;
+
+// Bounds for the number of examples handed from the parse thread to the learner at once, see thread_dispatch. Neither
+// exceeds ring_size.
+constexpr size_t default_min_ready_batch_size = 64;
+constexpr size_t default_max_ready_batch_size = 1024;
+
+// Number of batches which may wait for the learner: enough to hold ring_size examples in batches of the smallest size.
+inline size_t ready_batch_queue_size(size_t ring_size)
+{
+  return std::max(static_cast<size_t>(2), ring_size / std::min(default_min_ready_batch_size, ring_size));
+}
+
 struct parser
 {
   parser(size_t ring_size, bool strict_parse_)
       : example_pool{ring_size}
-      , ready_parsed_examples{ring_size}
+      // The queued batches plus the one being filled and the one being consumed.
+      , example_batch_pool{ready_batch_queue_size(ring_size) + 2}
+      , ready_parsed_examples{ready_batch_queue_size(ring_size)}
+      , min_ready_batch_size{std::min(default_min_ready_batch_size, ring_size)}
+      , max_ready_batch_size{std::min(default_max_ready_batch_size, ring_size)}
+      , ready_batch_size{min_ready_batch_size}
       , ring_size{ring_size}
       , begin_parsed_examples(0)
       , end_parsed_examples(0)
@@ -55,7 +74,20 @@ struct parser
   std::vector<VW::string_view> words;
 
   VW::object_pool<example> example_pool;
-  VW::ptr_queue<example> ready_parsed_examples;
+
+  // Parsed examples travel to the learner in batches so the queue is synchronized once per batch rather than once per
+  // example. The parse thread fills pending_ready_batch while get_example hands out current_ready_batch.
+  VW::object_pool<v_array<example*>> example_batch_pool;
+  VW::ptr_queue<v_array<example*>> ready_parsed_examples;
+  v_array<example*>* pending_ready_batch = nullptr;
+  v_array<example*>* current_ready_batch = nullptr;
+  size_t current_ready_index = 0;
+  size_t min_ready_batch_size;
+  size_t max_ready_batch_size;
+  size_t ready_batch_size;  // Current target, adapted to how far the learner is behind.
+  // Examples dispatched by the parse thread and not yet released by the learner, see release_ready_batch. The parse
+  // thread waits for this to be back within ring_size before it queues another batch.
+  std::atomic<size_t> ready_examples{0};
 
   std::unique_ptr<io_buf> input;  // Input source(s)
   /// reader consumes the input io_buf in the vw object and is generally for file based parsing
@@ -73,9 +105,14 @@ struct parser
 
   bool write_cache = false;
   bool sort_features = false;
+  bool feature_arena = false;  // Whether pooled examples keep their features in a VW::feature_arena.
   bool sorted_cache = false;
+  uint32_t cache_format = VW::cache_format_records;  // Format of the cache files being read.
+  VW::cache_block_writer cache_writer;
+  VW::cache_block_reader cache_reader;
 
   const size_t ring_size;
+  size_t num_parse_threads = 1;  // Number of threads parsing and hashing examples, see parallel_parse.h
   std::atomic<uint64_t> begin_parsed_examples;  // The index of the beginning parsed example.
   std::atomic<uint64_t> end_parsed_examples;    // The index of the fully parsed example.
   std::atomic<uint64_t> finished_examples;      // The count of finished examples.
@@ -92,6 +129,10 @@ struct parser
   v_array<size_t> counts;  // partial examples received from sources
   size_t finished_count;   // the number of finished examples;
   int bound_sock = 0;
+  // Daemon clients send many examples before they wait for predictions, which go back once per batch, see --pipeline.
+  bool pipelined = false;
+  // Reading stdin may wait for input which is not written yet, so what was parsed before is not held back.
+  bool interactive_input = false;
 
   std::vector<VW::string_view> parse_name;
 
@@ -122,8 +163,13 @@ VW_DEPRECATED("Function is no longer used. This will be removed in VW 9.0.")
 void adjust_used_index(vw& all);
 
 // parser control
+// Hands any pending batch to the learner and wakes it so it can see there are no more examples. Only called by the
+// parse thread, other threads stop parsing with set_done.
 void lock_done(parser& p);
 void set_done(vw& all);
+// Returns a batch taken off ready_parsed_examples to the pool once the learner is done with its examples. Must happen
+// before the next pop, which is when the parse thread looks for room again.
+void release_ready_batch(parser& p, v_array<example*>* batch);
 
 // source control functions
 void reset_source(vw& all, size_t numbits);
@@ -0,0 +1,344 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include "../../global_data.h"
+#include "../../best_constant.h"
+#include "hash.h"
+#include "parse_example_arrow.h"
+
+namespace VW
+{
+namespace parsers
+{
+namespace arrow
+{
+namespace
+{
+void check(const ::arrow::Status& status, const char* what)
+{
+  if (!status.ok()) THROW(what << ": " << status.ToString());
+}
+
+template <typename T>
+T value_or_throw(::arrow::Result<T> result, const char* what)
+{
+  check(result.status(), what);
+  return std::move(result).ValueOrDie();
+}
+
+bool is_string(const ::arrow::Array& values)
+{
+  return values.type_id() == ::arrow::Type::STRING || values.type_id() == ::arrow::Type::LARGE_STRING;
+}
+
+bool is_supported(const ::arrow::Array& values)
+{
+  switch (values.type_id())
+  {
+    case ::arrow::Type::BOOL:
+    case ::arrow::Type::UINT8:
+    case ::arrow::Type::INT8:
+    case ::arrow::Type::UINT16:
+    case ::arrow::Type::INT16:
+    case ::arrow::Type::UINT32:
+    case ::arrow::Type::INT32:
+    case ::arrow::Type::UINT64:
+    case ::arrow::Type::INT64:
+    case ::arrow::Type::FLOAT:
+    case ::arrow::Type::DOUBLE:
+      return true;
+    default:
+      return is_string(values);
+  }
+}
+
+float numeric_cell(const ::arrow::Array& values, int64_t row)
+{
+  switch (values.type_id())
+  {
+    case ::arrow::Type::BOOL:
+      return static_cast<const ::arrow::BooleanArray&>(values).Value(row) ? 1.f : 0.f;
+    case ::arrow::Type::UINT8:
+      return static_cast<float>(static_cast<const ::arrow::UInt8Array&>(values).Value(row));
+    case ::arrow::Type::INT8:
+      return static_cast<float>(static_cast<const ::arrow::Int8Array&>(values).Value(row));
+    case ::arrow::Type::UINT16:
+      return static_cast<float>(static_cast<const ::arrow::UInt16Array&>(values).Value(row));
+    case ::arrow::Type::INT16:
+      return static_cast<float>(static_cast<const ::arrow::Int16Array&>(values).Value(row));
+    case ::arrow::Type::UINT32:
+      return static_cast<float>(static_cast<const ::arrow::UInt32Array&>(values).Value(row));
+    case ::arrow::Type::INT32:
+      return static_cast<float>(static_cast<const ::arrow::Int32Array&>(values).Value(row));
+    case ::arrow::Type::UINT64:
+      return static_cast<float>(static_cast<const ::arrow::UInt64Array&>(values).Value(row));
+    case ::arrow::Type::INT64:
+      return static_cast<float>(static_cast<const ::arrow::Int64Array&>(values).Value(row));
+    case ::arrow::Type::FLOAT:
+      return static_cast<const ::arrow::FloatArray&>(values).Value(row);
+    case ::arrow::Type::DOUBLE:
+      return static_cast<float>(static_cast<const ::arrow::DoubleArray&>(values).Value(row));
+    default:
+      THROW("Column of type " << values.type()->ToString() << " has no numeric value");
+  }
+}
+
+VW::string_view string_cell(const ::arrow::Array& values, int64_t row)
+{
+  if (values.type_id() == ::arrow::Type::LARGE_STRING)
+  {
+    int64_t length = 0;
+    const uint8_t* bytes = static_cast<const ::arrow::LargeStringArray&>(values).GetValue(row, &length);
+    return VW::string_view(reinterpret_cast<const char*>(bytes), static_cast<size_t>(length));
+  }
+  int32_t length = 0;
+  const uint8_t* bytes = static_cast<const ::arrow::StringArray&>(values).GetValue(row, &length);
+  return VW::string_view(reinterpret_cast<const char*>(bytes), static_cast<size_t>(length));
+}
+
+bool is_floating_point(const ::arrow::Array& values)
+{
+  return values.type_id() == ::arrow::Type::FLOAT || values.type_id() == ::arrow::Type::DOUBLE;
+}
+
+// The label of a row in the text format, for label types that are not simple.
+std::string label_text(const ::arrow::Array& values, int64_t row)
+{
+  if (is_string(values))
+  {
+    const auto text = string_cell(values, row);
+    return std::string(text.begin(), text.end());
+  }
+  const float value = numeric_cell(values, row);
+  if (!is_floating_point(values)) { return std::to_string(static_cast<int64_t>(value)); }
+  std::ostringstream text;
+  text << value;
+  return text.str();
+}
+}  // namespace
+
+int arrow_to_examples(vw* all, v_array<example*>& examples)
+{
+  return static_cast<int>(all->arrow_converter->parse_examples(all, examples));
+}
+
+schema_spec schema_spec::parse(
+    const std::string& label_column, const std::string& tag_column, const std::vector<std::string>& namespaces)
+{
+  schema_spec spec;
+  spec.label_column = label_column;
+  spec.tag_column = tag_column;
+  for (const auto& ns : namespaces)
+  {
+    const auto colon = ns.find(':');
+    if (colon == 0 || colon == std::string::npos || colon + 1 == ns.size())
+    { THROW("Expected --arrow_namespace in the form name:column,column,... but got '" << ns << "'"); }
+
+    std::vector<std::string> columns;
+    size_t begin = colon + 1;
+    while (begin <= ns.size())
+    {
+      auto end = ns.find(',', begin);
+      if (end == std::string::npos) { end = ns.size(); }
+      if (end > begin) { columns.push_back(ns.substr(begin, end - begin)); }
+      begin = end + 1;
+    }
+    spec.namespaces.emplace_back(ns.substr(0, colon), std::move(columns));
+  }
+  return spec;
+}
+
+parser::parser(schema_spec spec) : _spec(std::move(spec)) {}
+
+void parser::open_file(const std::string& path)
+{
+  open(value_or_throw(::arrow::io::MemoryMappedFile::Open(path, ::arrow::io::FileMode::READ),
+      "Could not open the Arrow file"));
+}
+
+void parser::open_buffer(const uint8_t* data, size_t size)
+{
+  auto buffer = std::make_shared<::arrow::Buffer>(data, static_cast<int64_t>(size));
+  open(std::make_shared<::arrow::io::BufferReader>(buffer));
+}
+
+void parser::open(std::shared_ptr<::arrow::io::RandomAccessFile> input)
+{
+  _batch.reset();
+  _file_reader.reset();
+  _stream_reader.reset();
+  _next_batch_index = 0;
+  _row = 0;
+  _input = std::move(input);
+
+  // The file format starts with a magic string, the stream format with its first message.
+  const auto size = value_or_throw(_input->GetSize(), "Could not read the Arrow input");
+  bool file_format = false;
+  if (size >= 6)
+  {
+    const auto magic = value_or_throw(_input->ReadAt(0, 6), "Could not read the Arrow input");
+    file_format = std::memcmp(magic->data(), "ARROW1", 6) == 0;
+  }
+
+  if (file_format)
+  { _file_reader = value_or_throw(::arrow::ipc::RecordBatchFileReader::Open(_input), "Not an Arrow IPC file"); }
+  else
+  {
+    _stream_reader = value_or_throw(::arrow::ipc::RecordBatchStreamReader::Open(_input), "Not an Arrow IPC stream");
+  }
+}
+
+bool parser::parse_examples(vw* all, v_array<example*>& examples)
+{
+  while (_batch == nullptr || _row == _batch->num_rows())
+  {
+    if (!next_batch(all)) { return false; }
+  }
+  parse_row(all, examples[0], _row++);
+  return true;
+}
+
+bool parser::next_batch(vw* all)
+{
+  _batch.reset();
+  if (_file_reader != nullptr)
+  {
+    if (_next_batch_index < _file_reader->num_record_batches())
+    {
+      _batch = value_or_throw(
+          _file_reader->ReadRecordBatch(_next_batch_index++), "Could not read a record batch of the Arrow file");
+    }
+  }
+  else if (_stream_reader != nullptr)
+  {
+    check(_stream_reader->ReadNext(&_batch), "Could not read a record batch of the Arrow stream");
+  }
+
+  if (_batch == nullptr) { return false; }
+  _row = 0;
+  bind_columns(all);
+  return true;
+}
+
+void parser::bind_columns(vw* all)
+{
+  const auto& schema = *_batch->schema();
+  auto find_column = [&](const std::string& name) -> int {
+    const int index = schema.GetFieldIndex(name);
+    if (index < 0) THROW("There is no column '" << name << "' in the Arrow record batch");
+    return index;
+  };
+
+  _label = _spec.label_column.empty() ? nullptr : _batch->column(find_column(_spec.label_column));
+  _tag = _spec.tag_column.empty() ? nullptr : _batch->column(find_column(_spec.tag_column));
+  if (_label != nullptr && !is_supported(*_label))
+  { THROW("The label column '" << _spec.label_column << "' has the unsupported type " << _label->type()->ToString()); }
+  if (_tag != nullptr && !is_string(*_tag))
+  { THROW("The tag column '" << _spec.tag_column << "' has to hold strings"); }
+
+  _namespaces.clear();
+  if (_spec.namespaces.empty())
+  {
+    // The default namespace is hashed as in the text format.
+    bound_namespace ns;
+    ns.name = " ";
+    ns.index = static_cast<namespace_index>(' ');
+    ns.hash = all->hash_seed == 0 ? 0 : uniform_hash("", 0, all->hash_seed);
+    for (int i = 0; i < _batch->num_columns(); i++)
+    {
+      const auto& name = schema.field(i)->name();
+      if (name == _spec.label_column || name == _spec.tag_column) { continue; }
+      ns.columns.push_back(bind_column(all, i, ns.hash));
+    }
+    _namespaces.push_back(std::move(ns));
+    return;
+  }
+
+  for (const auto& spec : _spec.namespaces)
+  {
+    bound_namespace ns;
+    ns.name = spec.first;
+    ns.index = static_cast<namespace_index>(spec.first[0]);
+    ns.hash = VW::hash_space(*all, spec.first);
+    for (const auto& column : spec.second) { ns.columns.push_back(bind_column(all, find_column(column), ns.hash)); }
+    _namespaces.push_back(std::move(ns));
+  }
+}
+
+parser::bound_column parser::bind_column(vw* all, int index, uint64_t namespace_hash)
+{
+  bound_column column;
+  column.values = _batch->column(index);
+  column.name = &_batch->schema()->field(index)->name();
+  if (!is_supported(*column.values))
+  { THROW("The column '" << *column.name << "' has the unsupported type " << column.values->type()->ToString()); }
+  column.hash = all->example_parser->hasher(column.name->data(), column.name->size(), namespace_hash);
+  return column;
+}
+
+void parser::parse_row(vw* all, example* ae, int64_t row)
+{
+  all->example_parser->lbl_parser.default_label(&ae->l);
+  if (_label != nullptr && !_label->IsNull(row)) { parse_label(all, ae, row); }
+
+  if (_tag != nullptr && !_tag->IsNull(row))
+  {
+    const auto tag = string_cell(*_tag, row);
+    ae->tag.insert(ae->tag.end(), tag.begin(), tag.end());
+  }
+
+  for (const auto& ns : _namespaces)
+  {
+    features& fs = ae->feature_space[ns.index];
+    const size_t before = fs.size();
+    for (const auto& column : ns.columns)
+    {
+      if (!column.values->IsNull(row)) { add_feature(all, fs, ns, column, row); }
+    }
+    if (fs.size() > before && std::find(ae->indices.begin(), ae->indices.end(), ns.index) == ae->indices.end())
+    { ae->indices.push_back(ns.index); }
+  }
+}
+
+void parser::parse_label(vw* all, example* ae, int64_t row)
+{
+  if (all->example_parser->lbl_parser.label_type == label_type_t::simple && !is_string(*_label))
+  {
+    ae->l.simple.label = numeric_cell(*_label, row);
+    count_label(all->sd, ae->l.simple.label);
+  }
+  else
+  {
+    VW::parse_example_label(*all, *ae, label_text(*_label, row));
+  }
+}
+
+void parser::add_feature(vw* all, features& fs, const bound_namespace& ns, const bound_column& column, int64_t row)
+{
+  const bool audit = all->audit || all->hash_inv;
+  if (is_string(*column.values))
+  {
+    const auto value = string_cell(*column.values, row);
+    fs.push_back(1.f, all->example_parser->hasher(value.data(), value.size(), column.hash) & all->parse_mask);
+    if (audit)
+    {
+      std::string name = *column.name;
+      name.append("^").append(value.data(), value.size());
+      fs.space_names.push_back(audit_strings(ns.name, std::move(name)));
+    }
+    return;
+  }
+
+  const float value = numeric_cell(*column.values, row);
+  if (value == 0.f) { return; }
+  fs.push_back(value, column.hash & all->parse_mask);
+  if (audit) { fs.space_names.push_back(audit_strings(ns.name, *column.name)); }
+}
+}  // namespace arrow
+}  // namespace parsers
+}  // namespace VW
@@ -0,0 +1,98 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../../vw.h"
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+
+namespace VW
+{
+namespace parsers
+{
+namespace arrow
+{
+int arrow_to_examples(vw* all, v_array<example*>& examples);
+
+// Which columns of the record batches hold the label and the tag, and which namespace the other columns belong to.
+struct schema_spec
+{
+  std::string label_column;
+  std::string tag_column;
+  // Namespace names and their columns. Without any, every column but the label and the tag goes to the default
+  // namespace; with some, columns not listed are skipped.
+  std::vector<std::pair<std::string, std::vector<std::string>>> namespaces;
+
+  // Takes namespaces in the form of --arrow_namespace, "name:column,column,...".
+  static schema_spec parse(
+      const std::string& label_column, const std::string& tag_column, const std::vector<std::string>& namespaces);
+};
+
+// Turns the rows of Arrow record batches into examples, one row per example. A numeric column becomes the feature
+// named after the column with the cell as its value, as "|ns column:value" would in the text format. A string column
+// becomes the feature column^value of weight 1, hashed like the chained hashes of --chain_hash JSON. Zeros and nulls
+// add no feature. Names are hashed once per batch, not once per row.
+class parser
+{
+public:
+  explicit parser(schema_spec spec);
+
+  // Reads record batches from an Arrow IPC file, in either the file or the stream format. The file is memory mapped.
+  void open_file(const std::string& path);
+  // Reads record batches from an Arrow IPC file or stream held in memory. The memory has to outlive the parser or
+  // the next call to open.
+  void open_buffer(const uint8_t* data, size_t size);
+
+  // Fills examples[0] with the next row, false once all batches are read.
+  bool parse_examples(vw* all, v_array<example*>& examples);
+
+private:
+  struct bound_column
+  {
+    std::shared_ptr<::arrow::Array> values;
+    const std::string* name;
+    // Hash of the column name in its namespace, the seed of the hashes of string cells.
+    uint64_t hash;
+  };
+
+  struct bound_namespace
+  {
+    std::string name;
+    namespace_index index;
+    uint64_t hash;
+    std::vector<bound_column> columns;
+  };
+
+  void open(std::shared_ptr<::arrow::io::RandomAccessFile> input);
+  bool next_batch(vw* all);
+  void bind_columns(vw* all);
+  bound_column bind_column(vw* all, int index, uint64_t namespace_hash);
+  void parse_row(vw* all, example* ae, int64_t row);
+  void parse_label(vw* all, example* ae, int64_t row);
+  void add_feature(vw* all, features& fs, const bound_namespace& ns, const bound_column& column, int64_t row);
+
+  schema_spec _spec;
+  std::shared_ptr<::arrow::io::RandomAccessFile> _input;
+  std::shared_ptr<::arrow::ipc::RecordBatchFileReader> _file_reader;
+  std::shared_ptr<::arrow::RecordBatchReader> _stream_reader;
+  int _next_batch_index = 0;
+
+  std::shared_ptr<::arrow::RecordBatch> _batch;
+  int64_t _row = 0;
+  std::shared_ptr<::arrow::Array> _label;
+  std::shared_ptr<::arrow::Array> _tag;
+  std::vector<bound_namespace> _namespaces;
+};
+}  // namespace arrow
+}  // namespace parsers
+}  // namespace VW
@@ -0,0 +1,470 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#include "prediction_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#  include <fcntl.h>
+#  include <netinet/in.h>
+#  include <netinet/tcp.h>
+#  include <sys/epoll.h>
+#  include <sys/eventfd.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+#endif
+
+#include "example.h"
+#include "global_data.h"
+#include "io/io_adapter.h"
+#include "io/logger.h"
+#include "options_serializer_boost_po.h"
+#include "parse_example.h"
+#include "parser.h"
+#include "queue.h"
+#include "shared_data.h"
+#include "vw.h"
+#include "vw_exception.h"
+
+void clean_example(vw&, example&, bool rewind);
+
+namespace logger = VW::io::logger;
+
+namespace
+{
+// Options of the served model the predictors leave out. They would listen, load or write files, or print.
+const std::set<std::string> server_only_options = {"daemon", "foreground", "port", "num_children", "pid_file",
+    "port_file", "predict_threads", "initial_regressor", "no_stdin", "quiet", "progress", "audit", "testonly", "data",
+    "cache", "cache_file", "kill_cache", "final_regressor", "readable_model", "invert_hash", "save_per_pass",
+    "save_in_background", "predictions", "raw_predictions", "output_feature_regularizer_binary",
+    "output_feature_regularizer_text", "train_threads", "hogwild"};
+
+// The options rebuilding the served model around a predictor, which never learns.
+std::string predictor_arguments(vw& model)
+{
+  VW::config::options_serializer_boost_po serializer;
+  for (auto const& option : model.options->get_all_options())
+  {
+    if (model.options->was_supplied(option->m_name) && server_only_options.count(option->m_name) == 0)
+    { serializer.add(*option); }
+  }
+  return serializer.str() + " --testonly --quiet --no_stdin";
+}
+}  // namespace
+
+namespace VW
+{
+#ifdef __linux__
+namespace
+{
+struct connection
+{
+  explicit connection(int socket) : fd(socket) {}
+
+  int fd;
+  std::string input;  // received, not predicted yet
+  std::string output;  // predicted, not sent yet
+  bool eof = false;  // the client is done sending
+  bool failed = false;  // a line could not be predicted, the connection is closed
+};
+
+struct predictor
+{
+  vw* model = nullptr;
+  std::shared_ptr<std::vector<char>> predictions = std::make_shared<std::vector<char>>();
+};
+
+// Predicts one line of the text format into the predictions of p.
+void predict_line(predictor& p, VW::string_view line)
+{
+  vw& model = *p.model;
+  example* ec = &VW::get_unused_example(&model);
+  try
+  {
+    substring_to_example(&model, ec, line);
+    setup_example(model, ec);
+    model.learn(*ec);
+  }
+  catch (...)
+  {
+    clean_example(model, *ec, false);
+    throw;
+  }
+  VW::finish_example(model, *ec);
+}
+
+void close_socket(int fd)
+{
+  while (close(fd) < 0 && errno == EINTR) {}
+}
+}  // namespace
+#endif
+
+struct prediction_server_state
+{
+#ifdef __linux__
+  prediction_server_state(vw& model, int socket, size_t num_threads) : listen_socket(socket), work(1024)
+  {
+    if (num_threads == 0) THROW("A prediction server needs at least one predictor thread");
+    if (model.l->is_multiline) THROW("The prediction server does not support reductions taking multi line examples");
+    epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll < 0) THROWERRNO("epoll_create1");
+    wakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeup < 0)
+    {
+      close_socket(epoll);
+      THROWERRNO("eventfd");
+    }
+
+    const std::string arguments = predictor_arguments(model);
+    try
+    {
+      for (size_t i = 0; i < num_threads; i++)
+      {
+        predictors.emplace_back();
+        predictor& p = predictors.back();
+        p.model = VW::initialize(arguments, nullptr, true /* skipModelLoad */);
+        p.model->weights.shallow_copy(model.weights);
+        // A shared_data of its own, so that the predictors do not race on the statistics.
+        delete p.model->sd;
+        p.model->sd = new shared_data(*model.sd);
+        p.model->example_parser->_shared_data = p.model->sd;
+        p.model->final_prediction_sink.push_back(VW::io::create_vector_writer(p.predictions));
+      }
+    }
+    catch (...)
+    {
+      release_predictors();
+      close_socket(wakeup);
+      close_socket(epoll);
+      throw;
+    }
+  }
+
+  ~prediction_server_state()
+  {
+    release_predictors();
+    for (auto& entry : connections) { close_socket(entry.first); }
+    close_socket(wakeup);
+    close_socket(epoll);
+  }
+
+  void release_predictors()
+  {
+    for (auto& p : predictors)
+    {
+      if (p.model == nullptr) continue;
+      // Seeded, so finish leaves the shared_data alone.
+      shared_data* sd = p.model->sd;
+      VW::finish(*p.model);
+      delete sd;
+      p.model = nullptr;
+    }
+  }
+
+  // Starts watching fd for events again, they are reported once with EPOLLONESHOT. Whoever holds a connection arms it
+  // when done with it, which hands it back to the event loop.
+  void arm(connection& conn, uint32_t events)
+  {
+    epoll_event event;
+    // Hang ups are only of interest while reading, they would keep waking the loop while waiting to send.
+    event.events = events | ((events & EPOLLIN) != 0 ? EPOLLRDHUP : 0) | EPOLLONESHOT;
+    event.data.ptr = &conn;
+    if (epoll_ctl(epoll, EPOLL_CTL_MOD, conn.fd, &event) < 0) THROWERRNO("epoll_ctl");
+  }
+
+  void watch(int fd, void* data)
+  {
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = data;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0) THROWERRNO("epoll_ctl");
+  }
+
+  void accept_connections()
+  {
+    while (true)
+    {
+      const int fd = accept4(listen_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0)
+      {
+        if (errno == EINTR || errno == ECONNABORTED) continue;
+        // EAGAIN once all pending connections are taken, anything else is left for the next round.
+        if (errno != EAGAIN && errno != EWOULDBLOCK) logger::errlog_warn("accept: {}", VW::strerror_to_string(errno));
+        return;
+      }
+      // Disable Nagle delay algorithm due to the interactive workload, as in daemon mode
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char*>(&one), sizeof(one));
+
+      auto* conn = new connection(fd);
+      connections[fd].reset(conn);
+      epoll_event event;
+      event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+      event.data.ptr = conn;
+      if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+      {
+        logger::errlog_warn("epoll_ctl: {}", VW::strerror_to_string(errno));
+        close_connection(*conn);
+      }
+    }
+  }
+
+  void close_connection(connection& conn)
+  {
+    const int fd = conn.fd;
+    close_socket(fd);
+    connections.erase(fd);
+  }
+
+  // Sends as much of the output as the socket takes. False when the connection is broken.
+  bool send_output(connection& conn)
+  {
+    size_t sent = 0;
+    while (sent < conn.output.size())
+    {
+      const ssize_t n = send(conn.fd, conn.output.data() + sent, conn.output.size() - sent, MSG_NOSIGNAL);
+      if (n < 0)
+      {
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        return false;
+      }
+      sent += static_cast<size_t>(n);
+    }
+    conn.output.erase(0, sent);
+    return true;
+  }
+
+  // Reads all the socket has. False when the connection is broken.
+  bool receive_input(connection& conn)
+  {
+    char buffer[1 << 16];
+    while (true)
+    {
+      const ssize_t n = recv(conn.fd, buffer, sizeof(buffer), 0);
+      if (n > 0)
+      {
+        conn.input.append(buffer, static_cast<size_t>(n));
+        continue;
+      }
+      if (n == 0)
+      {
+        conn.eof = true;
+        return true;
+      }
+      if (errno == EINTR) continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+  }
+
+  // The event loop's side of a connection: sends, receives, and hands complete lines to the predictors.
+  void handle(connection& conn, uint32_t events)
+  {
+    if ((events & EPOLLERR) != 0 || conn.failed || !send_output(conn))
+    {
+      close_connection(conn);
+      return;
+    }
+    if (!conn.eof && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) != 0 && !receive_input(conn))
+    {
+      close_connection(conn);
+      return;
+    }
+    const bool has_lines = conn.input.find('\n') != std::string::npos || (conn.eof && !conn.input.empty());
+    if (has_lines)
+    {
+      work.push(&conn);
+      return;
+    }
+    if (conn.eof && conn.output.empty())
+    {
+      close_connection(conn);
+      return;
+    }
+    arm(conn, (conn.eof ? 0 : EPOLLIN) | (conn.output.empty() ? 0 : EPOLLOUT));
+  }
+
+  // The predictor's side of a connection: predicts all complete lines, and the last one once the client is done.
+  void predict(predictor& p, connection& conn)
+  {
+    size_t begin = 0;
+    try
+    {
+      while (begin < conn.input.size())
+      {
+        size_t end = conn.input.find('\n', begin);
+        if (end == std::string::npos)
+        {
+          if (!conn.eof) break;
+          end = conn.input.size();
+        }
+        if (end > begin)
+        {
+          predict_line(p, VW::string_view(conn.input.data() + begin, end - begin));
+          conn.output.append(p.predictions->begin(), p.predictions->end());
+          p.predictions->clear();
+        }
+        begin = end + 1;
+      }
+    }
+    catch (const std::exception& e)
+    {
+      logger::errlog_error("Closing a connection after failing to predict: {}", e.what());
+      conn.failed = true;
+    }
+    conn.input.erase(0, std::min(begin, conn.input.size()));
+    // Reported right away when the output fits into the socket, so the loop sends it.
+    arm(conn, EPOLLIN | EPOLLOUT);
+  }
+
+  void run_predictor(predictor& p)
+  {
+    while (connection* conn = work.pop())
+    {
+      try
+      {
+        predict(p, *conn);
+      }
+      catch (const std::exception& e)
+      {
+        // Only arming can fail here, the connection stays open until the server stops.
+        logger::errlog_error("Lost a connection: {}", e.what());
+      }
+    }
+  }
+
+  int listen_socket;
+  int epoll = -1;
+  int wakeup = -1;
+  std::vector<predictor> predictors;
+  std::unordered_map<int, std::unique_ptr<connection>> connections;
+  VW::ptr_queue<connection> work;
+#endif
+};
+
+#ifdef __linux__
+prediction_server::prediction_server(vw& model, int listen_socket, size_t num_threads)
+    : _state(new prediction_server_state(model, listen_socket, num_threads))
+{
+}
+
+prediction_server::~prediction_server() = default;
+
+void prediction_server::run()
+{
+  auto& state = *_state;
+  const int flags = fcntl(state.listen_socket, F_GETFL, 0);
+  if (flags < 0 || fcntl(state.listen_socket, F_SETFL, flags | O_NONBLOCK) < 0) THROWERRNO("fcntl");
+  state.watch(state.listen_socket, &state.listen_socket);
+  state.watch(state.wakeup, &state.wakeup);
+
+  std::vector<std::thread> threads;
+  for (auto& p : state.predictors)
+  {
+    threads.emplace_back([&state, &p] { state.run_predictor(p); });
+  }
+
+  std::exception_ptr error;
+  try
+  {
+    epoll_event events[64];
+    bool stopping = false;
+    while (!stopping)
+    {
+      const int n = epoll_wait(state.epoll, events, 64, -1);
+      if (n < 0)
+      {
+        if (errno == EINTR) continue;
+        THROWERRNO("epoll_wait");
+      }
+      for (int i = 0; i < n; i++)
+      {
+        void* data = events[i].data.ptr;
+        if (data == &state.listen_socket) { state.accept_connections(); }
+        else if (data == &state.wakeup)
+        {
+          stopping = true;
+        }
+        else
+        {
+          state.handle(*static_cast<connection*>(data), events[i].events);
+        }
+      }
+    }
+  }
+  catch (...)
+  {
+    error = std::current_exception();
+  }
+
+  // Predictions under way are finished, but nobody sends them anymore.
+  state.work.set_done();
+  for (auto& thread : threads) { thread.join(); }
+  for (auto& entry : state.connections) { close_socket(entry.first); }
+  state.connections.clear();
+  epoll_ctl(state.epoll, EPOLL_CTL_DEL, state.listen_socket, nullptr);
+  if (error) { std::rethrow_exception(error); }
+}
+
+void prediction_server::stop()
+{
+  // write() is async signal safe.
+  const uint64_t one = 1;
+  while (write(_state->wakeup, &one, sizeof(one)) < 0 && errno == EINTR) {}
+}
+
+namespace
+{
+std::atomic<prediction_server*> serving(nullptr);
+
+void stop_serving(int)
+{
+  prediction_server* server = serving.load();
+  if (server != nullptr) { server->stop(); }
+}
+}  // namespace
+
+void serve_predictions(vw& all)
+{
+  prediction_server server(all, all.example_parser->bound_sock, all.predict_threads);
+  serving.store(&server);
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = stop_serving;
+  sigaction(SIGTERM, &sa, nullptr);
+  try
+  {
+    server.run();
+  }
+  catch (...)
+  {
+    serving.store(nullptr);
+    throw;
+  }
+  serving.store(nullptr);
+}
+#else
+prediction_server::prediction_server(vw&, int, size_t) { THROW("The prediction server is only supported on Linux"); }
+
+prediction_server::~prediction_server() = default;
+
+void prediction_server::run() {}
+
+void prediction_server::stop() {}
+
+void serve_predictions(vw&) { THROW("--predict_threads is only supported on Linux"); }
+#endif
+}  // namespace VW
@@ -0,0 +1,48 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+struct vw;
+
+namespace VW
+{
+struct prediction_server_state;
+
+// Serves predictions of one model to many connections from a single process (--daemon with --predict_threads). One
+// thread runs an epoll loop which accepts connections, reads what clients send and writes back what was predicted for
+// them. Complete lines are handed to a pool of predictor threads, each a vw instance of its own with its own example
+// pool, reduction state and shared_data, but all seeded from the same model so that the weights are loaded once and
+// only ever read. A connection is with at most one predictor at a time, which keeps its predictions in order, and a
+// slow client only holds up its own connection.
+//
+// Speaks the text protocol of daemon mode: one example per line, one prediction line back, the model never learns.
+// Reductions taking multi line examples are not supported. Linux only.
+class prediction_server
+{
+public:
+  // Serves the connections to listen_socket, which must be bound and listening already, with num_threads predictor
+  // threads. Sets up the predictors right away, model must outlive the server.
+  prediction_server(vw& model, int listen_socket, size_t num_threads);
+  prediction_server(const prediction_server&) = delete;
+  prediction_server& operator=(const prediction_server&) = delete;
+  ~prediction_server();
+
+  // Runs the event loop on the calling thread until stop() is called, then closes all connections.
+  void run();
+
+  // Makes run() return, from any thread or from a signal handler.
+  void stop();
+
+private:
+  std::unique_ptr<prediction_server_state> _state;
+};
+
+// Runs the prediction server on the socket parse_sources bound for --daemon until SIGTERM. Takes the place of
+// start_parser, generic_driver and end_parser.
+void serve_predictions(vw& all);
+}  // namespace VW
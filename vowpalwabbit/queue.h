@@ -4,7 +4,9 @@
 
 #pragma once
 
-#include <queue>
+#include "lock_free_ring.h"
+
+#include <atomic>
 
 // Mutex and CV cannot be used in managed C++, tell the compiler that this is unmanaged even if included in a managed
 // project.
@@ -13,68 +15,107 @@
 #  undef _M_CEE
 #  include <mutex>
 #  include <condition_variable>
+#  include <thread>
 #  define _M_CEE 001
 #  pragma managed(pop)
 #else
 #  include <mutex>
 #  include <condition_variable>
+#  include <thread>
 #endif
 
 namespace VW
 {
+// Bounded queue handing pointers from one thread to another, used between the parser and the learner. Items travel
+// through a lock_free_ring so neither side takes a lock while the queue is neither full nor empty. A side that cannot
+// make progress spins for a little while and then parks on a condition variable; the other side only touches the mutex
+// when it sees someone parked.
 template <typename T>
 class ptr_queue
 {
 public:
-  ptr_queue(size_t max_size) : max_size(max_size) {}
+  ptr_queue(size_t max_size) : _ring(max_size) {}
 
+  // Blocks until an item is available. Returns nullptr once set_done was called and the queue is drained.
   T* pop()
   {
-    std::unique_lock<std::mutex> lock(mut);
-    while (object_queue.size() == 0 && !done) { is_not_empty.wait(lock); }
-
-    if (done && object_queue.size() == 0) { return nullptr; }
-
-    auto item = object_queue.front();
-    object_queue.pop();
-
-    is_not_full.notify_all();
+    T* item = nullptr;
+    wait_until(_waiting_consumers, _is_not_empty,
+        [this, &item]() { return _ring.try_pop(item) || _done.load(std::memory_order_acquire); });
+    if (item != nullptr) { wake(_waiting_producers, _is_not_full); }
     return item;
   }
 
+  // Blocks while the queue is full.
   void push(T* item)
   {
-    std::unique_lock<std::mutex> lock(mut);
-    while (object_queue.size() == max_size) { is_not_full.wait(lock); }
-    object_queue.push(item);
+    wait_until(_waiting_producers, _is_not_full, [this, item]() { return _ring.try_push(item); });
+    wake(_waiting_consumers, _is_not_empty);
+  }
 
-    is_not_empty.notify_all();
+  // Blocks while the queue is full, or until set_done while has_room returns false. has_room is checked again after
+  // every pop, so it must only turn true through something the consumer does before it pops.
+  template <typename HasRoomFn>
+  void push_when(T* item, HasRoomFn&& has_room)
+  {
+    wait_until(_waiting_producers, _is_not_full, [this, item, &has_room]() {
+      return (_done.load(std::memory_order_acquire) || has_room()) && _ring.try_push(item);
+    });
+    wake(_waiting_consumers, _is_not_empty);
   }
 
   void set_done()
   {
+    _done.store(true, std::memory_order_release);
     {
-      std::unique_lock<std::mutex> lock(mut);
-      done = true;
+      std::lock_guard<std::mutex> lock(_mut);
     }
-    is_not_empty.notify_all();
-    is_not_full.notify_all();
+    _is_not_empty.notify_all();
+    _is_not_full.notify_all();
   }
 
-  size_t size() const
+  size_t size() const { return _ring.size(); }
+
+private:
+  // Attempts made before parking. A handful of retries covers the common case of the other side being mid operation.
+  static constexpr size_t spin_attempts = 64;
+
+  template <typename AttemptFn>
+  void wait_until(std::atomic<size_t>& waiters, std::condition_variable& cv, AttemptFn&& attempt)
   {
-    std::unique_lock<std::mutex> lock(mut);
-    return object_queue.size();
+    for (size_t i = 0; i < spin_attempts; i++)
+    {
+      if (attempt()) { return; }
+      std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(_mut);
+    waiters.fetch_add(1, std::memory_order_relaxed);
+    // Pairs with the fence in wake(): either attempt() sees the other side's progress or wake() sees this waiter.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!attempt()) { cv.wait(lock); }
+    waiters.fetch_sub(1, std::memory_order_relaxed);
   }
 
-private:
-  size_t max_size;
-  std::queue<T*> object_queue;
-  mutable std::mutex mut;
+  void wake(std::atomic<size_t>& waiters, std::condition_variable& cv)
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) == 0) { return; }
+    {
+      // A waiter holds the mutex from its last attempt until it is inside wait(), so taking it here means the
+      // notification cannot be lost.
+      std::lock_guard<std::mutex> lock(_mut);
+    }
+    cv.notify_all();
+  }
 
-  volatile bool done = false;
+  lock_free_ring<T*> _ring;
+  std::atomic<bool> _done{false};
 
-  std::condition_variable is_not_full;
-  std::condition_variable is_not_empty;
+  std::atomic<size_t> _waiting_producers{0};
+  std::atomic<size_t> _waiting_consumers{0};
+  std::mutex _mut;
+  std::condition_variable _is_not_full;
+  std::condition_variable _is_not_empty;
 };
 }  // namespace VW
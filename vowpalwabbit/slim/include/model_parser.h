@@ -2,10 +2,14 @@
 
 #include <memory>
 #include <cctype>
+#include <cstring>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "vw_slim_return_codes.h"
 #include "hash.h"
+#include "quantized_weights.h"
 
 // #define MODEL_PARSER_DEBUG
 
@@ -35,6 +39,14 @@ public:
 
   uint32_t checksum();
 
+  bool at_end() const { return _model == _model_end; }
+
+  // True if the model goes on with the bytes given.
+  bool starts_with(const char* bytes, size_t length) const
+  {
+    return static_cast<size_t>(_model_end - _model) >= length && memcmp(_model, bytes, length) == 0;
+  }
+
   template <bool compute_checksum>
   int read_string(const char* field_name, std::string& s)
   {
@@ -120,15 +132,44 @@ public:
     return S_VW_PREDICT_OK;
   }
 
+  template <typename T>
+  int read_weights(std::vector<std::pair<uint64_t, float>>& weights, uint64_t weight_length)
+  {
+    while (_model < _model_end)
+    {
+      std::pair<uint64_t, float> weight;
+      T idx;
+      RETURN_ON_FAIL((read<T, false>("gd.weight.index", idx)));
+      if (idx > weight_length) return E_VW_PREDICT_ERR_WEIGHT_INDEX_OUT_OF_RANGE;
+      weight.first = idx;
+      RETURN_ON_FAIL((read<float, false>("gd.weight.value", weight.second)));
+      weights.push_back(weight);
+    }
+
+    return S_VW_PREDICT_OK;
+  }
+
+  // The quantization is only for W = quantized_weights.
   template <typename W>
-  int read_weights(std::unique_ptr<W>& weights, uint32_t num_bits, uint32_t stride_shift)
+  int read_weights(std::unique_ptr<W>& weights, uint32_t num_bits, uint32_t stride_shift,
+      weight_quantization /* quantization */ = weight_quantization::int8)
   {
     uint64_t weight_length = (uint64_t)1 << num_bits;
 
     weights = std::unique_ptr<W>(new W(weight_length));
     weights->stride_shift(stride_shift);
 
-    if (num_bits < 31) { RETURN_ON_FAIL((read_weights<uint32_t, W>(weights, weight_length))); }
+    if (starts_with(quantized_weights::model_magic, sizeof(quantized_weights::model_magic)))
+    {
+      // a model quantized by quantize_model, expanded to floats
+      quantized_weights quantized(weight_length);
+      RETURN_ON_FAIL(quantized.read(*this));
+      quantized.for_each([&weights](uint64_t index, float value) { (*weights)[index] = value; });
+    }
+    else if (num_bits < 31)
+    {
+      RETURN_ON_FAIL((read_weights<uint32_t, W>(weights, weight_length)));
+    }
     else
     {
       RETURN_ON_FAIL((read_weights<uint64_t, W>(weights, weight_length)));
@@ -136,5 +177,28 @@ public:
 
     return S_VW_PREDICT_OK;
   }
+
+  // Weights of a model quantized by quantize_model are read as they are, those saved by vw are quantized as asked.
+  int read_weights(std::unique_ptr<quantized_weights>& weights, uint32_t num_bits, uint32_t stride_shift,
+      weight_quantization quantization = weight_quantization::int8)
+  {
+    uint64_t weight_length = (uint64_t)1 << num_bits;
+
+    weights = std::unique_ptr<quantized_weights>(new quantized_weights(weight_length, quantization));
+    weights->stride_shift(stride_shift);
+
+    if (starts_with(quantized_weights::model_magic, sizeof(quantized_weights::model_magic)))
+      return weights->read(*this);
+
+    std::vector<std::pair<uint64_t, float>> float_weights;
+    if (num_bits < 31) { RETURN_ON_FAIL(read_weights<uint32_t>(float_weights, weight_length)); }
+    else
+    {
+      RETURN_ON_FAIL(read_weights<uint64_t>(float_weights, weight_length));
+    }
+    weights->quantize(std::move(float_weights));
+
+    return S_VW_PREDICT_OK;
+  }
 };
 }  // namespace vw_slim
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#  include <intrin.h>
+#endif
+
+namespace vw_slim
+{
+class model_parser;
+
+/**
+ * @brief How quantized_weights stores a weight.
+ */
+enum class weight_quantization : uint8_t
+{
+  int8 = 1,  // 1 byte, 127 being the largest weight of its group
+  fp16 = 2   // 2 bytes, a half precision float relative to the largest weight of its group
+};
+
+namespace internal
+{
+inline uint32_t popcount(uint64_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<uint32_t>(__builtin_popcountll(bits));
+#elif defined(_MSC_VER) && defined(_M_X64)
+  return static_cast<uint32_t>(__popcnt64(bits));
+#else
+  bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+  bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+  bits = (bits + (bits >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return static_cast<uint32_t>((bits * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+inline float half_to_float(uint16_t half)
+{
+  const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  const uint32_t exponent = (half >> 10) & 0x1f;
+  const uint32_t mantissa = half & 0x3ff;
+  if (exponent == 0)
+  {
+    // zero or subnormal: mantissa * 2^-24
+    const float value = static_cast<float>(mantissa) * (1.f / 16777216.f);
+    return sign != 0 ? -value : value;
+  }
+  // rebias the exponent from 15 to 127, all ones stays all ones for infinities and NaNs
+  const uint32_t bits = sign | (exponent == 0x1f ? 0x7f800000 : (exponent + 112) << 23) | (mantissa << 13);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+uint16_t float_to_half(float value);
+}  // namespace internal
+
+/**
+ * @brief Weights for vw_predict<quantized_weights> in 1 or 2 bytes each instead of 4, keeping only the non-zero ones.
+ *
+ * Weights are stored in the order of their indices, in groups of 64 that share a scale. Which indices hold a weight is
+ * kept as a bit per index in blocks of 64 indices, together with the position of the first weight of the block: the
+ * weight of an index is found by counting the bits before it. The blocks take 0.25 bytes per index, instead of 4 bytes
+ * per index for dense_parameters. Where that is more than a hash table of the blocks holding weights, as for a few
+ * weights among 2^32 indices, the blocks are looked up in such a table instead.
+ *
+ * GD::inline_predict reads the weights through operator[] directly, without expanding them to floats.
+ *
+ * Models quantized by quantize_model store the weights the same way, only with the index of each weight as the
+ * distance to the one before. Models saved by vw are quantized when loaded.
+ */
+class quantized_weights
+{
+public:
+  static constexpr size_t block_weights = 64;
+  static constexpr size_t group_weights = 64;
+  // Marks the weights of a model quantized by quantize_model. An index of a weight saved by vw never starts with it.
+  static const char model_magic[8];
+
+  explicit quantized_weights(size_t length, weight_quantization quantization = weight_quantization::int8);
+
+  inline float operator[](size_t i) const
+  {
+    i &= _weight_mask;
+    const block* b = find_block(i / block_weights);
+    const uint64_t bit = static_cast<uint64_t>(1) << (i % block_weights);
+    if (b == nullptr || (b->present & bit) == 0) return 0.f;
+    const size_t position = b->first + internal::popcount(b->present & (bit - 1));
+    const float scale = _scales[position / group_weights];
+    if (_quantization == weight_quantization::int8) return scale * static_cast<float>(_int8_values[position]);
+    return scale * internal::half_to_float(_fp16_values[position]);
+  }
+
+  uint64_t mask() const { return _weight_mask; }
+
+  uint32_t stride_shift() const { return _stride_shift; }
+
+  void stride_shift(uint32_t stride_shift) { _stride_shift = stride_shift; }
+
+  weight_quantization quantization() const { return _quantization; }
+
+  // Number of weights stored.
+  size_t size() const { return _int8_values.size() + _fp16_values.size(); }
+
+  // Bytes taken by the weights, the blocks and the scales.
+  size_t memory_bytes() const
+  {
+    return _blocks.size() * sizeof(block) + _hashed_blocks.size() * sizeof(hashed_block) +
+        _scales.size() * sizeof(float) + _int8_values.size() * sizeof(int8_t) + _fp16_values.size() * sizeof(uint16_t);
+  }
+
+  // Largest difference between a weight and its quantized value, 0 if the weights were read quantized.
+  float max_error() const { return _max_error; }
+
+  // Replaces the weights by the (index, value) pairs quantized. For a repeated index, the last value counts.
+  void quantize(std::vector<std::pair<uint64_t, float>> weights);
+
+  // Calls f(index, value) for the weights in the order of their indices.
+  template <typename F>
+  void for_each(F f) const
+  {
+    for_each_position([this, &f](uint64_t index, size_t) { f(index, (*this)[index]); });
+  }
+
+  // Reads the weights as written by write, see quantize_model.
+  int read(model_parser& mp);
+
+  // Appends model_magic and the weights to out.
+  void write(std::vector<char>& out) const;
+
+private:
+  struct block
+  {
+    uint64_t present;  // bit i is set if index i of the block holds a weight
+    uint64_t first;    // position of the first weight of the block
+  };
+
+  struct hashed_block
+  {
+    uint64_t key;  // number of the block + 1, 0 for an empty slot
+    block value;
+  };
+
+  inline const block* find_block(uint64_t number) const
+  {
+    if (!_hashed) return &_blocks[number];
+    for (size_t slot = hash_block(number);; slot = (slot + 1) & (_hashed_blocks.size() - 1))
+    {
+      const hashed_block& entry = _hashed_blocks[slot];
+      if (entry.key == number + 1) return &entry.value;
+      if (entry.key == 0) return nullptr;
+    }
+  }
+
+  inline size_t hash_block(uint64_t number) const
+  {
+    return static_cast<size_t>((number * 0x9e3779b97f4a7c15ULL) >> _hash_shift);
+  }
+
+  void clear();
+
+  // Sets up the blocks for weights at indices, which come in increasing order.
+  void index(const std::vector<uint64_t>& indices);
+
+  // Calls f(index, position) for the weights in the order of their indices.
+  template <typename F>
+  void for_each_position(F f) const
+  {
+    std::vector<std::pair<uint64_t, block>> blocks;
+    if (_hashed)
+    {
+      for (const auto& entry : _hashed_blocks)
+        if (entry.key != 0) blocks.emplace_back(entry.key - 1, entry.value);
+      std::sort(blocks.begin(), blocks.end(),
+          [](const std::pair<uint64_t, block>& a, const std::pair<uint64_t, block>& b) { return a.first < b.first; });
+    }
+    else
+    {
+      for (size_t number = 0; number < _blocks.size(); number++)
+        if (_blocks[number].present != 0) blocks.emplace_back(number, _blocks[number]);
+    }
+
+    for (const auto& b : blocks)
+    {
+      size_t position = b.second.first;
+      for (uint64_t present = b.second.present; present != 0; present &= present - 1, position++)
+        f(b.first * block_weights + internal::popcount((present & (~present + 1)) - 1), position);
+    }
+  }
+
+  std::vector<block> _blocks;
+  std::vector<hashed_block> _hashed_blocks;
+  bool _hashed;
+  uint32_t _hash_shift;
+  std::vector<float> _scales;
+  std::vector<int8_t> _int8_values;
+  std::vector<uint16_t> _fp16_values;
+  uint64_t _weight_mask;
+  uint32_t _stride_shift;
+  weight_quantization _quantization;
+  float _max_error;
+};
+}  // namespace vw_slim
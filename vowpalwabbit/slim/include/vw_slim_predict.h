@@ -14,6 +14,7 @@
 #include "model_parser.h"
 #include "opts.h"
 #include "interactions.h"
+#include "quantized_weights.h"
 
 namespace vw_slim
 {
@@ -187,6 +188,8 @@ class namespace_copy_guard
   example_predict& _ex;
   unsigned char _ns;
   bool _remove_ns;
+  size_t _old_size;
+  float _old_sum_feat_sq;
 
 public:
   namespace_copy_guard(example_predict& ex, unsigned char ns);
@@ -215,8 +218,25 @@ public:
   ~stride_shift_guard();
 };
 
+/**
+ * @brief Rewrites a model saved by vw with its weights quantized, for vw_predict<quantized_weights> and to take less
+ * space. The weights of the quantized model take 1 (int8) or 2 (fp16) bytes each and their indices about 1 byte when
+ * they are dense, instead of 8 bytes for each weight saved by vw. Any vw_predict loads the quantized model.
+ *
+ * @param model The binary model.
+ * @param length The length of the binary model.
+ * @param quantization How to store the weights.
+ * @param out The quantized model.
+ * @param max_error If given, set to the largest difference between a weight and its quantized value.
+ * @return int Returns 0 (S_VW_PREDICT_OK) if succesful, otherwise one of the error codes (see E_VW_PREDICT_ERR_*).
+ */
+int quantize_model(const char* model, size_t length, weight_quantization quantization, std::vector<char>& out,
+    float* max_error = nullptr);
+
 /**
  * @brief Vowpal Wabbit slim predictor. Supports: regression, multi-class classification and contextual bandits.
+ *
+ * W holds the weights: dense_parameters, sparse_parameters or quantized_weights.
  */
 template <typename W>
 class vw_predict
@@ -241,8 +261,116 @@ class vw_predict
   uint32_t _stride_shift;
   bool _model_loaded;
 
+  weight_quantization _quantization;
+  size_t _weights_offset;
+
+  // A namespace of an action before predict_batch copied the shared features into it.
+  struct copied_namespace
+  {
+    namespace_index ns;
+    bool added;  // the action did not have the namespace
+    size_t size;
+    float sum_feat_sq;
+  };
+
+  // Scratch of predict_batch, kept between calls.
+  v_array<namespace_index> _batch_namespaces;
+  std::array<bool, NUM_NAMESPACES> _batch_namespace_seen;
+  std::vector<copied_namespace> _copied_namespaces;
+
+  friend int quantize_model(const char*, size_t, weight_quantization, std::vector<char>&, float*);
+
+  // Adds the namespaces of ex to those of the batch, see batch_interactions.
+  void see_namespaces(const example_predict& ex)
+  {
+    for (auto ns : ex.indices)
+    {
+      if (_batch_namespace_seen[ns]) continue;
+      _batch_namespace_seen[ns] = true;
+      _batch_namespaces.push_back(ns);
+    }
+  }
+
+  // The interactions of a batch, with wildcards expanded once for the namespaces of all its examples where predict
+  // does it for every example. Interactions of namespaces an example lacks add nothing to its score.
+  const std::vector<std::vector<namespace_index>>& batch_interactions()
+  {
+    if (!_contains_wildcard) return _interactions;
+
+    if (!_no_constant && !_batch_namespace_seen[constant_namespace]) _batch_namespaces.push_back(constant_namespace);
+    // permutations is not supported by slim so we can just use combinations!
+    _generate_interactions.update_interactions_if_new_namespace_seen<
+        INTERACTIONS::generate_namespace_combinations_with_repetition, false>(_interactions, _batch_namespaces);
+
+    for (auto ns : _batch_namespaces) _batch_namespace_seen[ns] = false;
+    _batch_namespaces.clear_noshrink();
+    return _generate_interactions.generated_interactions;
+  }
+
+  // Prefetches the weights of the features of ex. predict_batch does it for the next example before scoring one, so
+  // that the lookups of the next example are on their way while those of the current one are done.
+  void prefetch(const example_predict& ex) const
+  {
+    for (auto ns : ex.indices)
+    {
+      const features* fs = ex.feature_space.find(ns);
+      if (fs == nullptr) continue;
+      for (auto index : fs->indicies) INTERACTIONS::prefetch_weight(*_weights, index + ex.ft_offset);
+    }
+  }
+
+  // Scores ex as predict does, with the interactions of its batch.
+  float predict_batch_example(example_predict& ex, const std::vector<std::vector<namespace_index>>& interactions)
+  {
+    if (_no_constant)
+      return GD::inline_predict<W>(*_weights, false, _ignore_linear, interactions, /* permutations */ false, ex);
+
+    // add constant feature
+    namespace_copy_guard constant_guard(ex, constant_namespace);
+    constant_guard.feature_push_back(1.f, (constant << _stride_shift) + ex.ft_offset);
+    return GD::inline_predict<W>(*_weights, false, _ignore_linear, interactions, /* permutations */ false, ex);
+  }
+
+  // Copies the features of shared into action, as predict(shared, actions, ...) does, without allocating guards.
+  void copy_shared(const example_predict& shared, example_predict& action)
+  {
+    _copied_namespaces.clear();
+    for (auto ns : shared.indices)
+    {
+      features& fs = action.feature_space[ns];
+      const bool added = std::find(action.indices.begin(), action.indices.end(), ns) == action.indices.end();
+      _copied_namespaces.push_back({ns, added, fs.size(), fs.sum_feat_sq});
+      if (added) action.indices.push_back(ns);
+
+      const features& shared_fs = shared.feature_space[ns];
+      for (size_t i = 0; i < shared_fs.size(); i++) fs.push_back(shared_fs.values[i], shared_fs.indicies[i]);
+    }
+  }
+
+  // Takes the features copied by copy_shared out of action again.
+  void remove_shared(example_predict& action)
+  {
+    for (auto it = _copied_namespaces.rbegin(); it != _copied_namespaces.rend(); ++it)
+    {
+      features& fs = action.feature_space[it->ns];
+      fs.truncate_to(it->size);
+      fs.sum_feat_sq = it->sum_feat_sq;
+      if (it->added) action.indices.pop_back();
+    }
+  }
+
 public:
-  vw_predict() : _model_loaded(false), _contains_wildcard(false) {}
+  vw_predict()
+      : _model_loaded(false), _contains_wildcard(false), _quantization(weight_quantization::int8), _weights_offset(0)
+  {
+    _batch_namespace_seen.fill(false);
+  }
+
+  /**
+   * @brief How vw_predict<quantized_weights> quantizes the weights of models saved by vw when loading them, int8 by
+   * default. Models quantized by quantize_model are loaded as they are.
+   */
+  void quantize_on_load(weight_quantization quantization) { _quantization = quantization; }
 
   /**
    * @brief Reads the Vowpal Wabbit model from the supplied buffer (produced using vw -f <modelname>)
@@ -372,7 +500,8 @@ public:
     uint64_t weight_length = (uint64_t)1 << _num_bits;
     _stride_shift = (uint32_t)ceil_log_2(num_weights);
 
-    RETURN_ON_FAIL(mp.read_weights<W>(_weights, _num_bits, _stride_shift));
+    _weights_offset = mp.position() - model;
+    RETURN_ON_FAIL(mp.read_weights(_weights, _num_bits, _stride_shift, _quantization));
 
     // TODO: check that permutations is not enabled (or parse it)
 
@@ -468,6 +597,86 @@ public:
     return S_VW_PREDICT_OK;
   }
 
+  /**
+   * @brief Predicts scores (as in regression) for many examples at once, the same as predict(ex, score) does for each.
+   *
+   * Meant for scoring hundreds of candidates in one call: wildcard interactions are expanded once for the batch, no
+   * memory is allocated once the scratch buffers grew to the size of the batches, and the weights of the next example
+   * are prefetched before one is scored.
+   *
+   * @param examples The examples to get the predictions for.
+   * @param num_examples The number of examples.
+   * @param out_scores The output scores, one per example.
+   * @return int Returns 0 (S_VW_PREDICT_OK) if succesful, otherwise one of the error codes (see E_VW_PREDICT_ERR_*).
+   */
+  int predict_batch(example_predict* examples, size_t num_examples, std::vector<float>& out_scores)
+  {
+    if (!_model_loaded) return E_VW_PREDICT_ERR_NO_MODEL_LOADED;
+
+    if (_contains_wildcard)
+      for (size_t i = 0; i < num_examples; i++) see_namespaces(examples[i]);
+    const auto& interactions = batch_interactions();
+
+    out_scores.resize(num_examples);
+    for (size_t i = 0; i < num_examples; i++)
+    {
+      if (i + 1 < num_examples) prefetch(examples[i + 1]);
+      out_scores[i] = predict_batch_example(examples[i], interactions);
+    }
+
+    return S_VW_PREDICT_OK;
+  }
+
+  /**
+   * @brief Predicts the scores of the actions of many action sets at once (multiclass classification), the same as
+   * predict(shared, actions, num_actions, out_scores) does for each. See predict_batch(examples, ...).
+   *
+   * @param shared The shared example of each action set.
+   * @param actions The actions of each action set.
+   * @param num_actions The number of actions of each action set.
+   * @param num_sets The number of action sets.
+   * @param out_scores The output scores of the actions of each action set.
+   * @return int Returns 0 (S_VW_PREDICT_OK) if succesful, otherwise one of the error codes (see E_VW_PREDICT_ERR_*).
+   */
+  int predict_batch(example_predict* shared, example_predict* const* actions, const size_t* num_actions,
+      size_t num_sets, std::vector<std::vector<float>>& out_scores)
+  {
+    if (!_model_loaded) return E_VW_PREDICT_ERR_NO_MODEL_LOADED;
+
+    if (!is_csoaa_ldf()) return E_VW_PREDICT_ERR_NO_A_CSOAA_MODEL;
+
+    if (_contains_wildcard)
+      for (size_t set = 0; set < num_sets; set++)
+      {
+        see_namespaces(shared[set]);
+        for (size_t i = 0; i < num_actions[set]; i++) see_namespaces(actions[set][i]);
+      }
+    const auto& interactions = batch_interactions();
+
+    out_scores.resize(num_sets);
+    for (size_t set = 0; set < num_sets; set++)
+    {
+      out_scores[set].resize(num_actions[set]);
+      for (size_t i = 0; i < num_actions[set]; i++)
+      {
+        // the next action, in this action set or in the next one
+        if (i + 1 < num_actions[set]) prefetch(actions[set][i + 1]);
+        else if (set + 1 < num_sets)
+        {
+          prefetch(shared[set + 1]);
+          if (num_actions[set + 1] > 0) prefetch(actions[set + 1][0]);
+        }
+
+        example_predict& action = actions[set][i];
+        copy_shared(shared[set], action);
+        out_scores[set][i] = predict_batch_example(action, interactions);
+        remove_shared(action);
+      }
+    }
+
+    return S_VW_PREDICT_OK;
+  }
+
   int predict(const char* event_id, example_predict& shared, example_predict* actions, size_t num_actions,
       std::vector<float>& pdf, std::vector<int>& ranking)
   {
@@ -594,5 +803,10 @@ public:
   }
 
   uint32_t feature_index_num_bits() { return _num_bits; }
+
+  /**
+   * @brief The weights of the model loaded.
+   */
+  const W& weights() const { return *_weights; }
 };
 }  // namespace vw_slim
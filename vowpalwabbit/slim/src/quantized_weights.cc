@@ -0,0 +1,249 @@
+#include "quantized_weights.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "model_parser.h"
+
+namespace vw_slim
+{
+namespace internal
+{
+uint16_t float_to_half(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+  bits &= 0x7fffffff;
+
+  if (bits > 0x7f800000) return sign | 0x7e00;  // NaN
+  if (bits >= 0x477ff000) return sign | 0x7c00;  // rounds to more than 65504, infinity
+  if (bits < 0x38800000)
+  {
+    // below the smallest normal half, exact in float after scaling by 2^24
+    float magnitude;
+    memcpy(&magnitude, &bits, sizeof(magnitude));
+    return sign | static_cast<uint16_t>(std::nearbyint(magnitude * 16777216.f));
+  }
+
+  // rebias the exponent from 127 to 15 and round the mantissa to 10 bits, to even on ties
+  uint32_t half = (bits - 0x38000000) >> 13;
+  const uint32_t rest = bits & 0x1fff;
+  if (rest > 0x1000 || (rest == 0x1000 && (half & 1) != 0)) half++;
+  return sign | static_cast<uint16_t>(half);
+}
+}  // namespace internal
+
+namespace
+{
+int read_varint(model_parser& mp, uint64_t& value)
+{
+  value = 0;
+  for (uint32_t shift = 0; shift < 64; shift += 7)
+  {
+    uint8_t byte;
+    RETURN_ON_FAIL((mp.read<uint8_t, false>("quantized.index", byte)));
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return S_VW_PREDICT_OK;
+  }
+  return E_VW_PREDICT_ERR_INVALID_MODEL;
+}
+
+void write_varint(std::vector<char>& out, uint64_t value)
+{
+  for (; value >= 0x80; value >>= 7) out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+  out.push_back(static_cast<char>(value));
+}
+
+template <typename T>
+void write_bytes(std::vector<char>& out, const T& value)
+{
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+}  // namespace
+
+constexpr size_t quantized_weights::block_weights;
+constexpr size_t quantized_weights::group_weights;
+const char quantized_weights::model_magic[8] = {'V', 'W', 'Q', 'U', 'A', 'N', 'T', '1'};
+
+quantized_weights::quantized_weights(size_t length, weight_quantization quantization)
+    : _hashed(false)
+    , _hash_shift(0)
+    , _weight_mask(length - 1)
+    , _stride_shift(0)
+    , _quantization(quantization)
+    , _max_error(0.f)
+{
+  clear();
+}
+
+void quantized_weights::clear()
+{
+  _scales.clear();
+  _int8_values.clear();
+  _fp16_values.clear();
+  _max_error = 0.f;
+  index(std::vector<uint64_t>());
+}
+
+void quantized_weights::index(const std::vector<uint64_t>& indices)
+{
+  size_t used_blocks = 0;
+  for (size_t i = 0; i < indices.size(); i++)
+    if (i == 0 || indices[i] / block_weights != indices[i - 1] / block_weights) used_blocks++;
+
+  // at most half full
+  size_t slots = 2;
+  _hash_shift = 63;
+  while (slots < 2 * used_blocks)
+  {
+    slots *= 2;
+    _hash_shift--;
+  }
+
+  const uint64_t num_blocks = _weight_mask / block_weights + 1;
+  _hashed = num_blocks * sizeof(block) > slots * sizeof(hashed_block);
+  _blocks.assign(_hashed ? 0 : num_blocks, block{0, 0});
+  _hashed_blocks.assign(_hashed ? slots : 0, hashed_block{0, block{0, 0}});
+
+  for (size_t position = 0; position < indices.size(); position++)
+  {
+    const uint64_t number = indices[position] / block_weights;
+    block* b;
+    if (_hashed)
+    {
+      size_t slot = hash_block(number);
+      while (_hashed_blocks[slot].key != 0 && _hashed_blocks[slot].key != number + 1)
+        slot = (slot + 1) & (slots - 1);
+      _hashed_blocks[slot].key = number + 1;
+      b = &_hashed_blocks[slot].value;
+    }
+    else
+      b = &_blocks[number];
+
+    if (b->present == 0) b->first = position;
+    b->present |= static_cast<uint64_t>(1) << (indices[position] % block_weights);
+  }
+}
+
+void quantized_weights::quantize(std::vector<std::pair<uint64_t, float>> weights)
+{
+  clear();
+
+  for (auto& weight : weights) weight.first &= _weight_mask;
+  std::stable_sort(weights.begin(), weights.end(),
+      [](const std::pair<uint64_t, float>& a, const std::pair<uint64_t, float>& b) { return a.first < b.first; });
+  size_t kept = 0;
+  for (const auto& weight : weights)
+  {
+    if (kept > 0 && weights[kept - 1].first == weight.first) weights[kept - 1] = weight;
+    else
+      weights[kept++] = weight;
+  }
+  weights.resize(kept);
+  weights.erase(std::remove_if(weights.begin(), weights.end(),
+                    [](const std::pair<uint64_t, float>& weight) { return weight.second == 0.f; }),
+      weights.end());
+
+  std::vector<uint64_t> indices;
+  indices.reserve(weights.size());
+  for (size_t group = 0; group < weights.size(); group += group_weights)
+  {
+    const size_t group_end = std::min(group + group_weights, weights.size());
+    float largest = 0.f;
+    for (size_t i = group; i < group_end; i++) largest = std::max(largest, std::fabs(weights[i].second));
+    const float scale = _quantization == weight_quantization::int8 ? largest / 127.f : largest;
+    _scales.push_back(scale);
+
+    for (size_t i = group; i < group_end; i++)
+    {
+      const float relative = weights[i].second / scale;
+      indices.push_back(weights[i].first);
+      if (_quantization == weight_quantization::int8)
+        _int8_values.push_back(static_cast<int8_t>(std::lround(relative)));
+      else
+        _fp16_values.push_back(internal::float_to_half(relative));
+    }
+  }
+  index(indices);
+
+  for (const auto& weight : weights)
+    _max_error = std::max(_max_error, std::fabs((*this)[weight.first] - weight.second));
+}
+
+// model_magic, the quantization (uint8_t) and the number of weights (uint64_t), then the weights by group: the scale
+// (float), then for every weight the distance of its index to the one after the index before (a varint) and its value
+// (int8_t or a uint16_t holding a half).
+void quantized_weights::write(std::vector<char>& out) const
+{
+  out.insert(out.end(), model_magic, model_magic + sizeof(model_magic));
+  write_bytes(out, static_cast<uint8_t>(_quantization));
+  write_bytes(out, static_cast<uint64_t>(size()));
+
+  uint64_t next_index = 0;
+  for_each_position([&](uint64_t index, size_t position) {
+    if (position % group_weights == 0) write_bytes(out, _scales[position / group_weights]);
+    write_varint(out, index - next_index);
+    next_index = index + 1;
+    if (_quantization == weight_quantization::int8) write_bytes(out, _int8_values[position]);
+    else
+      write_bytes(out, _fp16_values[position]);
+  });
+}
+
+int quantized_weights::read(model_parser& mp)
+{
+  // weights are excluded from checksum calculation
+  const char* magic;
+  RETURN_ON_FAIL(mp.read("quantized.magic", sizeof(model_magic), &magic));
+  if (memcmp(magic, model_magic, sizeof(model_magic)) != 0) return E_VW_PREDICT_ERR_INVALID_MODEL;
+
+  uint8_t quantization;
+  RETURN_ON_FAIL((mp.read<uint8_t, false>("quantized.quantization", quantization)));
+  if (quantization != static_cast<uint8_t>(weight_quantization::int8) &&
+      quantization != static_cast<uint8_t>(weight_quantization::fp16))
+    return E_VW_PREDICT_ERR_INVALID_MODEL;
+  _quantization = static_cast<weight_quantization>(quantization);
+
+  uint64_t count;
+  RETURN_ON_FAIL((mp.read<uint64_t, false>("quantized.count", count)));
+  if (count > _weight_mask + 1) return E_VW_PREDICT_ERR_INVALID_MODEL;
+
+  clear();
+  std::vector<uint64_t> indices;
+  uint64_t next_index = 0;
+  for (uint64_t i = 0; i < count; i++)
+  {
+    if (i % group_weights == 0)
+    {
+      float scale;
+      RETURN_ON_FAIL((mp.read<float, false>("quantized.scale", scale)));
+      _scales.push_back(scale);
+    }
+
+    uint64_t distance;
+    RETURN_ON_FAIL(read_varint(mp, distance));
+    if (next_index > _weight_mask || distance > _weight_mask - next_index)
+      return E_VW_PREDICT_ERR_WEIGHT_INDEX_OUT_OF_RANGE;
+    indices.push_back(next_index + distance);
+    next_index = indices.back() + 1;
+
+    if (_quantization == weight_quantization::int8)
+    {
+      int8_t value;
+      RETURN_ON_FAIL((mp.read<int8_t, false>("quantized.value", value)));
+      _int8_values.push_back(value);
+    }
+    else
+    {
+      uint16_t value;
+      RETURN_ON_FAIL((mp.read<uint16_t, false>("quantized.value", value)));
+      _fp16_values.push_back(value);
+    }
+  }
+  index(indices);
+
+  return mp.at_end() ? S_VW_PREDICT_OK : E_VW_PREDICT_ERR_INVALID_MODEL;
+}
+}  // namespace vw_slim
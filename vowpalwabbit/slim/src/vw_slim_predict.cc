@@ -22,12 +22,23 @@ namespace_copy_guard::namespace_copy_guard(example_predict& ex, unsigned char ns
   }
   else
     _remove_ns = false;
+  _old_size = _ex.feature_space[_ns].size();
+  _old_sum_feat_sq = _ex.feature_space[_ns].sum_feat_sq;
 }
 
 namespace_copy_guard::~namespace_copy_guard()
 {
-  _ex.indices.pop_back();
-  if (_remove_ns) _ex.feature_space[_ns].clear();
+  if (_remove_ns)
+  {
+    _ex.indices.pop_back();
+    _ex.feature_space[_ns].clear();
+  }
+  else
+  {
+    // only take out the features pushed into a namespace the example has
+    _ex.feature_space[_ns].truncate_to(_old_size);
+    _ex.feature_space[_ns].sum_feat_sq = _old_sum_feat_sq;
+  }
 }
 
 void namespace_copy_guard::feature_push_back(feature_value v, feature_index idx)
@@ -57,4 +68,24 @@ stride_shift_guard::~stride_shift_guard()
       for (auto& f : _ex.feature_space[ns]) f.index() >>= _shift;
 }
 
+int quantize_model(const char* model, size_t length, weight_quantization quantization, std::vector<char>& out,
+    float* max_error)
+{
+  // loading checks the model and quantizes its weights
+  vw_predict<quantized_weights> vw;
+  vw.quantize_on_load(quantization);
+  RETURN_ON_FAIL(vw.load(model, length));
+
+  model_parser mp(model + vw._weights_offset, length - vw._weights_offset);
+  if (mp.starts_with(quantized_weights::model_magic, sizeof(quantized_weights::model_magic)))
+    return E_VW_PREDICT_ERR_MODEL_ALREADY_QUANTIZED;
+
+  // all but the weights stays as it is, including the checksum
+  out.assign(model, model + vw._weights_offset);
+  vw._weights->write(out);
+  if (max_error != nullptr) *max_error = vw._weights->max_error();
+
+  return S_VW_PREDICT_OK;
+}
+
 };  // namespace vw_slim
\ No newline at end of file
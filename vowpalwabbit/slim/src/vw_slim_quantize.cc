@@ -0,0 +1,72 @@
+// Quantizes the weights of a model saved by vw for the slim predictor, see vw_slim::quantize_model.
+//
+//   vw-slim-quantize <model> <quantized model> [int8|fp16]
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "vw_slim_predict.h"
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3 || argc > 4)
+  {
+    std::cerr << "usage: " << argv[0] << " <model> <quantized model> [int8|fp16]" << std::endl;
+    return 1;
+  }
+
+  auto quantization = vw_slim::weight_quantization::int8;
+  if (argc == 4)
+  {
+    if (!strcmp(argv[3], "fp16")) quantization = vw_slim::weight_quantization::fp16;
+    else if (strcmp(argv[3], "int8") != 0)
+    {
+      std::cerr << "unknown quantization '" << argv[3] << "', expected int8 or fp16" << std::endl;
+      return 1;
+    }
+  }
+
+  std::ifstream input(argv[1], std::ios::binary);
+  if (!input)
+  {
+    std::cerr << "cannot open " << argv[1] << std::endl;
+    return 1;
+  }
+  const std::vector<char> model((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+  std::vector<char> quantized;
+  float max_error = 0.f;
+  int result = vw_slim::quantize_model(model.data(), model.size(), quantization, quantized, &max_error);
+  if (result != S_VW_PREDICT_OK)
+  {
+    std::cerr << "cannot quantize " << argv[1] << ", error " << result << std::endl;
+    return 1;
+  }
+
+  std::ofstream output(argv[2], std::ios::binary);
+  output.write(quantized.data(), quantized.size());
+  if (!output)
+  {
+    std::cerr << "cannot write " << argv[2] << std::endl;
+    return 1;
+  }
+
+  // what the predictor holds in memory for the weights, as floats and quantized
+  vw_slim::vw_predict<vw_slim::quantized_weights> vw;
+  result = vw.load(quantized.data(), quantized.size());
+  if (result != S_VW_PREDICT_OK)
+  {
+    std::cerr << "cannot load the quantized model, error " << result << std::endl;
+    return 1;
+  }
+  const uint64_t float_bytes = (static_cast<uint64_t>(1) << vw.feature_index_num_bits()) * sizeof(float);
+
+  std::cout << "model bytes: " << model.size() << " -> " << quantized.size() << std::endl
+            << "weight memory bytes: " << float_bytes << " -> " << vw.weights().memory_bytes() << std::endl
+            << "weights: " << vw.weights().size() << std::endl
+            << "largest weight error: " << max_error << std::endl;
+  return 0;
+}
@@ -7,7 +7,10 @@
 #include <set>
 #include <stdlib.h>
 #include <streambuf>
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <iterator>
 
 #include <fstream>
 #include "example_predict_builder.h"
@@ -93,38 +96,40 @@ test_data get_test_data(const char* model_filename)
   return td;
 }
 
+// With a quantization, the model is quantized by quantize_model first and the predictions only need to be within
+// tolerance of those of the float weights.
 template <typename W>
-void run_predict_in_memory(
-    const char* model_filename, const char* data_filename, const char* prediction_reference_filename)
+void run_predict_in_memory(const char* model_filename, const char* data_filename,
+    const char* prediction_reference_filename, const weight_quantization* quantization = nullptr,
+    float tolerance = 1e-5f)
 {
   std::vector<float> preds;
 
   vw_predict<W> vw;
   // if files would be available
   test_data td = get_test_data(model_filename);
-  ASSERT_EQ(S_VW_PREDICT_OK, vw.load((const char*)td.model, td.model_len));
+  std::vector<char> model(td.model, td.model + td.model_len);
+  if (quantization != nullptr)
+  {
+    std::vector<char> quantized;
+    ASSERT_EQ(S_VW_PREDICT_OK, quantize_model(model.data(), model.size(), *quantization, quantized));
+    model.swap(quantized);
+  }
+  ASSERT_EQ(S_VW_PREDICT_OK, vw.load(model.data(), model.size()));
   EXPECT_FALSE(vw.is_cb_explore_adf());
 
-  float score;
+  safe_example_predict ex[2];
   if (!strcmp(data_filename, "regression_data_1.txt"))
   {
-    safe_example_predict ex[2];
     // 1 |0 0:1
     example_predict_builder b0(&ex[0], (namespace_index)0);
     b0.push_feature(0, 1.f);
     // 1 |0 0:5
     example_predict_builder b1(&ex[1], (namespace_index)0);
     b1.push_feature(0, 5.f);
-
-    for (auto& e : ex)
-    {
-      ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(e, score));
-      preds.push_back(score);
-    }
   }
   else if (!strcmp(data_filename, "regression_data_2.txt"))
   {
-    safe_example_predict ex[2];
     // 1 |0 0:1 |a 0:2
     example_predict_builder b00(&ex[0], (namespace_index)0);
     b00.push_feature(0, 1.f);
@@ -133,16 +138,9 @@ void run_predict_in_memory(
     // 0 |c 0:3
     example_predict_builder b1(&ex[1], "c");
     b1.push_feature(0, 3.f);
-
-    for (auto& e : ex)
-    {
-      ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(e, score));
-      preds.push_back(score);
-    }
   }
   else if (!strcmp(data_filename, "regression_data_3.txt"))
   {
-    safe_example_predict ex[2];
     // 1 |a 0:1 |b 2:2
     example_predict_builder b0a(&ex[0], "a");
     b0a.push_feature(0, 1.f);
@@ -153,16 +151,9 @@ void run_predict_in_memory(
     b1a.push_feature(0, 1.f);
     example_predict_builder b1b(&ex[1], "b");
     b1b.push_feature(2, 4.f);
-
-    for (auto& e : ex)
-    {
-      ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(e, score));
-      preds.push_back(score);
-    }
   }
   else if (!strcmp(data_filename, "regression_data_4.txt"))
   {
-    safe_example_predict ex[2];
     // 1 |a 0:1 |b 2:2 |c 3:3 |d 4:4
     example_predict_builder b0a(&ex[0], "a");
     b0a.push_feature(0, 1.f);
@@ -181,16 +172,9 @@ void run_predict_in_memory(
     b1c.push_feature(3, 1.f);
     example_predict_builder b1d(&ex[1], "d");
     b1d.push_feature(1, 2.f);
-
-    for (auto& e : ex)
-    {
-      ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(e, score));
-      preds.push_back(score);
-    }
   }
   else if (!strcmp(data_filename, "regression_data_7.txt"))
   {
-    safe_example_predict ex[2];
     // 1 |a x:1 |b y:2
     example_predict_builder b0a(&ex[0], "a");
     b0a.push_feature_string("x", 1.f);
@@ -201,27 +185,35 @@ void run_predict_in_memory(
     b1a.push_feature_string("x", 1.f);
     example_predict_builder b1b(&ex[1], 5);
     b1b.push_feature_string("y", 4.f);
-
-    for (auto& e : ex)
-    {
-      ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(e, score));
-      preds.push_back(score);
-    }
   }
   else
     FAIL() << "Unknown data file: " << data_filename;
 
+  float score;
+  for (auto& e : ex)
+  {
+    ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(e, score));
+    preds.push_back(score);
+  }
+
+  // scored together, the examples get the same predictions
+  std::vector<float> batch_preds;
+  ASSERT_EQ(S_VW_PREDICT_OK, vw.predict_batch(ex, 2, batch_preds));
+  EXPECT_THAT(batch_preds, Pointwise(FloatNearPointwise(1e-6f), preds));
+
   // compare output
   std::vector<float> preds_expected = read_floats(td.pred, td.pred_len);
 
-  EXPECT_THAT(preds, Pointwise(FloatNearPointwise(1e-5f), preds_expected));
+  EXPECT_THAT(preds, Pointwise(FloatNearPointwise(tolerance), preds_expected));
 }
 
 enum PredictParamWeightType
 {
   All,
   Sparse,
-  Dense
+  Dense,
+  QuantizedInt8,
+  QuantizedFp16
 };
 
 struct PredictParam
@@ -235,8 +227,8 @@ struct PredictParam
 // nice rendering in unit tests
 ::std::ostream& operator<<(::std::ostream& os, const PredictParam& param)
 {
-  return os << param.model_filename << " " << param.data_filename << " "
-            << (param.weight_type == PredictParamWeightType::Sparse ? "sparse" : "dense");
+  const char* weight_types[] = {"all", "sparse", "dense", "int8", "fp16"};
+  return os << param.model_filename << " " << param.data_filename << " " << weight_types[param.weight_type];
 }
 
 class PredictTest : public ::testing::TestWithParam<PredictParam>
@@ -245,12 +237,29 @@ class PredictTest : public ::testing::TestWithParam<PredictParam>
 
 TEST_P(PredictTest, Run)
 {
-  if (GetParam().weight_type == PredictParamWeightType::Sparse)
-    run_predict_in_memory<sparse_parameters>(
-        GetParam().model_filename, GetParam().data_filename, GetParam().prediction_reference_filename);
-  else
-    run_predict_in_memory<dense_parameters>(
-        GetParam().model_filename, GetParam().data_filename, GetParam().prediction_reference_filename);
+  const weight_quantization int8 = weight_quantization::int8;
+  const weight_quantization fp16 = weight_quantization::fp16;
+  switch (GetParam().weight_type)
+  {
+    case PredictParamWeightType::Sparse:
+      run_predict_in_memory<sparse_parameters>(
+          GetParam().model_filename, GetParam().data_filename, GetParam().prediction_reference_filename);
+      break;
+    case PredictParamWeightType::Dense:
+      run_predict_in_memory<dense_parameters>(
+          GetParam().model_filename, GetParam().data_filename, GetParam().prediction_reference_filename);
+      break;
+    case PredictParamWeightType::QuantizedInt8:
+      run_predict_in_memory<quantized_weights>(GetParam().model_filename, GetParam().data_filename,
+          GetParam().prediction_reference_filename, &int8, 2e-2f);
+      break;
+    case PredictParamWeightType::QuantizedFp16:
+      run_predict_in_memory<quantized_weights>(GetParam().model_filename, GetParam().data_filename,
+          GetParam().prediction_reference_filename, &fp16, 1e-3f);
+      break;
+    default:
+      FAIL() << "Unknown weight type: " << GetParam().weight_type;
+  }
 }
 
 std::vector<PredictParam> GenerateTestParams()
@@ -268,6 +277,8 @@ std::vector<PredictParam> GenerateTestParams()
       {"regression_data_4", "regression_data_4.txt", "regression_data_4.pred", PredictParamWeightType::All},
       {"regression_data_5", "regression_data_4.txt", "regression_data_5.pred", PredictParamWeightType::All},
       {"regression_data_6", "regression_data_3.txt", "regression_data_6.pred", PredictParamWeightType::Sparse},
+      {"regression_data_6", "regression_data_3.txt", "regression_data_6.pred", PredictParamWeightType::QuantizedInt8},
+      {"regression_data_6", "regression_data_3.txt", "regression_data_6.pred", PredictParamWeightType::QuantizedFp16},
       {"regression_data_7", "regression_data_7.txt", "regression_data_7.pred", PredictParamWeightType::All}};
 
   for (int i = 0; i < sizeof(predict_params) / sizeof(PredictParam); i++)
@@ -277,7 +288,7 @@ std::vector<PredictParam> GenerateTestParams()
       fixtures.push_back(p);
     else
     {
-      for (int weight_type = PredictParamWeightType::Sparse; weight_type <= PredictParamWeightType::Dense;
+      for (int weight_type = PredictParamWeightType::Sparse; weight_type <= PredictParamWeightType::QuantizedFp16;
            weight_type++)
       {
         p.weight_type = static_cast<PredictParamWeightType>(weight_type);
@@ -429,6 +440,56 @@ TEST(VowpalWabbitSlim, multiclass_data_5)
   EXPECT_THAT(out_scores, Pointwise(FloatNearPointwise(1e-5f), preds_expected));
 }
 
+TEST(VowpalWabbitSlim, multiclass_data_5_batch)
+{
+  vw_predict<sparse_parameters> vw;
+  test_data td = get_test_data("multiclass_data_5");
+  ASSERT_EQ(0, vw.load((const char*)td.model, td.model_len));
+
+  // the actions of multiclass_data_5 in two action sets, with the same shared features
+  safe_example_predict shared[2];
+  for (auto& s : shared)
+  {
+    // shared |aa 0:1 5:12
+    example_predict_builder bs(&s, "aa");
+    bs.push_feature(0, 1.f);
+    bs.push_feature(5, 12.f);
+  }
+
+  safe_example_predict ex[8];
+  for (size_t i = 0; i < 8; i++)
+  {
+    // |ab 0:1, |ab 0:2, |ab 0:3, |ab 0:1, then the same in |ac
+    example_predict_builder b(&ex[i], i < 4 ? "ab" : "ac");
+    b.push_feature(0, static_cast<float>(i % 4 == 3 ? 1 : i % 4 + 1));
+  }
+
+  std::vector<float> out_scores;
+  ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(shared[0], ex, 8, out_scores));
+
+  example_predict* actions[] = {ex, ex + 4};
+  const size_t num_actions[] = {4, 4};
+  std::vector<std::vector<float>> batch_scores;
+  ASSERT_EQ(S_VW_PREDICT_OK, vw.predict_batch(shared, actions, num_actions, 2, batch_scores));
+  ASSERT_EQ(2, batch_scores.size());
+  EXPECT_THAT(batch_scores[0],
+      Pointwise(FloatNearPointwise(1e-6f), std::vector<float>(out_scores.begin(), out_scores.begin() + 4)));
+  EXPECT_THAT(batch_scores[1],
+      Pointwise(FloatNearPointwise(1e-6f), std::vector<float>(out_scores.begin() + 4, out_scores.end())));
+
+  // the shared features are taken out of the actions again
+  for (auto& e : ex)
+  {
+    ASSERT_EQ(1, e.indices.size());
+    EXPECT_EQ(1, e.feature_space[e.indices[0]].size());
+  }
+
+  // scoring again reuses the output
+  ASSERT_EQ(S_VW_PREDICT_OK, vw.predict_batch(shared, actions, num_actions, 2, batch_scores));
+  EXPECT_THAT(batch_scores[1],
+      Pointwise(FloatNearPointwise(1e-6f), std::vector<float>(out_scores.begin() + 4, out_scores.end())));
+}
+
 void cb_data_epsilon_0_skype_jb_test_runner(int call_type, int modality, int network_type, int platform,
     std::vector<int> ranking_expected, std::vector<float> pdf_expected)
 {
@@ -707,6 +768,8 @@ TYPED_TEST_P(VwSlimTest, model_not_loaded)
   example_predict ex;
   example_predict* actions = nullptr;
   std::vector<float> scores;
+  const size_t num_actions = 0;
+  std::vector<std::vector<float>> batch_scores;
   std::vector<int> ranking;
   float score;
 
@@ -714,6 +777,8 @@ TYPED_TEST_P(VwSlimTest, model_not_loaded)
 
   EXPECT_EQ(E_VW_PREDICT_ERR_NO_MODEL_LOADED, vw.predict(ex, actions, 0, scores));
   EXPECT_EQ(E_VW_PREDICT_ERR_NO_MODEL_LOADED, vw.predict("abc", ex, actions, 0, scores, ranking));
+  EXPECT_EQ(E_VW_PREDICT_ERR_NO_MODEL_LOADED, vw.predict_batch(&ex, 1, scores));
+  EXPECT_EQ(E_VW_PREDICT_ERR_NO_MODEL_LOADED, vw.predict_batch(&ex, &actions, &num_actions, 1, batch_scores));
 }
 
 TYPED_TEST_P(VwSlimTest, model_reduction_mismatch)
@@ -722,12 +787,15 @@ TYPED_TEST_P(VwSlimTest, model_reduction_mismatch)
   example_predict ex;
   example_predict* actions = nullptr;
   std::vector<float> scores;
+  const size_t num_actions = 0;
+  std::vector<std::vector<float>> batch_scores;
   std::vector<int> ranking;
 
   test_data td = get_test_data("regression_data_1");
   ASSERT_EQ(0, vw.load((const char*)td.model, td.model_len));
 
   EXPECT_EQ(E_VW_PREDICT_ERR_NO_A_CSOAA_MODEL, vw.predict(ex, actions, 0, scores));
+  EXPECT_EQ(E_VW_PREDICT_ERR_NO_A_CSOAA_MODEL, vw.predict_batch(&ex, &actions, &num_actions, 1, batch_scores));
   EXPECT_EQ(E_VW_PREDICT_ERR_NOT_A_CB_MODEL, vw.predict("abc", ex, actions, 0, scores, ranking));
 }
 
@@ -796,4 +864,128 @@ TEST(ColdStartModel, action_set_not_reordered)
   EXPECT_GT(pdfs[0], 0.8);
   EXPECT_GT(pdfs[0], pdfs[1]);
   EXPECT_THAT(rankings, ElementsAre(0, 1, 2, 3, 4));
-}
\ No newline at end of file
+}
+TEST(QuantizedWeights, half_precision)
+{
+  for (float value : {0.f, 1.f, -1.f, 0.5f, 0.333333f, -0.0001f, 6.1e-5f, 3e-8f, 65504.f})
+  {
+    const float converted = vw_slim::internal::half_to_float(vw_slim::internal::float_to_half(value));
+    EXPECT_NEAR(value, converted, std::fabs(value) / 1024 + 3e-8f) << value;
+  }
+  EXPECT_EQ(0x3c00, vw_slim::internal::float_to_half(1.f));
+  EXPECT_EQ(0x3555, vw_slim::internal::float_to_half(0.333333f));
+  EXPECT_EQ(0x7c00, vw_slim::internal::float_to_half(1e6f));
+}
+
+TEST(QuantizedWeights, lookup)
+{
+  for (uint32_t num_bits : {10, 40})
+  {
+    quantized_weights weights(static_cast<size_t>(1) << num_bits);
+    // repeated indices keep their last value, zeros are not stored
+    weights.quantize({{5, 1.f}, {3, -0.5f}, {5, 2.f}, {1000, 0.f}, {700, 0.25f}, {64, 1e-3f}});
+    EXPECT_EQ(4, weights.size());
+    EXPECT_NEAR(2.f, weights[5], 1e-6f);
+    EXPECT_NEAR(-0.5f, weights[3], weights.max_error());
+    EXPECT_NEAR(0.25f, weights[700], weights.max_error());
+    EXPECT_EQ(0.f, weights[64]);  // too small next to 2 in 8 bits
+    EXPECT_EQ(0.f, weights[1000]);
+    EXPECT_EQ(0.f, weights[4]);
+    EXPECT_LE(weights.max_error(), 2.f / 254);
+
+    std::vector<std::pair<uint64_t, float>> stored;
+    weights.for_each([&stored](uint64_t index, float value) { stored.emplace_back(index, value); });
+    ASSERT_EQ(4, stored.size());
+    EXPECT_EQ(3, stored[0].first);
+    EXPECT_EQ(5, stored[1].first);
+    EXPECT_EQ(64, stored[2].first);
+    EXPECT_EQ(700, stored[3].first);
+  }
+
+  // a handful of weights among 2^40 indices are looked up in a hash table of their blocks
+  quantized_weights sparse(static_cast<size_t>(1) << 40);
+  sparse.quantize({{1, 1.f}, {static_cast<uint64_t>(1) << 39, 2.f}});
+  EXPECT_LT(sparse.memory_bytes(), 256);
+  EXPECT_NEAR(2.f, sparse[static_cast<uint64_t>(1) << 39], 1e-6f);
+}
+
+std::vector<char> read_model_file(const char* file_name)
+{
+  std::ifstream input(file_name, std::ios::in | std::ios::binary);
+  return std::vector<char>((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+}
+
+TEST(QuantizedWeights, quantize_model)
+{
+  const auto model = read_model_file("data/Delay_Margin_AudioNetworkPCR_all_cb_FF8.model");
+  ASSERT_FALSE(model.empty());
+
+  vw_predict<sparse_parameters> float_vw;
+  ASSERT_EQ(S_VW_PREDICT_OK, float_vw.load(model.data(), model.size()));
+
+  safe_example_predict shared;
+  vw_slim::example_predict_builder features(&shared, "Features", float_vw.feature_index_num_bits());
+  features.push_feature_string("Networkmobile", 1.f);
+  features.push_feature_string("CallTypeP2P", 1.f);
+  features.push_feature_string("PlatformAndroid", 1.f);
+  features.push_feature_string("MediaTypeVideo", 1.f);
+  safe_example_predict actions[10];
+  for (int i = 0; i < 10; i++)
+  {
+    vw_slim::example_predict_builder action(&actions[i], "80");
+    action.push_feature(i, 1.f);
+  }
+  std::vector<float> float_scores;
+  ASSERT_EQ(S_VW_PREDICT_OK, float_vw.predict(shared, actions, 10, float_scores));
+
+  for (auto quantization : {weight_quantization::int8, weight_quantization::fp16})
+  {
+    std::vector<char> quantized;
+    float max_error;
+    ASSERT_EQ(S_VW_PREDICT_OK, quantize_model(model.data(), model.size(), quantization, quantized, &max_error));
+    // 389 weights among 2^24 indices: their indices take about 3 bytes each, instead of 4 plus 4 for the value
+    if (quantization == weight_quantization::int8) EXPECT_LT(quantized.size() * 2, model.size());
+    else
+      EXPECT_LT(quantized.size() * 3, model.size() * 2);
+
+    vw_predict<quantized_weights> vw;
+    ASSERT_EQ(S_VW_PREDICT_OK, vw.load(quantized.data(), quantized.size()));
+    EXPECT_EQ(quantization, vw.weights().quantization());
+    EXPECT_LT(vw.weights().memory_bytes() * 1000, (static_cast<size_t>(1) << vw.feature_index_num_bits()) * 4);
+    std::vector<float> scores;
+    ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(shared, actions, 10, scores));
+    const float tolerance = quantization == weight_quantization::int8 ? 2e-2f : 1e-3f;
+    EXPECT_THAT(scores, Pointwise(FloatNearPointwise(tolerance), float_scores));
+    EXPECT_LT(max_error, tolerance);
+
+    // the float weights loaded from the quantized model are the same
+    vw_predict<dense_parameters> dense_vw;
+    ASSERT_EQ(S_VW_PREDICT_OK, dense_vw.load(quantized.data(), quantized.size()));
+    std::vector<float> dense_scores;
+    ASSERT_EQ(S_VW_PREDICT_OK, dense_vw.predict(shared, actions, 10, dense_scores));
+    EXPECT_THAT(dense_scores, Pointwise(FloatNearPointwise(1e-6f), scores));
+
+    // quantizing on load gives the same weights
+    vw_predict<quantized_weights> on_load_vw;
+    on_load_vw.quantize_on_load(quantization);
+    ASSERT_EQ(S_VW_PREDICT_OK, on_load_vw.load(model.data(), model.size()));
+    std::vector<float> on_load_scores;
+    ASSERT_EQ(S_VW_PREDICT_OK, on_load_vw.predict(shared, actions, 10, on_load_scores));
+    EXPECT_EQ(on_load_scores, scores);
+
+    std::vector<char> twice;
+    EXPECT_EQ(E_VW_PREDICT_ERR_MODEL_ALREADY_QUANTIZED,
+        quantize_model(quantized.data(), quantized.size(), quantization, twice));
+
+    // a quantized model cut anywhere but right before its weights does not load
+    const size_t weights_offset =
+        std::search(quantized.begin(), quantized.end(), quantized_weights::model_magic,
+            quantized_weights::model_magic + sizeof(quantized_weights::model_magic)) -
+        quantized.begin();
+    for (size_t end = 0; end < quantized.size(); end++)
+    {
+      if (end == weights_offset) continue;
+      EXPECT_NE(S_VW_PREDICT_OK, vw.load(quantized.data(), end)) << "quantized model read until " << end;
+    }
+  }
+}
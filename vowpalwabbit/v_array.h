@@ -43,12 +43,13 @@ private:
     if (_begin != nullptr)
     {
       for (iterator item = _begin; item != _end; ++item) { item->~T(); }
-      free(_begin);
+      if (!_borrowed) { free(_begin); }
     }
     _begin = nullptr;
     _end = nullptr;
     _end_array = nullptr;
     _erase_count = 0;
+    _borrowed = false;
   }
 
   void reserve_nocheck(size_t length)
@@ -56,12 +57,16 @@ private:
     if (capacity() == length || length == 0) { return; }
     const size_t old_len = size();
 
-    T* temp = reinterpret_cast<T*>(std::realloc(_begin, sizeof(T) * length));
+    // Borrowed storage cannot be realloc'ed, the elements move to memory of our own instead.
+    T* temp = _borrowed ? reinterpret_cast<T*>(std::malloc(sizeof(T) * length))
+                        : reinterpret_cast<T*>(std::realloc(_begin, sizeof(T) * length));
     if (temp == nullptr)
     { THROW_OR_RETURN("realloc of " << length << " failed in reserve_nocheck().  out of memory?"); }
     else
     {
+      if (_borrowed) { std::memcpy(temp, _begin, sizeof(T) * std::min(old_len, length)); }
       _begin = temp;
+      _borrowed = false;
     }
 
     _end = _begin + std::min(old_len, length);
@@ -72,8 +77,8 @@ private:
   // This will move all elements after idx by width positions and reallocate the underlying buffer if needed.
   void make_space_at(size_t idx, size_t width)
   {
-    _end += width;
     if (size() + width > capacity()) { reserve(2 * capacity() + width); }
+    _end += width;
     memmove(&_begin[idx + width], &_begin[idx], (size() - (idx + width)) * sizeof(T));
   }
 
@@ -96,6 +101,7 @@ private:
   T* _end;
   T* _end_array;
   size_t _erase_count;
+  bool _borrowed;  // The buffer belongs to someone else, see use_storage.
 
 public:
   using value_type = T;
@@ -119,7 +125,7 @@ public:
   inline const_iterator cbegin() const noexcept { return _begin; }
   inline const_iterator cend() const noexcept { return _end; }
 
-  v_array() noexcept : _begin(nullptr), _end(nullptr), _end_array(nullptr), _erase_count(0) {}
+  v_array() noexcept : _begin(nullptr), _end(nullptr), _end_array(nullptr), _erase_count(0), _borrowed(false) {}
   ~v_array() { delete_v_array(); }
 
   v_array(v_array<T>&& other) noexcept
@@ -128,11 +134,13 @@ public:
     _begin = nullptr;
     _end = nullptr;
     _end_array = nullptr;
+    _borrowed = false;
 
     std::swap(_begin, other._begin);
     std::swap(_end, other._end);
     std::swap(_end_array, other._end_array);
     std::swap(_erase_count, other._erase_count);
+    std::swap(_borrowed, other._borrowed);
   }
 
   v_array<T>& operator=(v_array<T>&& other) noexcept
@@ -141,6 +149,7 @@ public:
     std::swap(_end, other._end);
     std::swap(_end_array, other._end_array);
     std::swap(_erase_count, other._erase_count);
+    std::swap(_borrowed, other._borrowed);
     return *this;
   }
 
@@ -150,6 +159,7 @@ public:
     _end = nullptr;
     _end_array = nullptr;
     _erase_count = 0;
+    _borrowed = false;
 
     copy_into_this(other);
   }
@@ -218,6 +228,7 @@ public:
 
   void shrink_to_fit()
   {
+    if (_borrowed) { return; }
     if (size() < capacity())
     {
       if (empty())
@@ -338,6 +349,30 @@ public:
   VW_DEPRECATED("Use destructor instead. This will be removed in VW 9.0.")
   void delete_v() { delete_v_array(); }
 
+  /// \brief Moves the elements into buffer and keeps them there without taking ownership of it. Growing past capacity
+  /// moves them back into memory of the v_array's own.
+  /// \param buffer Storage for capacity elements, at least size(). Must outlive its use by the v_array.
+  void use_storage(T* buffer, size_t capacity)
+  {
+    assert(capacity >= size());
+    const size_t old_len = size();
+    if (old_len > 0) { std::memcpy(buffer, _begin, sizeof(T) * old_len); }
+    if (!_borrowed) { free(_begin); }
+    _begin = buffer;
+    _end = _begin + old_len;
+    _end_array = _begin + capacity;
+    _borrowed = true;
+    memset(_end, 0, (_end_array - _end) * sizeof(T));
+  }
+
+  /// \brief Drops the elements and the storage given by use_storage, if any. Storage of its own is kept.
+  void release_borrowed_storage()
+  {
+    if (_borrowed) { delete_v_array(); }
+  }
+
+  bool borrows_storage() const { return _borrowed; }
+
   void push_back(const T& new_ele)
   {
     if (_end == _end_array) reserve_nocheck(2 * capacity() + 3);
@@ -120,6 +120,8 @@ void parse_example_label(vw& all, example& ec, std::string label);
 void setup_examples(vw& all, v_array<example*>& examples);
 void setup_example(vw& all, example* ae);
 example* new_unused_example(vw& all);
+// Blocks until the parse thread has an example ready, returns nullptr once parsing is done. Examples arrive in batches
+// which are handed out in order, so this must only be called from one thread.
 example* get_example(parser* pf);
 float get_topic_prediction(example* ec, size_t i);  // i=0 to max topic -1
 float get_label(example* ec);
@@ -0,0 +1,411 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#include "weight_allocation.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "memory.h"
+#include "vw_exception.h"
+
+#ifdef __linux__
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+constexpr size_t default_huge_page_size = static_cast<size_t>(2) << 20;
+constexpr int mpol_interleave = 3;  // MPOL_INTERLEAVE of <numaif.h>, which would need libnuma
+
+size_t round_up(size_t bytes, size_t alignment) { return (bytes + alignment - 1) / alignment * alignment; }
+
+size_t transparent_huge_page_size()
+{
+  size_t size = 0;
+  std::ifstream file("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+  return (file >> size) && size > 0 ? size : default_huge_page_size;
+}
+
+size_t explicit_huge_page_size()
+{
+  std::ifstream meminfo("/proc/meminfo");
+  std::string line;
+  size_t kilobytes = 0;
+  while (std::getline(meminfo, line))
+  {
+    if (sscanf(line.c_str(), "Hugepagesize: %zu kB", &kilobytes) == 1) return kilobytes << 10;
+  }
+  return default_huge_page_size;
+}
+
+// Maps bytes aligned to alignment by mapping alignment more and unmapping the slack on both sides, so that the
+// kernel can back every aligned stretch with a huge page.
+void* map_aligned(size_t bytes, size_t alignment)
+{
+  void* mapping = mmap(nullptr, bytes + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) THROWERRNO("mmap of " << bytes << " bytes of weights failed");
+  auto begin = reinterpret_cast<uintptr_t>(mapping);
+  const auto aligned = round_up(begin, alignment);
+  if (aligned > begin) munmap(mapping, aligned - begin);
+  const auto slack = begin + bytes + alignment - (aligned + bytes);
+  if (slack > 0) munmap(reinterpret_cast<void*>(aligned + bytes), slack);
+  return reinterpret_cast<void*>(aligned);
+}
+
+// The nodes listed in /sys/devices/system/node/online, e.g. "0-1,4", as an mbind nodemask.
+std::vector<unsigned long> online_nodes(size_t& num_nodes)
+{
+  constexpr size_t bits = sizeof(unsigned long) * 8;
+  std::vector<unsigned long> mask;
+  num_nodes = 0;
+  std::ifstream file("/sys/devices/system/node/online");
+  std::string range;
+  while (std::getline(file, range, ','))
+  {
+    unsigned first = 0;
+    unsigned last = 0;
+    const int parsed = sscanf(range.c_str(), "%u-%u", &first, &last);
+    if (parsed < 1) continue;
+    if (parsed == 1) last = first;
+    for (unsigned node = first; node <= last; node++)
+    {
+      if (mask.size() <= node / bits) mask.resize(node / bits + 1, 0);
+      mask[node / bits] |= 1UL << (node % bits);
+      num_nodes++;
+    }
+  }
+  return mask;
+}
+
+void interleave(void* memory, size_t bytes)
+{
+  size_t num_nodes = 0;
+  auto mask = online_nodes(num_nodes);
+  if (num_nodes < 2) return;
+  const auto max_node = mask.size() * sizeof(unsigned long) * 8 + 1;
+  if (syscall(SYS_mbind, memory, bytes, mpol_interleave, mask.data(), max_node, 0) != 0)
+  {
+    const char* msg = "internal warning: interleaving weights over the NUMA nodes failed!\n";
+    fputs(msg, stderr);
+  }
+}
+
+int create_memory_file(size_t bytes)
+{
+#  ifdef SYS_memfd_create
+  const int fd = static_cast<int>(syscall(SYS_memfd_create, "vw_weights", 1U /* MFD_CLOEXEC */));
+#  else
+  const int fd = -1;
+  errno = ENOSYS;
+#  endif
+  if (fd < 0) THROWERRNO("memfd_create for the weights failed");
+  if (ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+  {
+    close(fd);
+    THROWERRNO("ftruncate of the weights file to " << bytes << " bytes failed");
+  }
+  return fd;
+}
+
+void write_all(int fd, const char* data, size_t bytes, size_t offset)
+{
+  while (bytes > 0)
+  {
+    const ssize_t written = pwrite(fd, data, bytes, static_cast<off_t>(offset));
+    if (written < 0 && errno == EINTR) { continue; }
+    if (written <= 0) THROWERRNO("writing " << bytes << " bytes of weights to their file failed");
+    data += written;
+    bytes -= static_cast<size_t>(written);
+    offset += static_cast<size_t>(written);
+  }
+}
+
+// Puts the pages of the copy-on-write mapping of fd at memory which were written since it was mapped into fd. Those
+// are the pages /proc/self/pagemap shows as present but not file pages, or as swapped out. Writes all of them when
+// pagemap cannot be read.
+void write_back_written_pages(char* memory, size_t bytes, int fd)
+{
+  constexpr uint64_t present = static_cast<uint64_t>(1) << 63;
+  constexpr uint64_t swapped = static_cast<uint64_t>(1) << 62;
+  constexpr uint64_t file_page = static_cast<uint64_t>(1) << 61;
+  const auto page_size = static_cast<size_t>(sysconf(_SC_PAGE_SIZE));
+  const int pagemap = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+  if (pagemap < 0)
+  {
+    write_all(fd, memory, bytes, 0);
+    return;
+  }
+
+  const size_t num_pages = bytes / page_size;
+  const size_t first_page = reinterpret_cast<uintptr_t>(memory) / page_size;
+  std::vector<uint64_t> entries(4096);
+  size_t run_begin = 0;
+  size_t run_pages = 0;
+  for (size_t page = 0; page < num_pages; page += entries.size())
+  {
+    const size_t count = std::min(entries.size(), num_pages - page);
+    const auto wanted = static_cast<ssize_t>(count * sizeof(uint64_t));
+    if (pread(pagemap, entries.data(), count * sizeof(uint64_t),
+            static_cast<off_t>((first_page + page) * sizeof(uint64_t))) != wanted)
+    {
+      // Treat the pages as written.
+      std::fill(entries.begin(), entries.begin() + count, present);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+      const uint64_t entry = entries[i];
+      if (((entry & present) != 0 && (entry & file_page) == 0) || (entry & swapped) != 0)
+      {
+        if (run_pages == 0) { run_begin = page + i; }
+        run_pages++;
+        continue;
+      }
+      if (run_pages > 0)
+      {
+        write_all(fd, memory + run_begin * page_size, run_pages * page_size, run_begin * page_size);
+        run_pages = 0;
+      }
+    }
+  }
+  if (run_pages > 0) { write_all(fd, memory + run_begin * page_size, run_pages * page_size, run_begin * page_size); }
+  close(pagemap);
+}
+
+void map_weights(size_t bytes, const VW::weight_allocation& allocation, VW::weight_memory& weights)
+{
+  size_t& mapped_bytes = weights.mapped_bytes;
+  void* memory = nullptr;
+  auto pages = allocation.pages;
+  if (allocation.snapshots)
+  {
+    mapped_bytes = round_up(bytes, static_cast<size_t>(sysconf(_SC_PAGE_SIZE)));
+    weights.snapshot_fd = create_memory_file(mapped_bytes);
+    memory = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, weights.snapshot_fd, 0);
+    if (memory == MAP_FAILED)
+    {
+      close(weights.snapshot_fd);
+      THROWERRNO("mmap of " << mapped_bytes << " bytes of weights failed");
+    }
+  }
+  else if (pages == VW::page_policy::explicit_huge)
+  {
+    mapped_bytes = round_up(bytes, explicit_huge_page_size());
+    memory = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+      const char* msg =
+          "internal warning: not enough huge pages reserved in /proc/sys/vm/nr_hugepages for the weights, using "
+          "transparent huge pages instead!\n";
+      fputs(msg, stderr);
+      memory = nullptr;
+      pages = VW::page_policy::transparent_huge;
+    }
+  }
+
+  if (memory == nullptr && pages == VW::page_policy::transparent_huge)
+  {
+    const auto huge_page_size = transparent_huge_page_size();
+    mapped_bytes = round_up(bytes, huge_page_size);
+    memory = map_aligned(mapped_bytes, huge_page_size);
+    if (madvise(memory, mapped_bytes, MADV_HUGEPAGE) != 0)
+    {
+      const char* msg = "internal warning: marking weights for transparent huge pages failed!\n";
+      fputs(msg, stderr);
+    }
+  }
+  else if (memory == nullptr && pages == VW::page_policy::small)
+  {
+    mapped_bytes = round_up(bytes, static_cast<size_t>(sysconf(_SC_PAGE_SIZE)));
+    memory = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) THROWERRNO("mmap of " << mapped_bytes << " bytes of weights failed");
+  }
+
+  // Anonymous mappings come zeroed and untouched, so the pages are only placed when first written to: after mbind
+  // for interleave, by the training threads for first_touch.
+  if (allocation.numa == VW::numa_policy::interleave) interleave(memory, mapped_bytes);
+  weights.begin = memory;
+}
+#endif
+}  // namespace
+
+namespace VW
+{
+page_policy parse_page_policy(const std::string& name)
+{
+  if (name == "small") return page_policy::small;
+  if (name == "transparent") return page_policy::transparent_huge;
+  if (name == "explicit") return page_policy::explicit_huge;
+  THROW("Unknown huge page policy '" << name << "', expected small, transparent or explicit");
+}
+
+numa_policy parse_numa_policy(const std::string& name)
+{
+  if (name == "none") return numa_policy::none;
+  if (name == "interleave") return numa_policy::interleave;
+  if (name == "first_touch") return numa_policy::first_touch;
+  THROW("Unknown NUMA policy '" << name << "', expected none, interleave or first_touch");
+}
+
+weight_memory allocate_weight_memory(size_t bytes, const weight_allocation& allocation)
+{
+  weight_memory memory;
+#ifdef __linux__
+  // Mapped weights are not marked KSM mergeable, ksmd would split the huge pages again.
+  if (!allocation.is_default() && bytes > 0)
+  {
+    map_weights(bytes, allocation, memory);
+    return memory;
+  }
+#else
+  if (allocation.snapshots) THROW("Weight snapshots are only supported on Linux");
+#endif
+  memory.begin = calloc_mergable_or_throw<char>(bytes);
+  return memory;
+}
+
+void* snapshot_weight_memory(weight_memory& memory, bool copy_on_write, bool file_in_use)
+{
+#ifdef __linux__
+  if (memory.snapshot_fd < 0) THROW("The weights were not allocated for snapshots, see --weight_snapshots");
+  char* weights = static_cast<char*>(memory.begin);
+  if (copy_on_write && file_in_use)
+  {
+    const int fd = create_memory_file(memory.mapped_bytes);
+    try
+    {
+      write_all(fd, weights, memory.mapped_bytes, 0);
+    }
+    catch (...)
+    {
+      close(fd);
+      throw;
+    }
+    close(memory.snapshot_fd);
+    memory.snapshot_fd = fd;
+  }
+  else if (copy_on_write)
+  {
+    write_back_written_pages(weights, memory.mapped_bytes, memory.snapshot_fd);
+  }
+
+  void* frozen = mmap(nullptr, memory.mapped_bytes, PROT_READ, MAP_SHARED, memory.snapshot_fd, 0);
+  if (frozen == MAP_FAILED) THROWERRNO("mmap of a snapshot of " << memory.mapped_bytes << " bytes of weights failed");
+  // Replaces the mapping in place, the weights keep their address and their values.
+  if (mmap(weights, memory.mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, memory.snapshot_fd, 0) ==
+      MAP_FAILED)
+  {
+    munmap(frozen, memory.mapped_bytes);
+    THROWERRNO("mmap of the weights copy-on-write failed");
+  }
+  return frozen;
+#else
+  _UNUSED(memory);
+  _UNUSED(copy_on_write);
+  _UNUSED(file_in_use);
+  THROW("Weight snapshots are only supported on Linux");
+#endif
+}
+
+void* map_weight_file(int fd, uint64_t offset, size_t bytes)
+{
+#ifdef __linux__
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) return nullptr;
+  // Touching a page past the end of the file would raise SIGBUS instead of failing here.
+  if (static_cast<uint64_t>(file_stat.st_size) < offset + bytes)
+  {
+    THROW("Model content is corrupted, the weights end at byte " << offset + bytes << " of a file of "
+                                                                 << file_stat.st_size << " bytes");
+  }
+  void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, static_cast<off_t>(offset));
+  return memory == MAP_FAILED ? nullptr : memory;
+#else
+  _UNUSED(fd);
+  _UNUSED(offset);
+  _UNUSED(bytes);
+  return nullptr;
+#endif
+}
+
+page_report report_pages(const void* address, size_t bytes)
+{
+  page_report report;
+#ifdef __linux__
+  const auto begin = reinterpret_cast<uintptr_t>(address);
+  const auto end = begin + bytes;
+  std::ifstream smaps("/proc/self/smaps");
+  std::string line;
+  bool overlaps = false;
+  size_t anon_huge_bytes = 0;
+  while (std::getline(smaps, line))
+  {
+    uintptr_t first = 0;
+    uintptr_t last = 0;
+    size_t kilobytes = 0;
+    char field[64];
+    // A mapping starts with its address range, its fields follow as "Name:   123 kB".
+    if (sscanf(line.c_str(), "%" SCNxPTR "-%" SCNxPTR " ", &first, &last) == 2)
+    { overlaps = first < end && begin < last; }
+    else if (overlaps && sscanf(line.c_str(), "%63[^:]: %zu kB", field, &kilobytes) == 2)
+    {
+      const size_t value = kilobytes << 10;
+      if (strcmp(field, "KernelPageSize") == 0) { report.page_size = std::max(report.page_size, value); }
+      else if (strcmp(field, "Rss") == 0)
+      {
+        report.resident_bytes += value;
+      }
+      else if (strcmp(field, "AnonHugePages") == 0)
+      {
+        anon_huge_bytes += value;
+      }
+      else if (strcmp(field, "Private_Hugetlb") == 0 || strcmp(field, "Shared_Hugetlb") == 0)
+      {
+        report.resident_bytes += value;
+        report.huge_bytes += value;
+      }
+    }
+  }
+  if (anon_huge_bytes > 0)
+  {
+    report.huge_page_size = transparent_huge_page_size();
+    report.huge_bytes += anon_huge_bytes;
+  }
+  // Neighbouring mappings of the same kind are merged into one, so that they may be counted as well.
+  report.resident_bytes = std::min(report.resident_bytes, bytes);
+  report.huge_bytes = std::min(report.huge_bytes, report.resident_bytes);
+#else
+  _UNUSED(address);
+  _UNUSED(bytes);
+#endif
+  return report;
+}
+
+std::string to_string(const page_report& report)
+{
+  if (report.page_size == 0) return "unknown";
+  std::stringstream text;
+  text << (report.page_size >> 10) << " kB";
+  if (report.huge_page_size > 0 && report.resident_bytes > 0)
+  {
+    text << ", " << (report.huge_page_size >> 10) << " kB huge for " << std::fixed << std::setprecision(1)
+         << 100. * report.huge_bytes / report.resident_bytes << "%";
+  }
+  text << " of " << (report.resident_bytes >> 20) << " MB resident";
+  return text.str();
+}
+}  // namespace VW
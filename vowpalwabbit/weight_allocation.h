@@ -0,0 +1,92 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// How the memory of dense weights is obtained. With the defaults it comes from the heap like any other allocation.
+// Otherwise it is mapped directly, so that it can be backed by huge pages and placed on the NUMA nodes on purpose. A
+// 2^30 entry table takes hundreds of thousands of 4 kB pages and misses the TLB on nearly every weight; with 2 MB
+// pages the page table of the whole table fits in the TLB. Only Linux supports anything but the defaults, elsewhere
+// they are silently used instead.
+namespace VW
+{
+enum class page_policy
+{
+  // Pages of the system page size.
+  small,
+  // madvise(MADV_HUGEPAGE), the kernel backs the weights with huge pages when it finds some.
+  transparent_huge,
+  // mmap(MAP_HUGETLB), huge pages reserved beforehand in /proc/sys/vm/nr_hugepages. Falls back to transparent huge
+  // pages with a warning when there are not enough of them.
+  explicit_huge
+};
+
+enum class numa_policy
+{
+  // Whatever the process policy is, usually the node of the thread touching a page first.
+  none,
+  // Spreads the pages round robin over all nodes, so that threads on every node see the same bandwidth.
+  interleave,
+  // Leaves the weights untouched after allocating them, so that each page lands on the node of the training thread
+  // that writes it first. Only pays off with --hogwild or --train_threads and threads pinned to their nodes.
+  first_touch
+};
+
+struct weight_allocation
+{
+  page_policy pages = page_policy::small;
+  numa_policy numa = numa_policy::none;
+  // Keeps the weights in a memory file, so that dense_parameters::snapshot() can freeze them copy-on-write. Takes
+  // precedence over pages.
+  bool snapshots = false;
+
+  bool is_default() const { return pages == page_policy::small && numa == numa_policy::none && !snapshots; }
+};
+
+struct weight_memory
+{
+  void* begin = nullptr;
+  size_t mapped_bytes = 0;  // size of the mapping to munmap, 0 when begin is to be freed instead
+  int snapshot_fd = -1;  // the memory file mapped with snapshots, -1 without
+};
+
+// Parse the values of --huge_pages and --numa_policy, throwing on anything unknown.
+page_policy parse_page_policy(const std::string& name);
+numa_policy parse_numa_policy(const std::string& name);
+
+// Returns at least bytes of zeroed memory allocated as asked.
+weight_memory allocate_weight_memory(size_t bytes, const weight_allocation& allocation);
+
+// Freezes the weights in the memory file of memory and returns a read-only mapping of it, while memory itself is
+// mapped again copy-on-write at the same address. Only the pages written after that are copied. copy_on_write tells
+// that memory was mapped so by an earlier snapshot: the pages written since are put into the file first, or, when
+// the earlier snapshot still maps the file, all weights are put into a new one. Not thread safe, nothing may write
+// the weights meanwhile.
+void* snapshot_weight_memory(weight_memory& memory, bool copy_on_write, bool file_in_use);
+
+// Maps bytes of the file fd at offset, which has to be a multiple of the page size, copy-on-write as the weights of a
+// flat model, see --flat_model. Pages are read from the file as the weights are used and only copied once written,
+// so processes mapping the same model share the pages they only read. Throws if the file is too short, returns
+// nullptr where files cannot be mapped, munmap the result otherwise.
+void* map_weight_file(int fd, uint64_t offset, size_t bytes);
+
+// The pages the kernel actually backs the memory at address with, as read from /proc/self/smaps.
+struct page_report
+{
+  size_t page_size = 0;  // page size of the mapping, the huge page size for MAP_HUGETLB
+  size_t huge_page_size = 0;  // size of the transparent huge pages, 0 if there are none
+  size_t resident_bytes = 0;  // bytes of the mapping in memory
+  size_t huge_bytes = 0;  // resident bytes backed by huge pages, explicit or transparent
+};
+
+// Sums up the mappings overlapping [address, address + bytes). All zeroes when smaps cannot be read.
+page_report report_pages(const void* address, size_t bytes);
+
+// One line for the finished run statistics, e.g. "4 kB, 2048 kB huge for 97.5% of 512 MB resident".
+std::string to_string(const page_report& report);
+}  // namespace VW